@@ -19,16 +19,18 @@
  */
 
 #include "compute_kernels.h"
+#include "rng.h"
+#include "histogram.h"
+#include "counters.h"
+
+#include <float.h>
 void phase1_compute(const int num_iterations, const int array_size,
     const int block_size, register double temp1, register double temp2,
     register double temp3, register int int_temp1, register int int_temp2,
     register int int_temp3, double *vals, int *int_vals, int validation_phase,
     int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase1_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase1_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals, int *valid_red_int_vals
@@ -48,60 +50,29 @@ void phase1_compute(const int num_iterations, const int array_size,
 #endif
     }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    if ((retval = PAPI_start_counters(papi_info->event_code,
-                                      papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-    }
-  }
-#endif
+    counters_thread_start();
+    /*
+     * Blocks are distributed like a static schedule; each thread runs the
+     * vector kernel over its contiguous range of blocks.
+     */
+    long first, last;
+    simd_thread_range((array_size + block_size - 1) / block_size, &first,
+                      &last);
+    first *= block_size;
+    last = (last * block_size < array_size) ? last * block_size : array_size;
     for (int iter = 0; iter < num_iterations; ++iter) {
-      #pragma omp for simd
-      for (int i = 0; i < array_size; i += block_size) {
-        for (int j = i; j < i + block_size; ++j) {
-          temp1 = vals[j];
-          int_temp1 = int_vals[j];
-          temp1 *= temp1;
-          temp2 = temp1 + vals[j];
-          temp3 = temp2 / (1024 + temp1);
-          temp3 -= vals[j];
-          int_temp1 *= int_temp1;
-          int_temp2 = int_temp1 + int_vals[j];
-          int_temp3 = int_temp2 / (1024 + int_temp1);
-          int_temp3 -= int_vals[j];
-          vals[j] = temp3;
-          int_vals[j] += (int_temp1 + int_temp2 + int_temp3) % 1024;
+      ITER_TIMER_START(t);
+      simd_dispatch.phase1(vals, int_vals, first, last);
 #if RED_VALIDATION
-          valid_red_vals[j] = vals[j];
-          valid_red_int_vals[j] = int_vals[j];
-#endif
-        }
+      for (long j = first; j < last; ++j) {
+        valid_red_vals[j] = vals[j];
+        valid_red_int_vals[j] = int_vals[j];
       }
-    }
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    unsigned long long event_values[papi_info->total_events];
-    memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-    if ((retval = PAPI_stop_counters(event_values,
-                                     papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-    }
-    for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-      printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-      printf("Thread %d %s value = %lld\n", 0,
 #endif
-                                            papi_info->event_code_str[i],
-                                            event_values[i]);
+      ITER_TIMER_STOP(t);
+      #pragma omp barrier
     }
-  }
-#endif
+    counters_thread_stop();
   }
 }
 
@@ -109,10 +80,7 @@ void phase2_compute(const int num_iterations, const int array_size,
     double *dest, double *src1, double *src2, int *ind_src2,
     int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase2_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase2_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
@@ -131,57 +99,27 @@ void phase2_compute(const int num_iterations, const int array_size,
 #endif
     }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    if ((retval = PAPI_start_counters(papi_info->event_code,
-                                      papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-    }
-  }
-#endif
+    counters_thread_start();
     for (int iter = 0; iter < num_iterations; ++iter) {
-      #pragma omp for
+      ITER_TIMER_START(t);
+      #pragma omp for nowait
       for (int i = 0; i < array_size; ++i) {
         dest[i] += src1[i] * src2[ind_src2[i]];
 #if RED_VALIDATION
         valid_red_vals[i] = dest[i];
 #endif
       }
+      ITER_TIMER_STOP(t);
+      #pragma omp barrier
     }
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    unsigned long long event_values[papi_info->total_events];
-    memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-    if ((retval = PAPI_stop_counters(event_values,
-                                     papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-    }
-    for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-      printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-      printf("Thread %d %s value = %lld\n", 0,
-#endif
-                                            papi_info->event_code_str[i],
-                                            event_values[i]);
-    }
-  }
-
-#endif
+    counters_thread_stop();
   }
 }
 
 void phase3_compute(const int num_iterations, const int array_size,
     double *vals, double *reduction_var, int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase3_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase3_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_reduction_var
@@ -201,17 +139,9 @@ void phase3_compute(const int num_iterations, const int array_size,
 #endif
     }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    if ((retval = PAPI_start_counters(papi_info->event_code,
-                                      papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-    }
-  }
-#endif
+    counters_thread_start();
     for (int iter = 0; iter < num_iterations; ++iter) {
+      ITER_TIMER_START(t);
       #pragma omp for reduction(+:tmp_reduction_var)
       for (int i = 0; i < array_size; ++i) {
         vals[i] += 8;
@@ -221,35 +151,17 @@ void phase3_compute(const int num_iterations, const int array_size,
       int tmp_rounding = tmp_reduction_var * 1000000;
       tmp_reduction_var = tmp_rounding  / 1000000;
       *reduction_var = fmod(tmp_reduction_var, 1024);
-      #pragma omp for
+      #pragma omp for nowait
       for (int i = 0; i < array_size; ++i) {
         vals[i] = *reduction_var;
       }
 #if RED_VALIDATION
       *valid_red_reduction_var = *reduction_var;
 #endif
+      ITER_TIMER_STOP(t);
+      #pragma omp barrier
     }
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    unsigned long long event_values[papi_info->total_events];
-    memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-    if ((retval = PAPI_stop_counters(event_values,
-                                     papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-    }
-    for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-      printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-      printf("Thread %d %s value = %lld\n", 0,
-#endif
-                                            papi_info->event_code_str[i],
-                                            event_values[i]);
-    }
-  }
-#endif
+    counters_thread_stop();
   }
 }
 
@@ -257,10 +169,7 @@ void phase4_compute(const int num_iterations, const int array_size,
     double *dest, double *src1, double *src2, int validation_phase,
     int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase4_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase4_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
@@ -279,46 +188,21 @@ void phase4_compute(const int num_iterations, const int array_size,
 #endif
     }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    if ((retval = PAPI_start_counters(papi_info->event_code,
-                                      papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-    }
-  }
-#endif
+    counters_thread_start();
+    long first, last;
+    simd_thread_range(array_size, &first, &last);
     for (int iter = 0; iter < num_iterations; ++iter) {
-      #pragma omp for
-      for (int i = 0; i < array_size; ++i) {
-        dest[i] += src1[i] + src2[i];
+      ITER_TIMER_START(t);
+      simd_dispatch.phase4(dest, src1, src2, first, last);
 #if RED_VALIDATION
+      for (long i = first; i < last; ++i) {
         valid_red_vals[i] = dest[i];
-#endif
       }
-    }
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    unsigned long long event_values[papi_info->total_events];
-    memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-    if ((retval = PAPI_stop_counters(event_values,
-                                     papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-    }
-    for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-      printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-      printf("Thread %d %s value = %lld\n", 0,
 #endif
-                                            papi_info->event_code_str[i],
-                                            event_values[i]);
+      ITER_TIMER_STOP(t);
+      #pragma omp barrier
     }
-  }
-#endif
+    counters_thread_stop();
   }
 }
 
@@ -326,10 +210,7 @@ void phase5_compute(const int num_iterations, const int array_size,
     double *dest, double *src1, double *src2, int *ind_src1, int *ind_src2,
     int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase5_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase5_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
@@ -348,66 +229,36 @@ void phase5_compute(const int num_iterations, const int array_size,
 #endif
     }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    if ((retval = PAPI_start_counters(papi_info->event_code,
-                                      papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-    }
-  }
-#endif
+    counters_thread_start();
     for (int iter = 0; iter < num_iterations; ++iter) {
-      #pragma omp for
+      ITER_TIMER_START(t);
+      #pragma omp for nowait
       for (int i = 0; i < array_size; ++i) {
         dest[i] += src1[ind_src1[i]] + src2[ind_src2[i]];
 #if RED_VALIDATION
         valid_red_vals[i] = dest[i];
 #endif
       }
+      ITER_TIMER_STOP(t);
+      #pragma omp barrier
     }
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    unsigned long long event_values[papi_info->total_events];
-    memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-    if ((retval = PAPI_stop_counters(event_values,
-                                     papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-    }
-    for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-      printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-      printf("Thread %d %s value = %lld\n", 0,
-#endif
-                                            papi_info->event_code_str[i],
-                                            event_values[i]);
-    }
-  }
-#endif
+    counters_thread_stop();
   }
 }
 
-void phase6_compute(const int num_iterations, const int nrow,
-    double **sparse_matrix_values, double *vect_in,
-    int **sparse_matrix_indeces, int *sparse_matrix_nonzeros, double *vect_out,
-    int validation_phase, int num_threads
+void phase6_compute(const int num_iterations, const sparse_matrix *matrix,
+    double *vect_in, double *vect_out, int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase6_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase6_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
 #endif
     ) {
+  const int nrow = matrix->nrow;
+  const int ncol = matrix->ncol;
   #pragma omp parallel if (!validation_phase) num_threads(num_threads) \
-    shared(sparse_matrix_values, sparse_matrix_indeces, sparse_matrix_nonzeros,\
-           vect_in, vect_out)
+    shared(matrix, vect_in, vect_out)
   {
 #if ENABLE_BINDING
     if (bind_to_cpu_set) {
@@ -419,56 +270,110 @@ void phase6_compute(const int num_iterations, const int nrow,
 #endif
     }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    if ((retval = PAPI_start_counters(papi_info->event_code,
-                                      papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-    }
-  }
-#endif
+    counters_thread_start();
     for (int iter = 0; iter < num_iterations/5; ++iter) {
       double reduction_var;
+      ITER_TIMER_START(t);
 
-      #pragma omp for private(reduction_var)
-      for (int i = 0 ; i < nrow; ++i) {
-        reduction_var = 0.0;
-        double * restrict values = sparse_matrix_values[i];
-        int *restrict cols = sparse_matrix_indeces[i];
-        const int nonzeros = sparse_matrix_nonzeros[i];
+      switch (matrix->spec.format) {
+        case SPARSE_CSR: {
+          const long * restrict row_ptr = matrix->row_ptr;
+          const int * restrict cols = matrix->col_idx;
+          const double * restrict values = matrix->values;
 
-        for (int j = 0; j < nonzeros; ++j) {
-          reduction_var += values[j] * vect_in[cols[j]];
+          #pragma omp for private(reduction_var) nowait
+          for (int i = 0 ; i < nrow; ++i) {
+            reduction_var = 0.0;
+            #pragma omp simd reduction(+:reduction_var)
+            for (long j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+              reduction_var += values[j] * vect_in[cols[j]];
+            }
+            vect_out[i] = reduction_var;
+#if RED_VALIDATION
+            valid_red_vals[i] = reduction_var;
+#endif
+          }
+          break;
         }
-        vect_out[i] = reduction_var;
+        case SPARSE_SELL: {
+          /*
+           * Each chunk holds C rows stored column-major, so the C partial
+           * sums of a chunk are updated together, one SIMD lane per row.
+           */
+          const int C = matrix->spec.chunk_size;
+          double sums[C];
+
+          #pragma omp for schedule(static) nowait
+          for (int c = 0; c < matrix->num_chunks; ++c) {
+            const int * restrict cols = matrix->sell_cols +
+                                        matrix->chunk_ptr[c];
+            const double * restrict values = matrix->sell_values +
+                                             matrix->chunk_ptr[c];
+            for (int r = 0; r < C; ++r) {
+              sums[r] = 0.0;
+            }
+            for (int j = 0; j < matrix->chunk_len[c]; ++j) {
+              #pragma omp simd
+              for (int r = 0; r < C; ++r) {
+                sums[r] += values[j * C + r] * vect_in[cols[j * C + r]];
+              }
+            }
+            for (int r = 0; r < C; ++r) {
+              const int row = matrix->row_perm[c * C + r];
+              if (row >= 0) {
+                vect_out[row] = sums[r];
 #if RED_VALIDATION
-        valid_red_vals[i] = reduction_var;
+                valid_red_vals[row] = sums[r];
 #endif
-      }
-    }
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  #pragma omp critical
-  {
-    int retval;
-    unsigned long long event_values[papi_info->total_events];
-    memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-    if ((retval = PAPI_stop_counters(event_values,
-                                     papi_info->total_events)) != PAPI_OK) {
-      printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-    }
-    for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-      printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-      printf("Thread %d %s value = %lld\n", 0,
+              }
+            }
+          }
+          break;
+        }
+        case SPARSE_BELL: {
+          /*
+           * Each block row holds ell_width dense BxB blocks (empty blocks,
+           * marked with a column of -1, are only found at the end).
+           */
+          const int B = matrix->spec.block_size;
+          const int width = matrix->ell_width;
+          double sums[B];
+
+          #pragma omp for schedule(static) private(reduction_var) nowait
+          for (int br = 0; br < matrix->num_block_rows; ++br) {
+            const int * restrict cols = matrix->bell_cols + (long) br * width;
+            for (int r = 0; r < B; ++r) {
+              sums[r] = 0.0;
+            }
+            for (int k = 0; k < width && cols[k] >= 0; ++k) {
+              const double * restrict block = matrix->bell_values +
+                                              ((long) br * width + k) * B * B;
+              const double * restrict x = vect_in + (long) cols[k] * B;
+              const int len = (ncol - cols[k] * B < B) ? ncol - cols[k] * B :
+                                                         B;
+              for (int r = 0; r < B; ++r) {
+                reduction_var = 0.0;
+                #pragma omp simd reduction(+:reduction_var)
+                for (int j = 0; j < len; ++j) {
+                  reduction_var += block[r * B + j] * x[j];
+                }
+                sums[r] += reduction_var;
+              }
+            }
+            for (int r = 0; r < B && br * B + r < nrow; ++r) {
+              vect_out[br * B + r] = sums[r];
+#if RED_VALIDATION
+              valid_red_vals[br * B + r] = sums[r];
 #endif
-                                            papi_info->event_code_str[i],
-                                            event_values[i]);
+            }
+          }
+          break;
+        }
+      }
+      ITER_TIMER_STOP(t);
+      #pragma omp barrier
     }
-  }
-#endif
+    counters_thread_stop();
   }
 }
 
@@ -476,10 +381,7 @@ void phase7_compute(const int num_iterations, const int array_size,
     linked_list **llist,
     int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase7_cpu_id, int bind_to_cpu_set
-#endif
-#if  ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase7_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_reduction_var
@@ -493,7 +395,6 @@ void phase7_compute(const int num_iterations, const int array_size,
 #else
     linked_list *start_node = llist[0];
 #endif
-    linked_list *orig_cur_node = malloc(sizeof(linked_list*));
     linked_list *cur_node;
 #if ENABLE_BINDING
     if (bind_to_cpu_set) {
@@ -505,20 +406,10 @@ void phase7_compute(const int num_iterations, const int array_size,
 #endif
     }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-#pragma omp critical
-    {
-      int retval;
-      if ((retval = PAPI_start_counters(papi_info->event_code,
-          papi_info->total_events)) != PAPI_OK) {
-        printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-      }
-    }
-#endif
+    counters_thread_start();
     for (int iter = 0; iter < num_iterations; ++iter) {
-      cur_node = orig_cur_node;
-      cur_node->value = start_node->value;
-      cur_node->next = start_node->next;
+      ITER_TIMER_START(t);
+      cur_node = start_node;
       while (cur_node != NULL) {
 #if RED_VALIDATION
         if ((iter >= num_iterations - 1) && (cur_node->next == NULL)) {
@@ -527,39 +418,120 @@ void phase7_compute(const int num_iterations, const int array_size,
 #endif
         cur_node = cur_node->next;
       }
+      ITER_TIMER_STOP(t);
     }
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-#pragma omp critical
-    {
-      int retval;
-      unsigned long long event_values[papi_info->total_events];
-      memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-      if ((retval = PAPI_stop_counters(event_values,
-          papi_info->total_events)) != PAPI_OK) {
-        printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-      }
-      for (int i = 0; i < papi_info->total_events; ++i) {
+    counters_thread_stop();
+  }
+}
+
+/*
+ * Latency ladder of phase 7 (-j): each thread follows num_chains of the
+ * independent chains of its list (see init_chains), evenly spaced along the
+ * cycle, for num_steps steps, so that up to num_chains loads are outstanding
+ * at a time. The chains are kept in registers, one case per number of chains.
+ * Returns the sum of the values of the last nodes, so that the loads are not
+ * optimised away.
+ */
+#define PHASE7_CHASE(n) \
+  case n: \
+    for (long s = 0; s < num_steps; ++s) { \
+      for (int c = 0; c < n; ++c) { \
+        chain[c] = chain[c]->next; \
+      } \
+    } \
+    break;
+
+double phase7_chase(const long num_steps, const int num_chains,
+    linked_list **starts, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase7_cpu_id, int bind_to_cpu_set
+#endif
+) {
+  double sum = 0;
+#pragma omp parallel num_threads(num_threads) reduction(+:sum)
+  {
 #ifdef _OPENMP
-        printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
+    linked_list **thread_starts = starts +
+                                  omp_get_thread_num() * LATENCY_MAX_CHAINS;
 #else
-        printf("Thread %d %s value = %lld\n", 0,
+    linked_list **thread_starts = starts;
+#endif
+    linked_list *chain[LATENCY_MAX_CHAINS];
+#if ENABLE_BINDING
+    if (bind_to_cpu_set) {
+      bind_to_cpu_w_reset(phase7_cpu_id, num_cpus, 0);
+    } else {
+#ifdef _OPENMP
+      bind_to_available_cpu_w_reset(phase7_cpu_id, num_cpus, 0,
+                                    omp_get_thread_num());
 #endif
-            papi_info->event_code_str[i],
-            event_values[i]);
-      }
     }
 #endif
+    for (int c = 0; c < num_chains; ++c) {
+      chain[c] = thread_starts[c * (LATENCY_MAX_CHAINS / num_chains)];
+    }
+    switch (num_chains) {
+      PHASE7_CHASE(1)
+      PHASE7_CHASE(2)
+      PHASE7_CHASE(4)
+      PHASE7_CHASE(8)
+      PHASE7_CHASE(16)
+    }
+    for (int c = 0; c < num_chains; ++c) {
+      sum += chain[c]->value;
+    }
   }
+  return sum;
 }
 
-void phase8_compute(const int num_iterations, const int num_particles,
-    particle* restrict particles, double* restrict forces,
-    int validation_phase, int num_threads
+/*
+ * All pairs: the i particles of the thread against tiles of PHASE8_TILE
+ * particles.
+ */
+static void phase8_allpairs(const particle_set *particles, double *forces,
+    long first, long last) {
+  const long num_particles = particles->num_particles;
+  memset(forces + first, 0, sizeof(double) * (last - first));
+  for (long j = 0; j < num_particles; j += PHASE8_TILE) {
+    simd_dispatch.phase8_tile(particles, forces, first, last, j,
+        (j + PHASE8_TILE < num_particles) ? j + PHASE8_TILE : num_particles,
+        DBL_MAX);
+  }
+}
+
+/*
+ * Cell list: the particles of each cell of the thread against those of the 27
+ * surrounding cells. Particles are sorted by cell, so the three cells along x
+ * are contiguous and make a single tile.
+ */
+static void phase8_cells(const particle_set *particles, double *forces,
+    const double cutoff, int first_cell, int last_cell) {
+  const int n = particles->cells_per_dim;
+  const int *cell_start = particles->cell_start;
+  for (int c = first_cell; c < last_cell; ++c) {
+    const int cx = c % n, cy = (c / n) % n, cz = c / (n * n);
+    const int x0 = (cx > 0) ? cx - 1 : cx, x1 = (cx < n - 1) ? cx + 1 : cx;
+    memset(forces + cell_start[c], 0,
+           sizeof(double) * (cell_start[c + 1] - cell_start[c]));
+    for (int z = cz - 1; z <= cz + 1; ++z) {
+      for (int y = cy - 1; y <= cy + 1; ++y) {
+        if (z < 0 || z >= n || y < 0 || y >= n) {
+          continue;
+        }
+        const int row = (z * n + y) * n;
+        simd_dispatch.phase8_tile(particles, forces, cell_start[c],
+            cell_start[c + 1], cell_start[row + x0], cell_start[row + x1 + 1],
+            cutoff * cutoff);
+      }
+    }
+  }
+}
+
+void phase8_compute(const int num_iterations,
+    const particle_set* restrict particles, const phase8_spec *spec,
+    double* restrict forces, int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase8_cpu_id, int bind_to_cpu_set
-#endif
-#if  ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase8_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
@@ -567,13 +539,12 @@ void phase8_compute(const int num_iterations, const int num_particles,
     ) {
   /*
    * This phase does a 3D distance calculation between particles and calculates
-   * the electrostatic force between pairs of points.
+   * the electrostatic force between pairs of points: neighbours in the array,
+   * all pairs, or pairs within a cutoff distance.
    */
-#pragma omp parallel shared(forces) firstprivate(particles) \
+#pragma omp parallel shared(forces, particles, spec) \
   if(!validation_phase) num_threads(num_threads)
   {
-    double k = 8.987551 * 1000000000;
-
 #if ENABLE_BINDING
     if (bind_to_cpu_set) {
       bind_to_cpu_w_reset(phase8_cpu_id, num_cpus, 0);
@@ -584,85 +555,138 @@ void phase8_compute(const int num_iterations, const int num_particles,
 #endif
     }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-#pragma omp critical
-    {
-      int retval;
-      if ((retval = PAPI_start_counters(papi_info->event_code,
-          papi_info->total_events)) != PAPI_OK) {
-        printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-      }
+    counters_thread_start();
+
+    /* Range of particles, and for the cell list range of cells, per thread */
+    const int num_particles = particles->num_particles;
+    long first, last, first_cell = 0, last_cell = 0;
+    if (spec->mode == PHASE8_CELLS) {
+      const int n = particles->cells_per_dim;
+      simd_thread_range(n * n * n, &first_cell, &last_cell);
+      first = particles->cell_start[first_cell];
+      last = particles->cell_start[last_cell];
+    } else if (spec->mode == PHASE8_ALLPAIRS) {
+      simd_thread_range(num_particles, &first, &last);
+    } else {
+      simd_thread_range(num_particles - 1, &first, &last);
     }
-#endif
 
     for (int iter = 0; iter < num_iterations; ++iter) {
-      #pragma omp for simd
-      for (int i = 0; i < num_particles-1; ++i) {
-        double r = (particles[i+1].x - particles[i].x) *
-                   (particles[i+1].x - particles[i].x) +
-                   (particles[i+1].y - particles[i].y) *
-                   (particles[i+1].y - particles[i].y) +
-                   (particles[i+1].z - particles[i].z) *
-                   (particles[i+1].z - particles[i].z);
-
-        forces[i] = (k * particles[i].charge * particles[i+1].charge) / r;
-
+      ITER_TIMER_START(t);
+      switch (spec->mode) {
+        case PHASE8_ALLPAIRS:
+          phase8_allpairs(particles, forces, first, last);
+          break;
+        case PHASE8_CELLS:
+          phase8_cells(particles, forces, spec->cutoff, first_cell,
+                       last_cell);
+          break;
+        default:
+          simd_dispatch.phase8(particles, forces, first, last);
+      }
 #if RED_VALIDATION
+      for (long i = first; i < last; ++i) {
         valid_red_vals[i] = forces[i];
-#endif
-      }
-    }
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-#pragma omp critical
-    {
-      int retval;
-      unsigned long long event_values[papi_info->total_events];
-      memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-      if ((retval = PAPI_stop_counters(event_values,
-          papi_info->total_events)) != PAPI_OK) {
-        printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
       }
-      for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-        printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-        printf("Thread %d %s value = %lld\n", 0,
 #endif
-            papi_info->event_code_str[i],
-            event_values[i]);
-      }
+      ITER_TIMER_STOP(t);
+      #pragma omp barrier
     }
-#endif
+    counters_thread_stop();
   }
 }
 
+/*
+ * Palindromes in increasing order (0, 1, ..., 9, 11, 22, ..., 99, 101, ...)
+ * are enumerated by their first half: a palindrome of length digits is its
+ * half, of (length + 1) / 2 digits, followed by the mirror of the half
+ * (without its last digit when length is odd).
+ */
+typedef struct palindrome_gen {
+  int length;
+  unsigned long half;
+  unsigned long first_half;   /* 10^(halfdigits - 1) */
+} palindrome_gen;
+
+/* Positions the generator on palindrome number i. */
+static void palindrome_seek(unsigned long i, palindrome_gen *gen) {
+  gen->length = 1;
+  gen->first_half = 1;
+  if (i < 10) {
+    gen->half = i;
+    return;
+  }
+  i -= 10;
+  gen->length = 2;
+  while (i >= 9 * gen->first_half) {
+    i -= 9 * gen->first_half;
+    if (++gen->length % 2) {
+      gen->first_half *= 10;
+    }
+  }
+  gen->half = gen->first_half + i;
+}
+
+static unsigned long palindrome_value(const palindrome_gen *gen) {
+  unsigned long value = gen->half;
+  unsigned long tail = (gen->length % 2) ? gen->half / 10 : gen->half;
+  while (tail) {
+    value = value * 10 + tail % 10;
+    tail /= 10;
+  }
+  return value;
+}
+
+static void palindrome_next(palindrome_gen *gen) {
+  if (++gen->half == gen->first_half * 10) {
+    if (++gen->length % 2) {
+      gen->first_half *= 10;
+    }
+    gen->half = gen->first_half;
+  }
+}
+
+/*
+ * Trial division test of the original kernel: compares the first and last
+ * digits and strips them.
+ */
+static int is_palindrome(unsigned long num) {
+  unsigned long power = 1;
+  while (num / power >= 10) {
+    power *= 10;
+  }
+  while (num) {
+    if ((num % 10) != (num / power)) {
+      return 0;
+    }
+    num %= power;
+    num /= 10;
+    power /= 100;
+  }
+  return 1;
+}
+
 void phase9_compute(const int num_iterations, const int num_entries,
-    unsigned long* restrict palindromes, int validation_phase, int num_threads
+    unsigned long* restrict palindromes, const phase9_mode mode,
+    int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase9_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase9_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , unsigned long* restrict valid_red_ulong_vals
 #endif
     ) {
   /*
-   * Computes the first N palindromes
+   * Computes the first N palindromes. Each thread gets one contiguous range
+   * of entries (static schedule) and only depends on its own results, so the
+   * work done by each thread does not depend on scheduling:
+   * - constructive: the first palindrome of the range is built from its index,
+   *   the next ones from the next half;
+   * - brute force: every integer after the previous palindrome is tested with
+   *   trial division (the palindrome before the range is built from its index).
    */
-
-  unsigned int is_palindrome = 0;
-  unsigned long num = 0;
-  int found = 0;
-  unsigned long latest_pal = 0;
-  unsigned int latest_i = 0;
-  int total_palindromes = 0;
-  int from_zero = 0;
-
-#pragma omp parallel firstprivate(palindromes, total_palindromes, from_zero) private(found, num, \
-  is_palindrome) \
-  if(!validation_phase) num_threads(num_threads) shared(latest_pal, latest_i)
+#pragma omp parallel shared(palindromes) \
+  if(!validation_phase) num_threads(num_threads)
   {
 #if ENABLE_BINDING
     if (bind_to_cpu_set) {
@@ -674,127 +698,78 @@ void phase9_compute(const int num_iterations, const int num_entries,
 #endif
   }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-#pragma omp critical
-    {
-      int retval;
-      if ((retval = PAPI_start_counters(papi_info->event_code,
-          papi_info->total_events)) != PAPI_OK) {
-        printf("Failed to start counters %d: %s\n", retval,
-               handle_error(retval));
-      }
-    }
-#endif
+    counters_thread_start();
 
     for (int iter = 0; iter < num_iterations/10; ++iter) {
-      num = 0;
-      latest_pal = 0;
-      latest_i = 0;
-      #pragma omp for
+      palindrome_gen gen = { 0 };
+      int prev = -1;
+      ITER_TIMER_START(t);
+      #pragma omp for schedule(static) nowait
       for (int i = 0; i < num_entries; ++i) {
-        if (i == 0) {
-          palindromes[i] = num;
-#if RED_VALIDATION
-          valid_red_ulong_vals[i] = palindromes[i];
-#endif
-        } else {
-          if (i > latest_i) {
-            found = latest_i;
-            num = palindromes[found] + 1;
-          } else {
-            ++from_zero;
-            found = -1;
-            num = 0;
+        if (mode == PHASE9_BRUTEFORCE) {
+          unsigned long num = 0;
+          if (prev == i - 1 && i > 0) {
+            num = palindromes[i - 1] + 1;
+          } else if (i > 0) {
+            palindrome_seek(i - 1, &gen);
+            num = palindrome_value(&gen) + 1;
           }
-
-          while (found < i) {
-            if (num < 10) {
-              palindromes[i] = num;
-              is_palindrome = 1;
-            } else {
-              is_palindrome = 1;
-              unsigned long tmp_num = num;
-              unsigned int length = 0;
-               while (tmp_num) {
-                length += 1;
-                tmp_num /= 10;
-              }
-              tmp_num = num;
-              while (tmp_num) {
-                if ((tmp_num % 10) !=
-                    (tmp_num / (unsigned long) pow(10, (length-1)))) {
-                  is_palindrome = 0;
-                  break;
-                }
-                tmp_num %= (unsigned long) pow(10, (length-1));
-                tmp_num /= 10;
-                length -= 2;
-              }
-            }
-            if (is_palindrome) {
-              ++found;
-            }
+          while (!is_palindrome(num)) {
             ++num;
           }
-          palindromes[i] = num-1;
-          ++total_palindromes;
-          if ((i > latest_i) && (palindromes[i] > latest_pal)) {
-            latest_pal = palindromes[i];
-            latest_i = i;
+          palindromes[i] = num;
+        } else {
+          if (prev != i - 1 || i == 0) {
+            palindrome_seek(i, &gen);
           }
+          palindromes[i] = palindrome_value(&gen);
+          palindrome_next(&gen);
+        }
+        prev = i;
 #if RED_VALIDATION
-          valid_red_ulong_vals[i] = palindromes[i];
+        valid_red_ulong_vals[i] = palindromes[i];
 #endif
-        }
       }
+      ITER_TIMER_STOP(t);
+      #pragma omp barrier
     }
 
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-#pragma omp critical
-    {
-      int retval;
-      unsigned long long event_values[papi_info->total_events];
-      memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-      if ((retval = PAPI_stop_counters(event_values,
-          papi_info->total_events)) != PAPI_OK) {
-        printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-      }
-      for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-        printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-        printf("Thread %d %s value = %lld\n", 0,
-#endif
-            papi_info->event_code_str[i],
-            event_values[i]);
-      }
-      printf("Thread %d total_palindromes value = %d\n", omp_get_thread_num(), total_palindromes);
-      printf("Thread %d from_zero value = %d\n", omp_get_thread_num(), from_zero);
-    }
-#endif
+    counters_thread_stop();
+  }
+}
+
+/*
+ * One GUPS update. The branch on atomic is hoisted out of the update loops
+ * by the compiler.
+ */
+static inline void gups_apply(uint64_t *table, const uint64_t mask,
+    const uint64_t r, const int atomic) {
+  if (atomic) {
+    #pragma omp atomic
+    table[r & mask] ^= r;
+  } else {
+    table[r & mask] ^= r;
   }
 }
 
-void phase10_compute(const int num_iterations, int num_randomloc,
-    int *randomloc, int validation_phase,
+void phase10_compute(const int num_iterations, const long table_size,
+    uint64_t *table, const gups_spec *spec, int validation_phase,
     int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase10_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
-#endif
-#if RED_VALIDATION
-    , unsigned int* restrict valid_red_int_vals
+    , int num_cpus, const cpu_set_t *phase10_cpu_id, int bind_to_cpu_set
 #endif
     ) {
   /*
-   * GUPS-like kernel
+   * GUPS kernel: num_iterations * table_size XOR updates of random table
+   * entries. Applying the same updates a second time restores the table,
+   * which is how the result is verified.
    */
-  int index;
-  unsigned int seed;
-#pragma omp parallel firstprivate(randomloc, num_randomloc) \
-  private(index, seed)\
+  const uint64_t mask = table_size - 1;
+  const long num_updates = (long) num_iterations * table_size;
+  const long num_blocks = (num_updates + GUPS_BLOCK - 1) / GUPS_BLOCK;
+  const int atomic = (spec->update == GUPS_ATOMIC);
+  const int batch = spec->batch;
+#pragma omp parallel shared(table) \
   if(!validation_phase) num_threads(num_threads)
   {
 #if ENABLE_BINDING
@@ -807,51 +782,153 @@ void phase10_compute(const int num_iterations, int num_randomloc,
 #endif
   }
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-#pragma omp critical
-    {
-      int retval;
-      if ((retval = PAPI_start_counters(papi_info->event_code,
-          papi_info->total_events)) != PAPI_OK) {
-        printf("Failed to start counters %d: %s\n", retval,
-               handle_error(retval));
+    counters_thread_start();
+
+    uint64_t indices[GUPS_MAX_BATCH];
+    #pragma omp for schedule(static)
+    for (long b = 0; b < num_blocks; ++b) {
+      /* One timing sample per block of updates */
+      ITER_TIMER_START(t);
+      const long len = (num_updates - b * GUPS_BLOCK < GUPS_BLOCK) ?
+                       num_updates - b * GUPS_BLOCK : GUPS_BLOCK;
+      uint64_t state = rng_hash(RNG_GUPS, b) | 1;
+      if (batch > 1) {
+        for (long u = 0; u < len; u += batch) {
+          const int n = (len - u < batch) ? len - u : batch;
+          for (int k = 0; k < n; ++k) {
+            indices[k] = rng_xorshift(&state);
+            __builtin_prefetch(&table[indices[k] & mask], 1);
+          }
+          for (int k = 0; k < n; ++k) {
+            gups_apply(table, mask, indices[k], atomic);
+          }
+        }
+      } else {
+        for (long u = 0; u < len; ++u) {
+          gups_apply(table, mask, rng_xorshift(&state), atomic);
+        }
       }
+      ITER_TIMER_STOP(t);
     }
-#endif
 
-#ifdef _OPENMP
-    seed = omp_get_thread_num();
-#else
-    seed = rand();
-#endif
-    #pragma omp for
-    for (unsigned long iter = 0; iter < num_iterations * num_randomloc; ++iter) {
-      index = rand_r(&seed) % num_randomloc;
-      randomloc[index] = index;
-    }
+    counters_thread_stop();
+  }
+}
 
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-#pragma omp critical
-    {
-      int retval;
-      unsigned long long event_values[papi_info->total_events];
-      memset(event_values, 0, papi_info->total_events * sizeof(unsigned long long));
-      if ((retval = PAPI_stop_counters(event_values,
-          papi_info->total_events)) != PAPI_OK) {
-        printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-      }
-      for (int i = 0; i < papi_info->total_events; ++i) {
-#ifdef _OPENMP
-        printf("Thread %d %s value = %lld\n", omp_get_thread_num(),
-#else
-        printf("Thread %d %s value = %lld\n", 0,
-#endif
-            papi_info->event_code_str[i],
-            event_values[i]);
+/*
+ * Work models. Per element or pair:
+ * - Phase 1: vals and int_vals read and written; 5 flops on vals.
+ * - Phase 2: dest read and written, src1, ind_src2 and src2[ind] read.
+ * - Phase 3: vals read and written by the reduction, then written.
+ * - Phase 4: dest read and written, src1 and src2 read.
+ * - Phase 5: dest read and written, two indices and two sources read.
+ * - Phase 6: per nonzero a value, a column index and an input element; per
+ *   row a row pointer and an output element.
+ * - Phase 7: one node per list element of each thread.
+ * - Phase 8: 11 flops per neighbour pair, 10 per all pairs or cell list pair
+ *   (the tiles of the j particles stay in cache).
+ * - Phase 9: none; it is integer only, and the palindromes it writes are
+ *   its results, not a stream to compare with the peak bandwidth.
+ * - Phase 10: one 64-bit read-modify-write per update (integer only).
+ */
+phase_work phase1_work(const int num_iterations, const long array_size) {
+  phase_work work = { num_iterations, 0, 0 };
+  work.bytes = (double) num_iterations * array_size *
+               2 * (sizeof(double) + sizeof(int));
+  work.flops = 5.0 * num_iterations * array_size;
+  return work;
+}
+
+phase_work phase2_work(const int num_iterations, const long array_size) {
+  phase_work work = { num_iterations, 0, 0 };
+  work.bytes = (double) num_iterations * array_size *
+               (4 * sizeof(double) + sizeof(int));
+  work.flops = 2.0 * num_iterations * array_size;
+  return work;
+}
+
+phase_work phase3_work(const int num_iterations, const long array_size) {
+  phase_work work = { num_iterations, 0, 0 };
+  work.bytes = (double) num_iterations * array_size * 3 * sizeof(double);
+  work.flops = 2.0 * num_iterations * array_size;
+  return work;
+}
+
+phase_work phase4_work(const int num_iterations, const long array_size) {
+  phase_work work = { num_iterations, 0, 0 };
+  work.bytes = (double) num_iterations * array_size * 4 * sizeof(double);
+  work.flops = 2.0 * num_iterations * array_size;
+  return work;
+}
+
+phase_work phase5_work(const int num_iterations, const long array_size) {
+  phase_work work = { num_iterations, 0, 0 };
+  work.bytes = (double) num_iterations * array_size *
+               (4 * sizeof(double) + 2 * sizeof(int));
+  work.flops = 2.0 * num_iterations * array_size;
+  return work;
+}
+
+phase_work phase6_work(const int num_iterations, const sparse_matrix *matrix) {
+  phase_work work = { num_iterations / 5, 0, 0 };
+  work.bytes = (double) work.iterations *
+               (matrix->nnz * (2 * sizeof(double) + sizeof(int)) +
+                matrix->nrow * (sizeof(double) + sizeof(long)));
+  work.flops = 2.0 * work.iterations * matrix->nnz;
+  return work;
+}
+
+phase_work phase7_work(const int num_iterations, const long llist_size,
+    const int num_threads) {
+  phase_work work = { num_iterations, 0, 0 };
+  work.bytes = (double) num_iterations * num_threads * llist_size *
+               sizeof(linked_list);
+  return work;
+}
+
+phase_work phase8_work(const int num_iterations,
+    const particle_set *particles, const phase8_spec *spec) {
+  const long n = particles->num_particles;
+  const double particle_bytes = 5 * sizeof(double);
+  phase_work work = { num_iterations, 0, 0 };
+  double pairs;
+  if (spec->mode == PHASE8_CELLS) {
+    /* Pairs of particles in neighbouring cells */
+    const int m = particles->cells_per_dim;
+    const int *cell_start = particles->cell_start;
+    pairs = 0;
+    for (int c = 0; c < m * m * m; ++c) {
+      const int cx = c % m, cy = (c / m) % m, cz = c / (m * m);
+      const int x0 = (cx > 0) ? cx - 1 : cx, x1 = (cx < m - 1) ? cx + 1 : cx;
+      for (int z = cz - 1; z <= cz + 1; ++z) {
+        for (int y = cy - 1; y <= cy + 1; ++y) {
+          if (z < 0 || z >= m || y < 0 || y >= m) {
+            continue;
+          }
+          const int row = (z * m + y) * m;
+          pairs += (double) (cell_start[c + 1] - cell_start[c]) *
+                   (cell_start[row + x1 + 1] - cell_start[row + x0]);
+        }
       }
     }
-#endif
-
+    work.flops = 10.0 * num_iterations * pairs;
+  } else if (spec->mode == PHASE8_ALLPAIRS) {
+    pairs = (double) n * n;
+    work.flops = 10.0 * num_iterations * pairs;
+  } else {
+    work.flops = 11.0 * num_iterations * (n - 1);
   }
+  work.bytes = (double) num_iterations * n * particle_bytes;
+  return work;
+}
+
+phase_work phase9_work(const int num_iterations, const int num_entries) {
+  phase_work work = { num_iterations / 10, 0, 0 };
+  return work;
+}
 
+phase_work phase10_work(const int num_iterations, const long table_size) {
+  phase_work work = { num_iterations, 0, 0 };
+  work.bytes = (double) num_iterations * table_size * 2 * sizeof(uint64_t);
+  return work;
 }
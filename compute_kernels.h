@@ -23,6 +23,8 @@
 
 #include "meabo.h"
 #include "util.h"
+#include "sparse.h"
+#include "simd_kernels.h"
 
 void phase1_compute(const int num_iterations, const int array_size,
     const int block_size, register double temp1, register double temp2,
@@ -30,10 +32,7 @@ void phase1_compute(const int num_iterations, const int array_size,
     register int int_temp3, double *vals, int *int_vals,
     int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase1_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase1_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals, int *valid_red_int_vals
@@ -44,10 +43,7 @@ void phase2_compute(const int num_iterations, const int array_size,
     double *dest, double *src1, double *src2, int *ind_src2,
     int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase2_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase2_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
@@ -57,10 +53,7 @@ void phase2_compute(const int num_iterations, const int array_size,
 void phase3_compute(const int num_iterations, const int array_size,
     double *vals, double *reduction_var, int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase3_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase3_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_reduction_var
@@ -71,10 +64,7 @@ void phase4_compute(const int num_iterations, const int array_size,
     double *dest, double *src1, double *src2, int validation_phase,
     int num_threads
 #if ENABLE_BINDING
-    ,int num_cpus, int phase4_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    ,int num_cpus, const cpu_set_t *phase4_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
@@ -85,25 +75,17 @@ void phase5_compute(const int num_iterations, const int array_size,
     double *dest, double *src1, double *src2, int *ind_src1,
     int *ind_src2, int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase5_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase5_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
 #endif
     );
 
-void phase6_compute(const int num_iterations, const int nrow,
-    double **sparse_matrix_values, double *vect_in,
-    int **sparse_matrix_indeces, int *sparse_matrix_nonzeros, double *vect_out,
-    int validation_phase, int num_threads
+void phase6_compute(const int num_iterations, const sparse_matrix *matrix,
+    double *vect_in, double *vect_out, int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase6_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase6_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
@@ -114,24 +96,28 @@ void phase7_compute(const int num_iterations, const int array_size,
     linked_list **llist,
     int validation, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase7_cpu_id, int bind_to_cpu_set
-#endif
-#if  ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase7_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
 #endif
     );
 
-void phase8_compute(const int num_iterations, const int num_particles,
-    particle* restrict particles, double* restrict forces,
-    int validation_phase, int num_threads
+double phase7_chase(const long num_steps, const int num_chains,
+    linked_list **starts, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase8_cpu_id, int bind_to_cpu_set
+    , int num_cpus, const cpu_set_t *phase7_cpu_id, int bind_to_cpu_set
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    );
+
+/* Number of particles per tile in the Phase 8 all pairs mode. */
+#define PHASE8_TILE 512
+
+void phase8_compute(const int num_iterations,
+    const particle_set* restrict particles, const phase8_spec *spec,
+    double* restrict forces, int validation_phase, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase8_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , double *valid_red_vals
@@ -139,29 +125,55 @@ void phase8_compute(const int num_iterations, const int num_particles,
     );
 
 void phase9_compute(const int num_iterations, const int num_entries,
-    unsigned long* restrict palindromes, int validation_phase, int num_threads
+    unsigned long* restrict palindromes, const phase9_mode mode,
+    int validation_phase, int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase9_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
+    , int num_cpus, const cpu_set_t *phase9_cpu_id, int bind_to_cpu_set
 #endif
 #if RED_VALIDATION
     , unsigned long* restrict valid_red_ulong_vals
 #endif
     );
 
-void phase10_compute(const int num_iterations, int num_randomloc,
-    int *randomloc, int validation_phase,
+void phase10_compute(const int num_iterations, const long table_size,
+    uint64_t *table, const gups_spec *spec, int validation_phase,
     int num_threads
 #if ENABLE_BINDING
-    , int num_cpus, int phase10_cpu_id, int bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , PAPI_info *papi_info
-#endif
-#if RED_VALIDATION
-    , unsigned int* restrict valid_red_int_vals
+    , int num_cpus, const cpu_set_t *phase10_cpu_id, int bind_to_cpu_set
 #endif
     );
+
+/*
+ * Analytic work model of one run of a phase: number of iterations actually
+ * run, bytes moved to or from memory (each element read or written counts
+ * once, with no reuse between iterations) and floating-point operations.
+ */
+typedef struct phase_work {
+  long iterations;
+  double bytes;
+  double flops;
+} phase_work;
+
+phase_work phase1_work(const int num_iterations, const long array_size);
+
+phase_work phase2_work(const int num_iterations, const long array_size);
+
+phase_work phase3_work(const int num_iterations, const long array_size);
+
+phase_work phase4_work(const int num_iterations, const long array_size);
+
+phase_work phase5_work(const int num_iterations, const long array_size);
+
+phase_work phase6_work(const int num_iterations, const sparse_matrix *matrix);
+
+phase_work phase7_work(const int num_iterations, const long llist_size,
+    const int num_threads);
+
+phase_work phase8_work(const int num_iterations,
+    const particle_set *particles, const phase8_spec *spec);
+
+phase_work phase9_work(const int num_iterations, const int num_entries);
+
+phase_work phase10_work(const int num_iterations, const long table_size);
+
 #endif /* COMPUTE_KERNELS_H_ */
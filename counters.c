@@ -0,0 +1,702 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "counters.h"
+#include "util.h"
+#include "results.h"
+
+#if COUNTERS_MAX_EVENTS > RESULTS_MAX_COUNTERS
+#error "The results records have no room for all the events"
+#endif
+
+int parse_counters_mode(const char *str, counters_mode *mode) {
+  if (!strcmp(str, "multiplex") || !strcmp(str, "mux")) {
+    *mode = COUNTERS_MULTIPLEX;
+  } else if (!strcmp(str, "repeat")) {
+    *mode = COUNTERS_REPEAT;
+  } else {
+    printf("Unknown counter mode %s\n", str);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * Event names separated by commas, or @file for a file with one or more
+ * names per line (separated by commas or spaces), where # starts a comment.
+ * Returns the number of events, or -1 on error.
+ */
+int parse_event_spec(const char *spec, char ***names) {
+  char *text;
+  if (spec[0] == '@') {
+    FILE *file = fopen(spec + 1, "r");
+    if (!file) {
+      printf("Failed to open %s: %s\n", spec + 1, strerror(errno));
+      return -1;
+    }
+    size_t size = 0, capacity = 4096;
+    text = malloc(capacity);
+    int c, comment = 0;
+    while ((c = fgetc(file)) != EOF) {
+      if (c == '#') {
+        comment = 1;
+      } else if (c == '\n') {
+        comment = 0;
+      }
+      if (size + 1 == capacity) {
+        capacity *= 2;
+        text = realloc(text, capacity);
+      }
+      text[size++] = comment ? ' ' : c;
+    }
+    text[size] = 0;
+    fclose(file);
+  } else {
+    text = strdup(spec);
+  }
+  /* The names point into text, which is kept for the whole run. */
+  int num_events = 0;
+  *names = malloc(sizeof(char *) * COUNTERS_MAX_EVENTS);
+  for (char *name = strtok(text, ", \t\r\n"); name;
+       name = strtok(NULL, ", \t\r\n")) {
+    if (num_events == COUNTERS_MAX_EVENTS) {
+      printf("Too many events, at most %d are supported\n",
+             COUNTERS_MAX_EVENTS);
+      return -1;
+    }
+    (*names)[num_events++] = name;
+  }
+  if (!num_events) {
+    printf("No events in %s\n", spec);
+    return -1;
+  }
+  return num_events;
+}
+
+#if ENABLE_COUNTERS
+
+#if !ENABLE_PAPI
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#endif
+
+counter_set phase_counters;
+
+static inline int thread_num(void) {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+/* Groups counted by the current run. */
+static inline int group_active(const int g) {
+  return phase_counters.mode == COUNTERS_MULTIPLEX ||
+         g == phase_counters.group;
+}
+
+/*
+ * Splits the events, in order, into groups of at most group_size events that
+ * use a hardware counter (hardware[e] is 0 for the software events).
+ */
+static void make_groups(int group_size, const int *hardware) {
+  int used = 0;
+  if (group_size < 1) {
+    group_size = 1;
+  }
+  phase_counters.num_groups = 0;
+  for (int e = 0; e < phase_counters.num_events; ++e) {
+    if (!phase_counters.num_groups || (hardware[e] && used == group_size)) {
+      counter_group *group = &phase_counters.groups[phase_counters.num_groups];
+      group->first = e;
+      group->num_events = 0;
+      ++phase_counters.num_groups;
+      used = 0;
+    }
+    ++phase_counters.groups[phase_counters.num_groups - 1].num_events;
+    used += hardware[e];
+  }
+}
+
+#if ENABLE_PAPI
+static int event_codes[COUNTERS_MAX_EVENTS];
+static int multiplexed = 0;
+
+static unsigned long papi_thread_id(void) {
+  return (unsigned long) gettid();
+}
+
+/*
+ * PAPI multiplexes the events of a single event set, so the events are only
+ * split into groups to be counted in repeated runs.
+ */
+static int backend_init(char **names, const int num_events,
+                        const int num_hwcntrs) {
+  int retval, hardware[COUNTERS_MAX_EVENTS];
+  if ((retval = PAPI_thread_init(papi_thread_id)) != PAPI_OK) {
+    printf("PAPI thread init error %d: %s\n", retval, handle_error(retval));
+    return 1;
+  }
+  phase_counters.names = malloc(sizeof(char *) * COUNTERS_MAX_EVENTS);
+  phase_counters.num_events = 0;
+  for (int e = 0; e < num_events; ++e) {
+    const int n = phase_counters.num_events;
+    if (n == COUNTERS_MAX_EVENTS) {
+      printf("Too many events, %s and the next ones are skipped\n", names[e]);
+      break;
+    }
+    if ((retval = PAPI_event_name_to_code(names[e],
+                                          &event_codes[n])) != PAPI_OK) {
+      printf("Event %s not supported (%s), skipped\n", names[e],
+             handle_error(retval));
+      continue;
+    }
+    phase_counters.names[n] = names[e];
+    hardware[n] = 1;
+    ++phase_counters.num_events;
+  }
+  if (phase_counters.mode == COUNTERS_MULTIPLEX &&
+      phase_counters.num_events > num_hwcntrs) {
+    if ((retval = PAPI_multiplex_init()) != PAPI_OK) {
+      printf("PAPI multiplex init error %d: %s\n", retval,
+             handle_error(retval));
+      return 1;
+    }
+    multiplexed = 1;
+    make_groups(phase_counters.num_events, hardware);
+  } else {
+    make_groups(num_hwcntrs, hardware);
+  }
+  return 0;
+}
+
+/* Called by the thread that will use the event sets. */
+static void thread_open(thread_counters *slot) {
+  int retval;
+  PAPI_register_thread();
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    const counter_group *group = &phase_counters.groups[g];
+    int *event_set = &slot->event_sets[g];
+    *event_set = PAPI_NULL;
+    if ((retval = PAPI_create_eventset(event_set)) != PAPI_OK) {
+      printf("Failed to create event set %d: %s\n", retval,
+             handle_error(retval));
+      *event_set = PAPI_NULL;
+      continue;
+    }
+    /* Multiplexed event sets must be bound to the CPU component first. */
+    if (multiplexed &&
+        ((retval = PAPI_assign_eventset_component(*event_set, 0)) != PAPI_OK ||
+         (retval = PAPI_set_multiplex(*event_set)) != PAPI_OK)) {
+      printf("Failed to multiplex event set %d: %s\n", retval,
+             handle_error(retval));
+    }
+    for (int e = group->first; e < group->first + group->num_events; ++e) {
+      if ((retval = PAPI_add_event(*event_set, event_codes[e])) != PAPI_OK) {
+        printf("Failed to add event %s %d: %s\n", phase_counters.names[e],
+               retval, handle_error(retval));
+        PAPI_cleanup_eventset(*event_set);
+        PAPI_destroy_eventset(event_set);
+        *event_set = PAPI_NULL;
+        break;
+      }
+    }
+  }
+}
+
+static void thread_close(thread_counters *slot) {
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    if (slot->event_sets[g] != PAPI_NULL) {
+      PAPI_cleanup_eventset(slot->event_sets[g]);
+      PAPI_destroy_eventset(&slot->event_sets[g]);
+      slot->event_sets[g] = PAPI_NULL;
+    }
+  }
+}
+
+static void thread_begin(thread_counters *slot) {
+  int retval;
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    if (group_active(g) && slot->event_sets[g] != PAPI_NULL &&
+        (retval = PAPI_start(slot->event_sets[g])) != PAPI_OK) {
+      printf("Failed to start counters %d: %s\n", retval,
+             handle_error(retval));
+    }
+  }
+}
+
+/* PAPI scales the multiplexed values itself. */
+static int thread_end(thread_counters *slot) {
+  int retval, read = 0;
+  long long values[COUNTERS_MAX_EVENTS];
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    const counter_group *group = &phase_counters.groups[g];
+    if (!group_active(g) || slot->event_sets[g] == PAPI_NULL) {
+      continue;
+    }
+    if ((retval = PAPI_stop(slot->event_sets[g], values)) != PAPI_OK) {
+      printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
+      continue;
+    }
+    for (int i = 0; i < group->num_events; ++i) {
+      slot->values[group->first + i] = values[i];
+      slot->running[group->first + i] = 1;
+    }
+    read = 1;
+  }
+  return read;
+}
+
+#else /* perf_event_open */
+
+typedef struct perf_event_name {
+  const char *name;
+  uint32_t type;
+  uint64_t config;
+} perf_event_name;
+
+#define CACHE_EVENT(cache, op, result) \
+  (PERF_COUNT_HW_CACHE_##cache | (PERF_COUNT_HW_CACHE_OP_##op << 8) | \
+   (PERF_COUNT_HW_CACHE_RESULT_##result << 16))
+
+/* The generic events of the kernel, with the names used by perf(1). */
+static const perf_event_name perf_events[] = {
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { "cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+  { "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { "branch-instructions", PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+  { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { "bus-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES },
+  { "stalled-cycles-frontend", PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_STALLED_CYCLES_FRONTEND },
+  { "stalled-cycles-backend", PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_STALLED_CYCLES_BACKEND },
+  { "ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES },
+  { "L1-dcache-loads", PERF_TYPE_HW_CACHE, CACHE_EVENT(L1D, READ, ACCESS) },
+  { "L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+    CACHE_EVENT(L1D, READ, MISS) },
+  { "L1-dcache-stores", PERF_TYPE_HW_CACHE, CACHE_EVENT(L1D, WRITE, ACCESS) },
+  { "L1-dcache-prefetches", PERF_TYPE_HW_CACHE,
+    CACHE_EVENT(L1D, PREFETCH, ACCESS) },
+  { "L1-icache-loads", PERF_TYPE_HW_CACHE, CACHE_EVENT(L1I, READ, ACCESS) },
+  { "L1-icache-load-misses", PERF_TYPE_HW_CACHE,
+    CACHE_EVENT(L1I, READ, MISS) },
+  { "LLC-loads", PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, READ, ACCESS) },
+  { "LLC-load-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, READ, MISS) },
+  { "LLC-stores", PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, WRITE, ACCESS) },
+  { "LLC-store-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, WRITE, MISS) },
+  { "LLC-prefetches", PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, PREFETCH, ACCESS) },
+  { "dTLB-loads", PERF_TYPE_HW_CACHE, CACHE_EVENT(DTLB, READ, ACCESS) },
+  { "dTLB-load-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(DTLB, READ, MISS) },
+  { "dTLB-stores", PERF_TYPE_HW_CACHE, CACHE_EVENT(DTLB, WRITE, ACCESS) },
+  { "dTLB-store-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(DTLB, WRITE, MISS) },
+  { "iTLB-loads", PERF_TYPE_HW_CACHE, CACHE_EVENT(ITLB, READ, ACCESS) },
+  { "iTLB-load-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(ITLB, READ, MISS) },
+  { "branch-loads", PERF_TYPE_HW_CACHE, CACHE_EVENT(BPU, READ, ACCESS) },
+  { "branch-load-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(BPU, READ, MISS) },
+  { "node-loads", PERF_TYPE_HW_CACHE, CACHE_EVENT(NODE, READ, ACCESS) },
+  { "node-load-misses", PERF_TYPE_HW_CACHE, CACHE_EVENT(NODE, READ, MISS) },
+  { "task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+  { "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+  { "minor-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN },
+  { "major-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ },
+  { "context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+  { "cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+};
+
+/* Counterpart of the suggested events of util.c:init_PAPI. */
+static char *default_events[] = {
+  "cycles", "instructions", "L1-dcache-load-misses", "L1-dcache-loads",
+  "LLC-load-misses", "LLC-loads"
+};
+
+static struct perf_event_attr event_attrs[COUNTERS_MAX_EVENTS];
+
+static int perf_event_open(struct perf_event_attr *attr, const int group_fd) {
+  return syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+/*
+ * Generic event names, or r<hex> for a raw event number of the core PMU
+ * (e.g. r0003 for L1D_CACHE_REFILL on ARM cores).
+ */
+static int parse_perf_event(const char *name, struct perf_event_attr *attr) {
+  memset(attr, 0, sizeof(struct perf_event_attr));
+  attr->size = sizeof(struct perf_event_attr);
+  attr->exclude_kernel = 1;
+  attr->exclude_hv = 1;
+  attr->read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                      PERF_FORMAT_TOTAL_TIME_RUNNING;
+  if (name[0] == 'r' && name[1]) {
+    char *end;
+    attr->config = strtoull(name + 1, &end, 16);
+    if (!*end) {
+      attr->type = PERF_TYPE_RAW;
+      return 0;
+    }
+  }
+  for (size_t i = 0; i < sizeof(perf_events) / sizeof(perf_events[0]); ++i) {
+    if (!strcmp(name, perf_events[i].name)) {
+      attr->type = perf_events[i].type;
+      attr->config = perf_events[i].config;
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Keeps the events this CPU can count, in the order given: each of them is
+ * opened once on the calling thread. The software events do not use a
+ * hardware counter.
+ */
+static int backend_init(char **names, int num_events, const int num_hwcntrs) {
+  int hardware[COUNTERS_MAX_EVENTS];
+  if (!names) {
+    names = default_events;
+    num_events = sizeof(default_events) / sizeof(default_events[0]);
+  }
+  phase_counters.names = malloc(sizeof(char *) * COUNTERS_MAX_EVENTS);
+  phase_counters.num_events = 0;
+  for (int e = 0; e < num_events; ++e) {
+    const int n = phase_counters.num_events;
+    struct perf_event_attr *attr = &event_attrs[n];
+    if (n == COUNTERS_MAX_EVENTS) {
+      printf("Too many events, %s and the next ones are skipped\n", names[e]);
+      break;
+    }
+    if (parse_perf_event(names[e], attr)) {
+      printf("Unknown perf event %s\n", names[e]);
+      return 1;
+    }
+    const int fd = perf_event_open(attr, -1);
+    if (fd < 0) {
+      printf("Event %s not supported (%s), skipped\n", names[e],
+             strerror(errno));
+      continue;
+    }
+    close(fd);
+    phase_counters.names[n] = names[e];
+    hardware[n] = (attr->type != PERF_TYPE_SOFTWARE);
+    ++phase_counters.num_events;
+  }
+  make_groups(num_hwcntrs, hardware);
+  /* The group leaders enable and disable their whole group. */
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    event_attrs[phase_counters.groups[g].first].disabled = 1;
+  }
+  return 0;
+}
+
+static void thread_open(thread_counters *slot) {
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    const counter_group *group = &phase_counters.groups[g];
+    const int leader = group->first;
+    for (int e = leader; e < leader + group->num_events; ++e) {
+      slot->fds[e] = perf_event_open(&event_attrs[e],
+                                     (e == leader) ? -1 : slot->fds[leader]);
+      if (slot->fds[e] < 0) {
+        printf("Failed to open event %s: %s\n", phase_counters.names[e],
+               strerror(errno));
+        while (e-- > leader) {
+          close(slot->fds[e]);
+        }
+        slot->fds[leader] = -1;
+        break;
+      }
+    }
+  }
+}
+
+static void thread_close(thread_counters *slot) {
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    const counter_group *group = &phase_counters.groups[g];
+    if (slot->fds[group->first] >= 0) {
+      for (int e = group->first; e < group->first + group->num_events; ++e) {
+        close(slot->fds[e]);
+      }
+      slot->fds[group->first] = -1;
+    }
+  }
+}
+
+static void thread_begin(thread_counters *slot) {
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    const int leader = slot->fds[phase_counters.groups[g].first];
+    if (group_active(g) && leader >= 0) {
+      ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+}
+
+/*
+ * When the groups do not all fit in the counters, the kernel counts them in
+ * turns; each value is scaled by time enabled / time running of its group.
+ */
+static int thread_end(thread_counters *slot) {
+  uint64_t data[3 + COUNTERS_MAX_EVENTS];
+  int read_any = 0;
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    const counter_group *group = &phase_counters.groups[g];
+    const int leader = slot->fds[group->first];
+    if (group_active(g) && leader >= 0) {
+      ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    const counter_group *group = &phase_counters.groups[g];
+    const int leader = slot->fds[group->first];
+    if (!group_active(g) || leader < 0) {
+      continue;
+    }
+    if (read(leader, data, sizeof(data)) < (ssize_t) (3 * sizeof(uint64_t))) {
+      printf("Failed to read counters: %s\n", strerror(errno));
+      continue;
+    }
+    const uint64_t enabled = data[1], running = data[2];
+    for (int i = 0; i < group->num_events && (uint64_t) i < data[0]; ++i) {
+      const int e = group->first + i;
+      if (running) {
+        slot->values[e] = (unsigned long long)
+                          ((double) data[3 + i] * enabled / running + 0.5);
+        slot->running[e] = (double) running / enabled;
+      } else {
+        slot->values[e] = 0;
+        slot->running[e] = 0;
+      }
+    }
+    read_any = 1;
+  }
+  return read_any;
+}
+
+#endif
+
+/*
+ * names lists the events to count (NULL for the default perf events), split
+ * into groups of num_hwcntrs hardware events. Must be called before the
+ * first phase; with PAPI, after init_PAPI.
+ */
+int counters_init(char **names, const int num_events,
+                  const counters_mode mode, const int num_hwcntrs) {
+  phase_counters.mode = mode;
+#if FULL_VALIDATION
+  if (mode == COUNTERS_REPEAT) {
+    printf("Repeated runs would change the data of the full validation, "
+           "multiplexing instead\n");
+    phase_counters.mode = COUNTERS_MULTIPLEX;
+  }
+#endif
+  if (backend_init(names, num_events, num_hwcntrs)) {
+    return 1;
+  }
+  if (!phase_counters.num_events) {
+    printf("No performance counters available\n");
+  } else if (phase_counters.num_groups > 1) {
+    printf("%d events in %d groups, %s\n", phase_counters.num_events,
+           phase_counters.num_groups,
+           (phase_counters.mode == COUNTERS_REPEAT) ?
+           "each phase is run once per group" : "multiplexed");
+  }
+  for (int g = 0; g < phase_counters.num_groups; ++g) {
+    const counter_group *group = &phase_counters.groups[g];
+    printf("Counter group %d:", g + 1);
+    for (int e = group->first; e < group->first + group->num_events; ++e) {
+      printf(" %s", phase_counters.names[e]);
+    }
+    printf("\n");
+  }
+  results_counter_names(phase_counters.names, phase_counters.num_events);
+  return 0;
+}
+
+/*
+ * Called by the thread owning the slot: a slot opened by another thread (the
+ * OpenMP team changed) is closed and opened again.
+ */
+static void thread_reopen(thread_counters *slot) {
+  if (slot->tid) {
+    thread_close(slot);
+  }
+  thread_open(slot);
+  slot->tid = gettid();
+}
+
+/*
+ * Opens the event sets of the threads of a phase that do not have one yet,
+ * before the phase is timed. The slots are only reallocated when a phase
+ * uses more threads than any previous one. The values of the first run of a
+ * phase are cleared; the next runs (repeat mode) add the other groups.
+ */
+void counters_start(const int num_threads) {
+  if (!phase_counters.num_events) {
+    return;
+  }
+  const int n = (num_threads < 1) ? 1 : num_threads;
+  if (n > phase_counters.allocated) {
+    thread_counters *threads;
+    if (posix_memalign((void **) &threads, 64, sizeof(thread_counters) * n)) {
+      printf("Failed to allocate the counter slots\n");
+      exit(1);
+    }
+    memset(threads, 0, sizeof(thread_counters) * n);
+    if (phase_counters.threads) {
+      memcpy(threads, phase_counters.threads,
+             sizeof(thread_counters) * phase_counters.allocated);
+      free(phase_counters.threads);
+    }
+    phase_counters.threads = threads;
+    phase_counters.allocated = n;
+  }
+  if (!phase_counters.group) {
+    for (int t = 0; t < n; ++t) {
+      thread_counters *slot = &phase_counters.threads[t];
+      slot->valid = 0;
+      memset(slot->values, 0, sizeof(slot->values));
+      memset(slot->running, 0, sizeof(slot->running));
+    }
+  }
+  phase_counters.num_threads = n;
+  #pragma omp parallel num_threads(n)
+  {
+    thread_counters *slot = &phase_counters.threads[thread_num()];
+    if (slot->tid != gettid()) {
+      thread_reopen(slot);
+    }
+  }
+  phase_counters.active = 1;
+}
+
+void counters_stop(void) {
+  phase_counters.active = 0;
+}
+
+/*
+ * In repeat mode, moves to the next group and returns 1 until every group
+ * has been counted.
+ */
+int counters_next_run(void) {
+  if (phase_counters.mode != COUNTERS_REPEAT ||
+      phase_counters.group + 1 >= phase_counters.num_groups) {
+    phase_counters.group = 0;
+    return 0;
+  }
+  ++phase_counters.group;
+  printf("Running the phase again for counter group %d of %d\n",
+         phase_counters.group + 1, phase_counters.num_groups);
+  return 1;
+}
+
+/* Called by each thread of a phase before its first iteration. */
+void counters_thread_start(void) {
+  const int thread = thread_num();
+  if (!phase_counters.active || thread >= phase_counters.num_threads) {
+    return;
+  }
+  thread_counters *slot = &phase_counters.threads[thread];
+  if (slot->tid != gettid()) {
+    thread_reopen(slot);
+  }
+  thread_begin(slot);
+}
+
+/* Called by each thread of a phase after its last iteration. */
+void counters_thread_stop(void) {
+  const int thread = thread_num();
+  if (!phase_counters.active || thread >= phase_counters.num_threads) {
+    return;
+  }
+  thread_counters *slot = &phase_counters.threads[thread];
+  if (slot->tid == gettid() && thread_end(slot)) {
+    slot->valid = 1;
+  }
+}
+
+/*
+ * Prints the sum of each event over the threads of the phase, then the
+ * values of each thread, and adds them to the results. Scaled values are
+ * followed by the fraction of the time they were counted.
+ */
+void counters_report(const int phase) {
+  unsigned long long sums[COUNTERS_MAX_EVENTS] = { 0 };
+  double running[COUNTERS_MAX_EVENTS] = { 0 };
+  int threads = 0;
+  if (!phase_counters.num_events) {
+    return;
+  }
+  for (int t = 0; t < phase_counters.num_threads; ++t) {
+    const thread_counters *slot = &phase_counters.threads[t];
+    if (slot->valid) {
+      for (int e = 0; e < phase_counters.num_events; ++e) {
+        sums[e] += slot->values[e];
+        running[e] += slot->running[e];
+      }
+      results_counters(t, phase_counters.num_events, slot->values);
+      ++threads;
+    }
+  }
+  if (!threads) {
+    return;
+  }
+  printf("Phase %d counters (sum of %d threads):\n", phase, threads);
+  for (int e = 0; e < phase_counters.num_events; ++e) {
+    const char *name = phase_counters.names[e];
+    const double counted = running[e] / threads;
+    if (counted == 0) {
+      printf("  %-24s %20s\n", name, "not counted");
+      continue;
+    }
+    results_phase_value(name, sums[e]);
+    if (counted < 0.9999) {
+      char key[96];
+      printf("  %-24s %20llu  (scaled, counted %.1f%% of the time)\n", name,
+             sums[e], counted * 100);
+      snprintf(key, sizeof(key), "%s_counted", name);
+      results_phase_value(key, counted);
+    } else {
+      printf("  %-24s %20llu\n", name, sums[e]);
+    }
+  }
+  for (int t = 0; t < phase_counters.num_threads; ++t) {
+    const thread_counters *slot = &phase_counters.threads[t];
+    for (int e = 0; slot->valid && e < phase_counters.num_events; ++e) {
+      printf("Thread %d %s value = %llu\n", t, phase_counters.names[e],
+             slot->values[e]);
+    }
+  }
+}
+
+void counters_free(void) {
+  for (int t = 0; t < phase_counters.allocated; ++t) {
+    if (phase_counters.threads[t].tid) {
+      thread_close(&phase_counters.threads[t]);
+    }
+  }
+  free(phase_counters.threads);
+  phase_counters.threads = NULL;
+  phase_counters.allocated = 0;
+  phase_counters.num_threads = 0;
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef COUNTERS_H_
+#define COUNTERS_H_
+
+#include "meabo.h"
+
+/*
+ * Per-thread performance counters, through the PAPI low-level API
+ * (ENABLE_PAPI) or Linux perf_event_open (ENABLE_PERF_EVENTS).
+ *
+ * Each thread of a phase owns an event set, opened by counters_start before
+ * the phase is timed and kept open for the next phases. The kernels start and
+ * stop the event set of their thread and store its values in the slot of the
+ * thread, without any lock; counters_report prints and records the values
+ * once the phase is over.
+ *
+ * The events are split into groups that fit in the hardware counters (-H),
+ * which are either:
+ * - multiplexed: all groups are counted in turns during the phase, and each
+ *   value is scaled by the fraction of the time its group was counted;
+ * - repeated: the phase is run once per group, and only the last run is
+ *   timed; the values are exact.
+ */
+#define ENABLE_COUNTERS (ENABLE_PAPI || ENABLE_PERF_EVENTS)
+
+#define COUNTERS_MAX_EVENTS 64
+
+typedef enum counters_mode {
+  COUNTERS_MULTIPLEX = 0,
+  COUNTERS_REPEAT
+} counters_mode;
+
+typedef struct counter_group {
+  int first;
+  int num_events;
+} counter_group;
+
+typedef struct thread_counters {
+  pid_t tid;        /* thread that opened the event sets, 0 if none */
+  int valid;        /* values hold a reading of the current phase */
+#if ENABLE_PAPI
+  int event_sets[COUNTERS_MAX_EVENTS];  /* one per group */
+#else
+  int fds[COUNTERS_MAX_EVENTS];         /* group leaders first in a group */
+#endif
+  unsigned long long values[COUNTERS_MAX_EVENTS];
+  double running[COUNTERS_MAX_EVENTS];  /* fraction of the time counted */
+} __attribute__((aligned(64))) thread_counters;
+
+typedef struct counter_set {
+  int active;
+  counters_mode mode;
+  int num_events;
+  char **names;
+  int num_groups;
+  counter_group groups[COUNTERS_MAX_EVENTS];
+  int group;        /* group counted by the current run (repeat mode) */
+  int num_threads;
+  int allocated;
+  thread_counters *threads;
+} counter_set;
+
+int parse_counters_mode(const char *str, counters_mode *mode);
+
+int parse_event_spec(const char *spec, char ***names);
+
+#if ENABLE_COUNTERS
+extern counter_set phase_counters;
+
+int counters_init(char **names, const int num_events,
+                  const counters_mode mode, const int num_hwcntrs);
+
+void counters_start(const int num_threads);
+
+void counters_stop(void);
+
+int counters_next_run(void);
+
+void counters_thread_start(void);
+
+void counters_thread_stop(void);
+
+void counters_report(const int phase);
+
+void counters_free(void);
+#else
+static inline int counters_init(char **names, const int num_events,
+                                const counters_mode mode,
+                                const int num_hwcntrs) {
+  return 0;
+}
+static inline void counters_start(const int num_threads) {}
+static inline void counters_stop(void) {}
+static inline int counters_next_run(void) {
+  return 0;
+}
+static inline void counters_thread_start(void) {}
+static inline void counters_thread_stop(void) {}
+static inline void counters_report(const int phase) {}
+static inline void counters_free(void) {}
+#endif
+
+#endif /* COUNTERS_H_ */
@@ -0,0 +1,135 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "histogram.h"
+
+iter_timing phase_timing = { 0, 0, 0, NULL };
+
+/*
+ * Clears the histograms of num_threads threads and starts recording. The
+ * histograms are only reallocated when a phase uses more threads than any
+ * previous one.
+ */
+void timing_start(int num_threads) {
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  if (num_threads > phase_timing.allocated) {
+    free(phase_timing.threads);
+    if (posix_memalign((void **) &phase_timing.threads, 64,
+                       sizeof(latency_hist) * num_threads)) {
+      printf("Failed to allocate the iteration histograms\n");
+      exit(1);
+    }
+    phase_timing.allocated = num_threads;
+  }
+  memset(phase_timing.threads, 0, sizeof(latency_hist) * num_threads);
+  phase_timing.num_threads = num_threads;
+  phase_timing.active = 1;
+}
+
+void timing_stop(void) {
+  phase_timing.active = 0;
+}
+
+/* Middle of a bucket, i.e. the value it stands for. */
+static uint64_t hist_value(const int bucket) {
+  if (bucket < HIST_SUB_BUCKETS) {
+    return bucket;
+  }
+  const int shift = bucket / HIST_SUB_BUCKETS - 1;
+  const uint64_t lower = (uint64_t) (HIST_SUB_BUCKETS +
+                                     bucket % HIST_SUB_BUCKETS) << shift;
+  return lower + ((1ULL << shift) >> 1);
+}
+
+uint64_t hist_percentile(const latency_hist *hist, const double p) {
+  const uint64_t rank = ceil(p * hist->count);
+  uint64_t seen = 0;
+  for (int b = 0; b < HIST_NUM_BUCKETS; ++b) {
+    seen += hist->buckets[b];
+    if (seen >= rank && seen) {
+      const uint64_t value = hist_value(b);
+      return (value < hist->max_ns) ? value : hist->max_ns;
+    }
+  }
+  return hist->max_ns;
+}
+
+/*
+ * Percentiles of the iteration times of all threads, and imbalance between
+ * threads: the busy time (sum of the samples) of the slowest thread over the
+ * mean busy time. Returns 0 if nothing was recorded.
+ */
+int timing_summary(timing_stats *stats) {
+  latency_hist *all = calloc(1, sizeof(latency_hist));
+  uint64_t max_busy = 0, total_busy = 0;
+  memset(stats, 0, sizeof(timing_stats));
+  for (int t = 0; t < phase_timing.num_threads; ++t) {
+    const latency_hist *hist = &phase_timing.threads[t];
+    if (!hist->count) {
+      continue;
+    }
+    for (int b = 0; b < HIST_NUM_BUCKETS; ++b) {
+      all->buckets[b] += hist->buckets[b];
+    }
+    all->count += hist->count;
+    if (hist->max_ns > all->max_ns) {
+      all->max_ns = hist->max_ns;
+    }
+    if (hist->total_ns > max_busy) {
+      max_busy = hist->total_ns;
+      stats->slowest = t;
+    }
+    total_busy += hist->total_ns;
+    ++stats->num_threads;
+  }
+  stats->samples = all->count;
+  if (all->count) {
+    stats->p50 = hist_percentile(all, 0.5);
+    stats->p99 = hist_percentile(all, 0.99);
+    stats->p999 = hist_percentile(all, 0.999);
+    stats->max = all->max_ns;
+    stats->imbalance = total_busy ?
+        (double) max_busy * stats->num_threads / total_busy : 1.0;
+  }
+  free(all);
+  return stats->samples > 0;
+}
+
+void timing_report(int phase) {
+  timing_stats stats;
+  if (!timing_summary(&stats)) {
+    return;
+  }
+  printf("Phase %d iteration time (ns): p50 %llu p99 %llu p99.9 %llu "
+         "max %llu (%llu samples)\n", phase,
+         (unsigned long long) stats.p50, (unsigned long long) stats.p99,
+         (unsigned long long) stats.p999, (unsigned long long) stats.max,
+         (unsigned long long) stats.samples);
+  printf("Phase %d thread imbalance: %.3f (slowest thread %d of %d)\n",
+         phase, stats.imbalance, stats.slowest, stats.num_threads);
+}
+
+void timing_free(void) {
+  free(phase_timing.threads);
+  phase_timing.threads = NULL;
+  phase_timing.allocated = 0;
+}
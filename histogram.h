@@ -0,0 +1,127 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include "meabo.h"
+
+/*
+ * Log-linear (HDR style) histogram of durations in ns: one bucket per value
+ * below HIST_SUB_BUCKETS, then HIST_SUB_BUCKETS buckets per power of two, so
+ * values are kept with a relative error below 1/HIST_SUB_BUCKETS.
+ */
+#define HIST_SUB_BITS 5
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_NUM_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+typedef struct latency_hist {
+  int cpu;          /* CPU of the first sample */
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t buckets[HIST_NUM_BUCKETS];
+} __attribute__((aligned(64))) latency_hist;
+
+/*
+ * Per-iteration timings of the phase being run: one histogram per thread,
+ * allocated before the phase starts and only written by its thread.
+ */
+typedef struct iter_timing {
+  int active;
+  int num_threads;
+  int allocated;
+  latency_hist *threads;
+} iter_timing;
+
+extern iter_timing phase_timing;
+
+/* Summary of the samples of all threads. */
+typedef struct timing_stats {
+  uint64_t samples;
+  uint64_t p50, p99, p999, max;
+  double imbalance;
+  int slowest;
+  int num_threads;  /* threads with samples */
+} timing_stats;
+
+void timing_start(int num_threads);
+
+void timing_stop(void);
+
+uint64_t hist_percentile(const latency_hist *hist, const double p);
+
+int timing_summary(timing_stats *stats);
+
+void timing_report(int phase);
+
+void timing_free(void);
+
+/* CLOCK_MONOTONIC is read through the vDSO on Linux, without a system call. */
+static inline uint64_t timing_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+static inline int hist_bucket(const uint64_t ns) {
+  if (ns < HIST_SUB_BUCKETS) {
+    return ns;
+  }
+  const int e = 63 - __builtin_clzll(ns);
+  return (e - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS +
+         ((ns >> (e - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1));
+}
+
+static inline void timing_record(const uint64_t start) {
+  const uint64_t ns = timing_now() - start;
+#ifdef _OPENMP
+  const int thread = omp_get_thread_num();
+#else
+  const int thread = 0;
+#endif
+  if (!phase_timing.active || thread >= phase_timing.num_threads) {
+    return;
+  }
+  latency_hist *hist = &phase_timing.threads[thread];
+  if (!hist->count) {
+    hist->cpu = sched_getcpu();
+  }
+  ++hist->buckets[hist_bucket(ns)];
+  ++hist->count;
+  hist->total_ns += ns;
+  if (ns > hist->max_ns) {
+    hist->max_ns = ns;
+  }
+}
+
+/*
+ * Instrumentation of the iteration loops of compute_kernels.c: the time from
+ * ITER_TIMER_START to ITER_TIMER_STOP is one sample of the calling thread.
+ */
+#if ENABLE_HISTOGRAMS
+#define ITER_TIMER_START(t) const uint64_t t = timing_now()
+#define ITER_TIMER_STOP(t) timing_record(t)
+#else
+#define ITER_TIMER_START(t)
+#define ITER_TIMER_STOP(t)
+#endif
+
+#endif /* HISTOGRAM_H_ */
@@ -0,0 +1,556 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "init_data.h"
+
+#define INIT_PAGE_SIZE 4096
+
+#if ENABLE_BINDING
+/*
+ * Binds the calling thread exactly like the compute kernels do at the start
+ * of their parallel region.
+ */
+static void bind_init_thread(int num_cpus, const cpu_set_t *phase_cpu_id,
+                             int bind_to_cpu_set) {
+  if (bind_to_cpu_set) {
+    bind_to_cpu_w_reset(phase_cpu_id, num_cpus, 0);
+  } else {
+#ifdef _OPENMP
+    bind_to_available_cpu_w_reset(phase_cpu_id, num_cpus, 0,
+                                  omp_get_thread_num());
+#endif
+  }
+}
+#define INIT_BIND() bind_init_thread(num_cpus, phase_cpu_id, bind_to_cpu_set)
+#else
+#define INIT_BIND()
+#endif
+
+/*
+ * Data for phases 1 and 3.
+ */
+void init_vals(const long array_size, double *vals, int *int_vals,
+    int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    ) {
+  #pragma omp parallel shared(vals, int_vals) num_threads(num_threads)
+  {
+    INIT_BIND();
+    #pragma omp for schedule(static)
+    for (long i = 0; i < array_size; ++i) {
+      uint64_t r = rng_hash(RNG_VALS, i);
+      vals[i] = (rng_lo(r) % 1024) * cos(rng_hi(r) % 1024);
+      int_vals[i] = ceil(vals[i]);
+    }
+  }
+}
+
+/*
+ * Data for phases 2, 4 and 5.
+ */
+void init_vectors(const long array_size, double *dest, double *src1,
+    double *src2, int *ind_src1, int *ind_src2, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    ) {
+  #pragma omp parallel shared(dest, src1, src2, ind_src1, ind_src2) \
+    num_threads(num_threads)
+  {
+    INIT_BIND();
+    #pragma omp for schedule(static)
+    for (long i = 0; i < array_size; ++i) {
+      uint64_t r = rng_hash(RNG_SRC1, i);
+      src1[i] = (rng_lo(r) % 1024) * sin(rng_hi(r) % 1024);
+      r = rng_hash(RNG_SRC2, i);
+      src2[i] = (rng_lo(r) % 1024) * sin(rng_hi(r) % 1024);
+      r = rng_hash(RNG_DEST, i);
+      dest[i] = (rng_lo(r) % 1024) * cos(rng_hi(r) % 1024);
+      ind_src1[i] = rng_hash(RNG_IND_SRC1, i) % array_size;
+      ind_src2[i] = rng_hash(RNG_IND_SRC2, i) % array_size;
+    }
+  }
+}
+
+/*
+ * Data for phase 6. The matrix is generated in CSR format, each row by the
+ * thread that will multiply it, then converted to the format selected for
+ * the phase.
+ */
+void init_sparse_matrix(const int nrow, const int ncol,
+    sparse_matrix *matrix, const sparse_generator *gen, double *vect_in,
+    double *vect_out, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    ) {
+  #pragma omp parallel num_threads(num_threads) \
+    shared(matrix, vect_in, vect_out)
+  {
+    INIT_BIND();
+    #pragma omp for schedule(static)
+    for (int i = 0; i < ncol; ++i) {
+      uint64_t r = rng_hash(RNG_VECT_IN, i);
+      vect_in[i] = (rng_lo(r) % 1024) * sin(rng_hi(r) % 1024);
+    }
+
+    #pragma omp for schedule(static)
+    for (int i = 0; i < nrow; ++i) {
+      vect_out[i] = 0;
+    }
+
+    sparse_generate(matrix, gen);
+    sparse_convert(matrix);
+  }
+}
+
+/*
+ * Parses a linked list layout of the form <order>[:<stride>][,huge], where
+ * <order> is one of sequential, strided or shuffled. The string "huge" on its
+ * own selects a sequential list backed by huge pages. Returns 0 on success.
+ */
+int parse_llist_layout(const char *str, llist_layout *layout) {
+  char order[32] = "";
+  const char *huge = strstr(str, "huge");
+
+  layout->order = LLIST_SEQUENTIAL;
+  layout->stride = LLIST_DEFAULT_STRIDE;
+  layout->hugepages = (huge != NULL);
+
+  sscanf(str, "%31[a-z]", order);
+  if (!strcmp(order, "sequential") || !strcmp(order, "huge")) {
+    layout->order = LLIST_SEQUENTIAL;
+  } else if (!strcmp(order, "strided")) {
+    layout->order = LLIST_STRIDED;
+    const char *stride = strchr(str, ':');
+    if (stride) {
+      layout->stride = atol(stride + 1);
+    }
+    if (layout->stride < 1) {
+      return -1;
+    }
+  } else if (!strcmp(order, "shuffled")) {
+    layout->order = LLIST_SHUFFLED;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+const char* llist_layout_name(const llist_layout *layout) {
+  switch (layout->order) {
+    case LLIST_STRIDED:
+      return "strided";
+    case LLIST_SHUFFLED:
+      return "shuffled";
+    default:
+      return "sequential";
+  }
+}
+
+/* Huge page lists use transparent huge pages, unless pages are given */
+static mem_policy llist_policy(const llist_layout *layout,
+                               const mem_policy *policy) {
+  mem_policy arena_policy = *policy;
+  if (layout->hugepages && arena_policy.pages == MEM_PAGES_DEFAULT) {
+    arena_policy.pages = MEM_PAGES_THP;
+  }
+  return arena_policy;
+}
+
+static linked_list* alloc_arena(const long llist_size, const int i,
+                                const mem_policy *policy) {
+  linked_list *nodes = mem_alloc(sizeof(linked_list) * llist_size, policy);
+  if (nodes == NULL) {
+    printf("Unable to allocate linked list %d\n", i);
+    exit(1);
+  }
+  return nodes;
+}
+
+/*
+ * Data for phase 7. List i is built by thread i, which is the thread that
+ * traverses it in phase 7. The nodes of a list live in a single arena; the
+ * first node of the arena is always the head of the list, and the value of
+ * each node is its position in the traversal order.
+ */
+void init_llist(const long llist_size, const int num_lists,
+    linked_list **llist, const llist_layout *layout, const mem_policy *policy,
+    int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    ) {
+  const mem_policy arena_policy = llist_policy(layout, policy);
+  #pragma omp parallel shared(llist) num_threads(num_threads)
+  {
+    INIT_BIND();
+    #pragma omp for schedule(static, 1)
+    for (int i = 0; i < num_lists; ++i) {
+      linked_list *nodes = alloc_arena(llist_size, i, &arena_policy);
+      llist[i] = nodes;
+
+      if (layout->order == LLIST_SHUFFLED) {
+        /*
+         * Sattolo's algorithm yields a random permutation made of a single
+         * cycle. The successor indices are kept in the next fields until the
+         * cycle is cut open after its last node and turned into pointers.
+         */
+        for (long j = 0; j < llist_size; ++j) {
+          nodes[j].next = (linked_list*) (uintptr_t) j;
+        }
+        for (long j = llist_size - 1; j > 0; --j) {
+          long k = rng_hash(RNG_LLIST, ((uint64_t) i << 40) | j) % j;
+          linked_list *tmp = nodes[j].next;
+          nodes[j].next = nodes[k].next;
+          nodes[k].next = tmp;
+        }
+        long cur = 0;
+        for (long j = 0; j < llist_size; ++j) {
+          long next = (long) (uintptr_t) nodes[cur].next;
+          nodes[cur].value = j;
+          nodes[cur].next = (j == llist_size - 1) ? NULL : &nodes[next];
+          cur = next;
+        }
+      } else {
+        const long stride = (layout->order == LLIST_STRIDED) ?
+                            layout->stride : 1;
+        long cur = 0, offset = 0;
+        for (long j = 0; j < llist_size; ++j) {
+          long next = cur + stride;
+          if (next >= llist_size) {
+            next = ++offset;
+          }
+          nodes[cur].value = j;
+          nodes[cur].next = (j == llist_size - 1) ? NULL : &nodes[next];
+          cur = next;
+        }
+      }
+    }
+  }
+}
+
+/*
+ * Arenas of the phase 7 lists for the latency ladder, left untouched:
+ * init_chains links their nodes, from the thread that traverses them.
+ */
+void alloc_llist(const long llist_size, const int num_lists,
+    linked_list **llist, const llist_layout *layout,
+    const mem_policy *policy) {
+  const mem_policy arena_policy = llist_policy(layout, policy);
+  for (int i = 0; i < num_lists; ++i) {
+    llist[i] = alloc_arena(llist_size, i, &arena_policy);
+  }
+}
+
+/*
+ * Chains of the phase 7 latency ladder (-j), rebuilt in the list arenas for
+ * each size. The first size bytes of the arena of list i are cut into slots
+ * of stride bytes, and the nodes at the start of the slots are linked in a
+ * random single cycle (Sattolo's algorithm), so consecutive loads hit
+ * unrelated cache lines and pages. starts[i * LATENCY_MAX_CHAINS + c] is the
+ * node at c / LATENCY_MAX_CHAINS of the cycle, where chain c starts.
+ */
+void init_chains(const long size, const long stride, const int num_lists,
+    linked_list **llist, linked_list **starts, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    ) {
+  const long num_slots = size / stride;
+  const long slot_nodes = stride / sizeof(linked_list);
+  #pragma omp parallel shared(llist, starts) num_threads(num_threads)
+  {
+    INIT_BIND();
+    #pragma omp for schedule(static, 1)
+    for (int i = 0; i < num_lists; ++i) {
+      linked_list *nodes = llist[i];
+      linked_list **list_starts = starts + i * LATENCY_MAX_CHAINS;
+      for (long j = 0; j < num_slots; ++j) {
+        nodes[j * slot_nodes].next = (linked_list*) (uintptr_t) j;
+      }
+      for (long j = num_slots - 1; j > 0; --j) {
+        long k = rng_hash(RNG_CHAINS, ((uint64_t) i << 40) | j) % j;
+        linked_list *tmp = nodes[j * slot_nodes].next;
+        nodes[j * slot_nodes].next = nodes[k * slot_nodes].next;
+        nodes[k * slot_nodes].next = tmp;
+      }
+      long cur = 0;
+      int chain = 0;
+      for (long j = 0; j < num_slots; ++j) {
+        long next = (long) (uintptr_t) nodes[cur * slot_nodes].next;
+        while (chain < LATENCY_MAX_CHAINS &&
+               chain * num_slots / LATENCY_MAX_CHAINS == j) {
+          list_starts[chain++] = &nodes[cur * slot_nodes];
+        }
+        nodes[cur * slot_nodes].value = j;
+        nodes[cur * slot_nodes].next = &nodes[next * slot_nodes];
+        cur = next;
+      }
+    }
+  }
+}
+
+/*
+ * Releases the lists built by init_llist or alloc_llist.
+ */
+void free_llist(const int num_lists, linked_list **llist) {
+  for (int i = 0; i < num_lists; ++i) {
+    mem_free(llist[i]);
+  }
+}
+
+/*
+ * Parses a Phase 8 mode of the form neighbour, allpairs or cells[:cutoff].
+ * Returns 0 on success.
+ */
+int parse_phase8_spec(const char *str, phase8_spec *spec) {
+  spec->cutoff = PHASE8_DEFAULT_CUTOFF;
+  if (!strcmp(str, "neighbour")) {
+    spec->mode = PHASE8_NEIGHBOUR;
+  } else if (!strcmp(str, "allpairs")) {
+    spec->mode = PHASE8_ALLPAIRS;
+  } else if (!strncmp(str, "cells", 5)) {
+    spec->mode = PHASE8_CELLS;
+    sscanf(str, "cells:%lf", &spec->cutoff);
+    if (spec->cutoff <= 0) {
+      return -1;
+    }
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+const char* phase8_mode_name(const phase8_mode mode) {
+  switch (mode) {
+    case PHASE8_ALLPAIRS:
+      return "all pairs";
+    case PHASE8_CELLS:
+      return "cell list";
+    default:
+      return "neighbour";
+  }
+}
+
+/*
+ * Allocates the particle arrays, page-aligned, without touching them.
+ */
+particle_set* alloc_particles(const int num_particles,
+                              const mem_policy *policy) {
+  particle_set *particles = calloc(1, sizeof(particle_set));
+  double **arrays[] = { &particles->x, &particles->y, &particles->z,
+                        &particles->charge };
+  particles->num_particles = num_particles;
+  for (int i = 0; i < 4; ++i) {
+    if (!(*arrays[i] = mem_alloc(sizeof(double) * num_particles, policy))) {
+      printf("Unable to allocate particles\n");
+      exit(1);
+    }
+  }
+  return particles;
+}
+
+void free_particles(particle_set *particles) {
+  if (particles == NULL) {
+    return;
+  }
+  mem_free(particles->x);
+  mem_free(particles->y);
+  mem_free(particles->z);
+  mem_free(particles->charge);
+  free(particles->cell_start);
+  free(particles);
+}
+
+/*
+ * Particle i, as a function of i only.
+ */
+static void particle_values(const long i, double *x, double *y, double *z,
+                            double *charge) {
+  *x = PHASE8_DOMAIN * rng_unit(rng_hash(RNG_PARTICLES, 4 * (uint64_t) i));
+  *y = PHASE8_DOMAIN * rng_unit(rng_hash(RNG_PARTICLES, 4 * (uint64_t) i + 1));
+  *z = PHASE8_DOMAIN * rng_unit(rng_hash(RNG_PARTICLES, 4 * (uint64_t) i + 2));
+  *charge = sin(rng_hi(rng_hash(RNG_PARTICLES, 4 * (uint64_t) i + 3)) % 1024);
+}
+
+static int particle_cell_coord(const double x, const int cells_per_dim) {
+  int c = x * cells_per_dim / PHASE8_DOMAIN;
+  return (c < cells_per_dim) ? c : cells_per_dim - 1;
+}
+
+/*
+ * Sorts the particles by cell (a counting sort, stable in particle order).
+ * Fills the cell list of particles and returns the order in which the
+ * particles are to be stored.
+ */
+static int* particles_cell_order(particle_set *particles, const double cutoff) {
+  const int num_particles = particles->num_particles;
+  int n = PHASE8_DOMAIN / cutoff;
+  n = (n < 1) ? 1 : (n > PHASE8_MAX_CELLS_PER_DIM) ?
+                    PHASE8_MAX_CELLS_PER_DIM : n;
+  const int num_cells = n * n * n;
+  int *cell = malloc(sizeof(int) * num_particles);
+  int *order = malloc(sizeof(int) * num_particles);
+
+  particles->cells_per_dim = n;
+  particles->cell_start = calloc(num_cells + 1, sizeof(int));
+  for (int i = 0; i < num_particles; ++i) {
+    double x, y, z, charge;
+    particle_values(i, &x, &y, &z, &charge);
+    cell[i] = (particle_cell_coord(z, n) * n + particle_cell_coord(y, n)) * n +
+              particle_cell_coord(x, n);
+    ++particles->cell_start[cell[i] + 1];
+  }
+  for (int c = 0; c < num_cells; ++c) {
+    particles->cell_start[c + 1] += particles->cell_start[c];
+  }
+  int *fill = malloc(sizeof(int) * num_cells);
+  memcpy(fill, particles->cell_start, sizeof(int) * num_cells);
+  for (int i = 0; i < num_particles; ++i) {
+    order[fill[cell[i]]++] = i;
+  }
+  free(fill);
+  free(cell);
+  return order;
+}
+
+/*
+ * Data for phase 8. In the cell list mode the particles are stored sorted by
+ * cell.
+ */
+void init_particles(particle_set *particles, const phase8_spec *spec,
+    int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    ) {
+  const int num_particles = particles->num_particles;
+  int *order = NULL;
+  if (spec->mode == PHASE8_CELLS) {
+    order = particles_cell_order(particles, spec->cutoff);
+  }
+
+  #pragma omp parallel shared(particles, order) num_threads(num_threads)
+  {
+    INIT_BIND();
+    #pragma omp for schedule(static)
+    for (int i = 0; i < num_particles; ++i) {
+      particle_values(order ? order[i] : i, &particles->x[i],
+                      &particles->y[i], &particles->z[i],
+                      &particles->charge[i]);
+    }
+  }
+  free(order);
+}
+
+/* Parses a Phase 9 mode: constructive or bruteforce. Returns 0 on success. */
+int parse_phase9_mode(const char *str, phase9_mode *mode) {
+  if (!strcmp(str, "constructive")) {
+    *mode = PHASE9_CONSTRUCTIVE;
+  } else if (!strcmp(str, "bruteforce")) {
+    *mode = PHASE9_BRUTEFORCE;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+const char* phase9_mode_name(const phase9_mode mode) {
+  return (mode == PHASE9_BRUTEFORCE) ? "bruteforce" : "constructive";
+}
+
+/*
+ * Parses a Phase 10 update mode of the form atomic|racy[:batch]. Returns 0
+ * on success.
+ */
+int parse_gups_spec(const char *str, gups_spec *spec) {
+  spec->batch = 0;
+  if (!strncmp(str, "atomic", 6)) {
+    spec->update = GUPS_ATOMIC;
+    sscanf(str, "atomic:%d", &spec->batch);
+  } else if (!strncmp(str, "racy", 4)) {
+    spec->update = GUPS_RACY;
+    sscanf(str, "racy:%d", &spec->batch);
+  } else {
+    return -1;
+  }
+  return (spec->batch < 0 || spec->batch > GUPS_MAX_BATCH) ? -1 : 0;
+}
+
+const char* gups_update_name(const gups_update update) {
+  return (update == GUPS_RACY) ? "racy" : "atomic";
+}
+
+/*
+ * Smallest power of two not below num_entries, so that indices are masked
+ * instead of computed with a modulo.
+ */
+long gups_table_size(const long num_entries) {
+  long size = 1;
+  while (size < num_entries) {
+    size <<= 1;
+  }
+  return size;
+}
+
+/*
+ * Data for phase 10: table[i] = i, as in HPCC RandomAccess.
+ */
+void init_gups_table(const long table_size, uint64_t *table, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    ) {
+  #pragma omp parallel shared(table) num_threads(num_threads)
+  {
+    INIT_BIND();
+    #pragma omp for schedule(static)
+    for (long i = 0; i < table_size; ++i) {
+      table[i] = i;
+    }
+  }
+}
+
+/*
+ * Zeroes a buffer page by page, so that the pages are spread over the
+ * threads of the phase in the same way as a static loop schedule.
+ */
+void init_zero(void *buf, const size_t size, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    ) {
+  char *bytes = buf;
+  const long num_pages = (size + INIT_PAGE_SIZE - 1) / INIT_PAGE_SIZE;
+  #pragma omp parallel shared(bytes) num_threads(num_threads)
+  {
+    INIT_BIND();
+    #pragma omp for schedule(static)
+    for (long i = 0; i < num_pages; ++i) {
+      size_t offset = i * INIT_PAGE_SIZE;
+      size_t len = size - offset < INIT_PAGE_SIZE ? size - offset :
+                                                    INIT_PAGE_SIZE;
+      memset(bytes + offset, 0, len);
+    }
+  }
+}
@@ -0,0 +1,161 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef INIT_DATA_H_
+#define INIT_DATA_H_
+
+#include "meabo.h"
+#include "util.h"
+#include "rng.h"
+#include "sparse.h"
+#include "sparse_gen.h"
+#include "memory.h"
+
+/*
+ * Parallel data initialisation.
+ *
+ * Each function fills the data of one or more phases using the same number of
+ * threads, CPU set and binding as the phase that consumes it, and the same
+ * static distribution of loop iterations as the compute kernels. This way,
+ * the pages are first touched (and hence placed) by the threads that will use
+ * them. All random data comes from the counter-based generator in rng.h, so
+ * the contents do not depend on the number of threads.
+ */
+
+/*
+ * Node orderings for the phase 7 linked lists. All nodes of a list are carved
+ * out of a single arena, and the order only decides how the next pointers
+ * walk through that arena:
+ * - sequential: node k links to node k + 1;
+ * - strided: the arena is walked with a fixed stride (in nodes), wrapping
+ *   around with an offset of one node, so consecutive nodes are a stride apart;
+ * - shuffled: a random single-cycle permutation of the whole arena (a
+ *   dependent pointer chase that defeats the hardware prefetchers).
+ * Any ordering can additionally be backed by (transparent) huge pages.
+ */
+typedef enum llist_order {
+  LLIST_SEQUENTIAL = 0,
+  LLIST_STRIDED,
+  LLIST_SHUFFLED
+} llist_order;
+
+typedef struct llist_layout {
+  llist_order order;
+  long stride;
+  int hugepages;
+} llist_layout;
+
+#define LLIST_DEFAULT_STRIDE (4096 / sizeof(linked_list))
+
+int parse_llist_layout(const char *str, llist_layout *layout);
+
+const char* llist_layout_name(const llist_layout *layout);
+
+void init_vals(const long array_size, double *vals, int *int_vals,
+    int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    );
+
+void init_vectors(const long array_size, double *dest, double *src1,
+    double *src2, int *ind_src1, int *ind_src2, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    );
+
+void init_sparse_matrix(const int nrow, const int ncol,
+    sparse_matrix *matrix, const sparse_generator *gen, double *vect_in,
+    double *vect_out, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    );
+
+void init_llist(const long llist_size, const int num_lists,
+    linked_list **llist, const llist_layout *layout, const mem_policy *policy,
+    int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    );
+
+void alloc_llist(const long llist_size, const int num_lists,
+    linked_list **llist, const llist_layout *layout,
+    const mem_policy *policy);
+
+void init_chains(const long size, const long stride, const int num_lists,
+    linked_list **llist, linked_list **starts, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    );
+
+void free_llist(const int num_lists, linked_list **llist);
+
+/*
+ * Phase 8 particles are spread uniformly over a cube of side PHASE8_DOMAIN.
+ * The cell list covers the cube with at most PHASE8_MAX_CELLS_PER_DIM cells
+ * per dimension, each at least as wide as the cutoff.
+ */
+#define PHASE8_DOMAIN 1024.0
+#define PHASE8_DEFAULT_CUTOFF 32.0
+#define PHASE8_MAX_CELLS_PER_DIM 128
+
+int parse_phase8_spec(const char *str, phase8_spec *spec);
+
+const char* phase8_mode_name(const phase8_mode mode);
+
+particle_set* alloc_particles(const int num_particles,
+                              const mem_policy *policy);
+
+void init_particles(particle_set *particles, const phase8_spec *spec,
+    int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    );
+
+void free_particles(particle_set *particles);
+
+int parse_phase9_mode(const char *str, phase9_mode *mode);
+
+const char* phase9_mode_name(const phase9_mode mode);
+
+int parse_gups_spec(const char *str, gups_spec *spec);
+
+const char* gups_update_name(const gups_update update);
+
+long gups_table_size(const long num_entries);
+
+void init_gups_table(const long table_size, uint64_t *table, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    );
+
+void init_zero(void *buf, const size_t size, int num_threads
+#if ENABLE_BINDING
+    , int num_cpus, const cpu_set_t *phase_cpu_id, int bind_to_cpu_set
+#endif
+    );
+
+#endif /* INIT_DATA_H_ */
@@ -22,6 +22,14 @@
 #include "compute_kernels.h"
 #include "validation.h"
 #include "util.h"
+#include "init_data.h"
+#include "histogram.h"
+#include "counters.h"
+#include "results.h"
+#include "roofline.h"
+#include "phases.h"
+#include "topology.h"
+#include "memory.h"
 
 int main(int argc, char** argv) {
   printf("Meabo v1.0\n");
@@ -34,33 +42,72 @@ int main(int argc, char** argv) {
 
   // Default values
   int num_iterations = 1000;
+  /*
+   * Target duration of each phase in seconds (-t): when set, the iterations
+   * of the phase are calibrated to it instead of num_iterations.
+   */
+  double phase_target[NUM_PHASES + 1] = { 0 };
+  /*
+   * Untimed warm-up runs (-W) and measured runs (-n) of each phase. With a
+   * stable_ci (in % of the mean), the runs stop once the 95% confidence
+   * interval of their mean duration is within it.
+   */
+  int num_warmup = 0, num_runs = 1;
+  double stable_ci = 0;
   long array_size = 1 << 20;
   long llist_size = 1 << 24;
   int nrow = 1 << 14;
   int ncol = 1 << 14;
   int num_particles = 1 << 20;
   int num_palindromes = 1 << 10;
-  int num_randomloc = 1 << 21;
+  long num_randomloc = 1 << 21;
+  llist_layout llist_layout = { LLIST_SEQUENTIAL, LLIST_DEFAULT_STRIDE, 0 };
+  sparse_format_spec sparse_spec = { SPARSE_CSR, SPARSE_DEFAULT_CHUNK,
+                                     SPARSE_DEFAULT_SIGMA,
+                                     SPARSE_DEFAULT_BLOCK };
+  sparse_generator sparse_gen = { SPARSE_GEN_RANDOM, 0, NULL };
+  phase8_spec phase8_spec = { PHASE8_NEIGHBOUR, PHASE8_DEFAULT_CUTOFF };
+  phase9_mode phase9_mode = PHASE9_CONSTRUCTIVE;
+  gups_spec gups_spec = { GUPS_ATOMIC, 0 };
+  simd_isa simd_isa = simd_detect();
+  int simd_forced = 0;
 
   // Data structure initialisation
-  int print = 1;
   double reduction_var = 0;
   int block_size = 8;
-  int i = 0, j = 0, k = 0, col = 0;
-  register double temp1 = 1.0, temp2 = 1.0, temp3 = 1.0;
-  register int int_temp1 = 1, int_temp2 = 1, int_temp3 = 1;
+  int k = 0;
+#if FULL_VALIDATION || ENABLE_PAPI
+  int i = 0;
+#endif
   struct timespec t1, t2;
   unsigned long long total_exec_time = 0;
+  /* Peaks for the roofline summary */
+  int roofline = 0;
+  roofline_peak roofline_peak = { 1, 0, 0 };
   /*
-   * The CPU IDs have the following format:  
-   * - the bits corresponding to the CPUs on which the phase is to be run 
-   * should be set to 1. The input is the decimal representation.
+   * The CPU IDs have the following format (see parse_cpu_list):
+   * - all (or -1): all the CPUs;
+   * - a cpulist, e.g. 0-3,8-11, whose items can also be node<N>,
+   *   package<N>, big or little;
+   * - a hexadecimal mask, e.g. 0xf0.
+   * phase_cpu_id[p] is the CPU set of phase p (1 to 10), NULL for all the
+   * CPUs. num_cpus is 0 until it is read from the affinity of the process.
    */
-  int num_cpus = 6, phase1_cpu_id = -1, phase2_cpu_id = -1,
-      phase3_cpu_id = -1, phase4_cpu_id = -1, phase5_cpu_id = -1,
-      phase6_cpu_id = -1, phase7_cpu_id = -1, phase8_cpu_id = -1,
-      phase9_cpu_id = -1, phase10_cpu_id = -1;
+  int num_cpus = 0;
+  char *phase_cpu_list[NUM_PHASES + 1] = { NULL };
+  cpu_set_t *phase_cpu_id[NUM_PHASES + 1] = { NULL };
   int bind_to_cpu_set = 1;
+  /* Order in which threads bound to one CPU take the CPUs of their set */
+  placement thread_placement = PLACEMENT_LINEAR;
+  /*
+   * NUMA placement and page size of the data of each phase (see memory.h),
+   * first-touch on default pages by default. Shared data follows the first
+   * phase that uses it, like its initialisation.
+   */
+  mem_policy phase_mem[NUM_PHASES + 1] = {
+    { MEM_FIRST_TOUCH, 0, MEM_PAGES_DEFAULT } };
+  mem_policy vals_mem, vectors_mem, matrix_mem, llist_mem, particles_mem,
+             palindromes_mem, randomloc_mem;
   /*
    * For now, we only support 32 phases. Will extend in the future, 
    * if necessary. 
@@ -70,6 +117,27 @@ int main(int argc, char** argv) {
    * is the decimal representation)
    */
   unsigned int run_phases = 0;
+  /*
+   * Steps to run (see phases.h): the phases of run_phases in order, or the
+   * steps of a run script (-S), with the data of all the steps initialised
+   * once. Consecutive steps of a corun group are co-scheduled.
+   */
+  char *run_script = NULL;
+  phase_step defaults[NUM_PHASES + 1];
+  phase_step *steps = NULL;
+  int num_steps = 0, corun_steps = 0;
+  /*
+   * Working-set sweep (-w, see phases.h): the phase is run over a series of
+   * sizes instead of the steps, on its data sized for the largest one.
+   */
+  char *sweep_arg = NULL;
+  sweep_spec sweep = { 0, 0, 0, 0 };
+  /*
+   * Latency ladder (-j, see phases.h): pointer chains in the phase 7 lists,
+   * which are sized for the largest size, instead of the steps.
+   */
+  char *latency_arg = NULL;
+  latency_spec latency;
   /* 
    * This variable controls how many threads the application will be using. 
    * Format:
@@ -80,6 +148,12 @@ int main(int argc, char** argv) {
    * get_num_threads.
    */
   int num_threads = 0; 
+  /* File to write the results to, in JSON Lines or CSV */
+  char *results_path = NULL;
+#if ENABLE_ENERGY
+  /* Energy source (see read_energy.h) */
+  char *energy_spec = "none";
+#endif
   /*
    * Data structures for the compute kernels.
    */
@@ -87,16 +161,17 @@ int main(int argc, char** argv) {
          * restrict src2 = NULL, * restrict dest = NULL, 
          * restrict forces = NULL;
   int * restrict int_vals = NULL, * restrict ind_src1 = NULL, 
-      * restrict ind_src2 = NULL, * restrict randomloc = NULL;
-  int ** restrict sparse_matrix_indeces = NULL;
-  double ** restrict sparse_matrix_values = NULL;
-  int * restrict sparse_matrix_nonzeros = NULL;
+      * restrict ind_src2 = NULL;
+  uint64_t *randomloc = NULL;
+  sparse_matrix *matrix = NULL;
   double * restrict vect_in = NULL, * restrict vect_out = NULL;
   linked_list ** llist = NULL;
-  particle * restrict particles = NULL;
+  /* Phase 7 lists, one per thread */
+  int num_lists = 0;
+  particle_set *particles = NULL;
   unsigned long * restrict palindromes = NULL;
 
-#if ENABLE_PAPI
+#if ENABLE_COUNTERS
   /*
    * We are using 7 counters by default, as that is the number of counters
    * of the ARM Cortex-A57 and ARM Cortex-A53, on which we developed this 
@@ -104,13 +179,20 @@ int main(int argc, char** argv) {
    * one cycle counter.
    */
   unsigned int num_hwcntrs = 7;
+  /* Events to count (see counters.h), and how to count more than fit */
+  char *event_spec = NULL;
+  char **event_names = NULL;
+  int num_events = 0;
+  counters_mode counters_mode = COUNTERS_MULTIPLEX;
+#endif
+#if ENABLE_PAPI
   PAPI_info *papi_info = NULL;
 #endif
 
 
   // Parse arguments
   while ((k = getopt(argc, argv, 
-		     "s:r:c:i:b:C:1:2:3:4:5:6:7:8:9:0:H:P:T:B:l:p:x:R:h")) != -1) {
+		     "s:r:c:F:G:M:V:N:Y:U:i:b:C:1:2:3:4:5:6:7:8:9:0:H:P:T:B:l:L:p:x:R:o:k:E:e:m:S:w:j:t:n:W:A:D:Z:h")) != -1) {
     switch(k) {
       case 's':
         array_size = atoll(optarg);
@@ -121,6 +203,47 @@ int main(int argc, char** argv) {
       case 'c':
         ncol = atoi(optarg);
         break;
+      case 'G':
+        if (parse_sparse_generator(optarg, &sparse_gen)) {
+          printf("Invalid sparse matrix generator %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'M':
+        sparse_gen.type = SPARSE_GEN_MTX;
+        sparse_gen.path = optarg;
+        break;
+      case 'Y':
+        if (parse_phase9_mode(optarg, &phase9_mode)) {
+          printf("Invalid phase 9 mode %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'U':
+        if (parse_gups_spec(optarg, &gups_spec)) {
+          printf("Invalid phase 10 update mode %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'N':
+        if (parse_phase8_spec(optarg, &phase8_spec)) {
+          printf("Invalid phase 8 mode %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'V':
+        if (parse_simd_isa(optarg, &simd_isa)) {
+          printf("Invalid vector ISA %s\n", optarg);
+          exit(1);
+        }
+        simd_forced = strcmp(optarg, "auto");
+        break;
+      case 'F':
+        if (parse_sparse_format(optarg, &sparse_spec)) {
+          printf("Invalid sparse matrix format %s\n", optarg);
+          exit(1);
+        }
+        break;
       case 'i':
         num_iterations = atoi(optarg);
         break;
@@ -130,43 +253,122 @@ int main(int argc, char** argv) {
       case 'C':
         num_cpus = atoi(optarg);
         break;
-      case '1':
-        phase1_cpu_id = atoi(optarg);
+      case '1': case '2': case '3': case '4': case '5':
+      case '6': case '7': case '8': case '9':
+        phase_cpu_list[k - '0'] = optarg;
+        break;
+      case '0':
+        phase_cpu_list[10] = optarg;
         break;
-      case '2':
-        phase2_cpu_id = atoi(optarg);
+#if ENABLE_COUNTERS
+      case 'H':
+        num_hwcntrs = atoi(optarg);
         break;
-      case '3':
-        phase3_cpu_id = atoi(optarg);
+      case 'e':
+        event_spec = optarg;
         break;
-      case '4':
-        phase4_cpu_id = atoi(optarg);
+      case 'm':
+        if (parse_counters_mode(optarg, &counters_mode)) {
+          exit(1);
+        }
         break;
-      case '5':
-        phase5_cpu_id = atoi(optarg);
+#endif
+      case 'P':
+        run_phases = atoi(optarg);
         break;
-      case '6':
-        phase6_cpu_id = atoi(optarg);
+      case 'S':
+        run_script = optarg;
         break;
-      case '7':
-        phase7_cpu_id = atoi(optarg);
+      case 'w':
+        if (parse_sweep_spec(optarg, &sweep)) {
+          printf("Invalid sweep %s\n", optarg);
+          exit(1);
+        }
+        sweep_arg = optarg;
         break;
-      case '8':
-        phase8_cpu_id = atoi(optarg);
+      case 'j':
+        if (parse_latency_spec(optarg, &latency)) {
+          printf("Invalid latency ladder %s\n", optarg);
+          exit(1);
+        }
+        latency_arg = optarg;
         break;
-      case '9':
-        phase9_cpu_id = atoi(optarg);
+      case 'D':
+      case 'Z': {
+        /* [<phase>=]<value>, for all the phases without a phase */
+        const char *value = strchr(optarg, '=');
+        mem_policy parsed;
+        int first = 1, last = NUM_PHASES;
+        if (value) {
+          first = last = atoi(optarg);
+        }
+        value = value ? value + 1 : optarg;
+        if (first < 1 || first > NUM_PHASES ||
+            ((k == 'D') ? parse_mem_policy(value, &parsed) :
+                          parse_mem_pages(value, &parsed.pages))) {
+          printf("Invalid memory %s %s\n",
+                 (k == 'D') ? "placement" : "pages", optarg);
+          exit(1);
+        }
+        for (int p = first; p <= last; ++p) {
+          if (k == 'D') {
+            phase_mem[p].placement = parsed.placement;
+            phase_mem[p].nodes = parsed.nodes;
+          } else {
+            phase_mem[p].pages = parsed.pages;
+          }
+        }
         break;
-      case '0':
-        phase10_cpu_id = atoi(optarg);
+      }
+      case 't': {
+        /* [<phase>=]<seconds>, for all the phases without a phase */
+        const char *value = strchr(optarg, '=');
+        char *end;
+        int first = 1, last = NUM_PHASES;
+        if (value) {
+          first = last = atoi(optarg);
+        }
+        value = value ? value + 1 : optarg;
+        const double seconds = strtod(value, &end);
+        if (first < 1 || first > NUM_PHASES || seconds < 0 || *end ||
+            end == value) {
+          printf("Invalid target duration %s\n", optarg);
+          exit(1);
+        }
+        for (int p = first; p <= last; ++p) {
+          phase_target[p] = seconds;
+        }
         break;
-#if ENABLE_PAPI
-      case 'H':
-        num_hwcntrs = atoi(optarg);
+      }
+      case 'n': {
+        /* <runs>[:<confidence interval %>] */
+        char *end;
+        num_runs = strtol(optarg, &end, 10);
+        stable_ci = 0;
+        if (*end == ':') {
+          const char *ci = end + 1;
+          stable_ci = strtod(ci, &end);
+          if (end == ci || stable_ci <= 0) {
+            num_runs = 0;
+          }
+        }
+        if (num_runs < 1 || *end) {
+          printf("Invalid runs %s\n", optarg);
+          exit(1);
+        }
         break;
-#endif
-      case 'P':
-        run_phases = atoi(optarg);
+      }
+      case 'W':
+        if ((num_warmup = atoi(optarg)) < 0) {
+          printf("Invalid warm-up runs %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'A':
+        if (parse_placement(optarg, &thread_placement)) {
+          printf("Invalid thread placement %s\n", optarg);
+          exit(1);
+        }
         break;
       case 'T':
         num_threads = atoi(optarg);
@@ -177,6 +379,12 @@ int main(int argc, char** argv) {
       case 'l':
         llist_size = atol(optarg);
         break;
+      case 'L':
+        if (parse_llist_layout(optarg, &llist_layout)) {
+          printf("Invalid linked list layout %s\n", optarg);
+          exit(1);
+        }
+        break;
       case 'p':
         num_particles = atoi(optarg);
         break;
@@ -184,7 +392,22 @@ int main(int argc, char** argv) {
         num_palindromes = atoi(optarg);
         break;
       case 'R':
-        num_randomloc = atoi(optarg);
+        num_randomloc = atol(optarg);
+        break;
+      case 'o':
+        results_path = optarg;
+        break;
+#if ENABLE_ENERGY
+      case 'E':
+        energy_spec = optarg;
+        break;
+#endif
+      case 'k':
+        if (parse_roofline_peak(optarg, &roofline_peak)) {
+          printf("Invalid roofline peaks %s\n", optarg);
+          exit(1);
+        }
+        roofline = 1;
         break;
       case 'h':
         usage(argv);
@@ -195,67 +418,308 @@ int main(int argc, char** argv) {
     }
   }
 
+  num_cpus = init_cpus(num_cpus);
+  topology_set_placement(thread_placement);
+  for (k = 1; k <= NUM_PHASES; ++k) {
+    if (phase_cpu_list[k] &&
+        parse_cpu_list(phase_cpu_list[k], &phase_cpu_id[k])) {
+      exit(1);
+    }
+  }
+  for (k = 0; k <= NUM_PHASES; ++k) {
+    phase_step step = { k, num_iterations, num_threads, phase_cpu_id[k],
+                        num_runs, 0, 0, 0, phase_target[k], num_warmup,
+                        stable_ci };
+    defaults[k] = step;
+  }
+  if (latency_arg) {
+    if (run_script || sweep.phase) {
+      printf("A latency ladder cannot be combined with a run script or a "
+             "sweep\n");
+      exit(1);
+    }
+    run_phases = 1 << 6;
+    llist_size = (latency.max_bytes + sizeof(linked_list) - 1) /
+                 sizeof(linked_list);
+  }
+  if (sweep.phase) {
+    if (run_script) {
+      printf("A sweep cannot be combined with a run script\n");
+      exit(1);
+    }
+    if (sweep.phase == 8 && phase8_spec.mode == PHASE8_CELLS) {
+      printf("The number of particles of phase 8 cannot be swept in the "
+             "cells mode\n");
+      exit(1);
+    }
+    run_phases = 1 << (sweep.phase - 1);
+    if (sweep.phase == 10 && sweep.max_size) {
+      sweep.max_size = gups_table_size(sweep.max_size);
+    }
+    if (sweep.phase <= 5 && sweep.max_size > array_size) {
+      array_size = sweep.max_size;
+    } else if (sweep.phase == 8 && sweep.max_size > num_particles) {
+      num_particles = sweep.max_size;
+    } else if (sweep.phase == 9 && sweep.max_size > num_palindromes) {
+      num_palindromes = sweep.max_size;
+    } else if (sweep.phase == 10 && sweep.max_size > num_randomloc) {
+      num_randomloc = sweep.max_size;
+    }
+  }
+  if (run_script) {
+    /*
+     * The data of each phase is sized for the largest step, and initialised
+     * with the CPU set of the first step that runs the phase.
+     */
+    if ((num_steps = parse_run_script(run_script, defaults, &steps)) < 0) {
+      exit(1);
+    }
+    run_phases = 0;
+    for (k = num_steps - 1; k >= 0; --k) {
+      const int phase = steps[k].phase;
+      if (phase == PHASE_IDLE) {
+        continue;
+      }
+      run_phases |= 1 << (phase - 1);
+      phase_cpu_id[phase] = steps[k].cpu_id;
+      if (phase == 8 && steps[k].size && phase8_spec.mode == PHASE8_CELLS) {
+        printf("The number of particles of phase 8 cannot be set per step "
+               "in the cells mode\n");
+        exit(1);
+      }
+      if (phase == 10 && steps[k].size) {
+        steps[k].size = gups_table_size(steps[k].size);
+      }
+      if (phase <= 5 && steps[k].size > array_size) {
+        array_size = steps[k].size;
+      } else if (phase == 8 && steps[k].size > num_particles) {
+        num_particles = steps[k].size;
+      } else if (phase == 9 && steps[k].size > num_palindromes) {
+        num_palindromes = steps[k].size;
+      } else if (phase == 10 && steps[k].size > num_randomloc) {
+        num_randomloc = steps[k].size;
+      }
+    }
+    if (!run_phases) {
+      printf("Run script %s has no phase\n", run_script);
+      exit(1);
+    }
+    /*
+     * Phase 7 has one list per thread: num_threads, or the CPUs of its first
+     * step (see below)
+     */
+    for (k = 0; k < num_steps; ++k) {
+      const int lists = get_num_threads(phase_cpu_id[7], num_cpus,
+                                        num_threads);
+      if (steps[k].phase == 7 &&
+          get_num_threads(steps[k].cpu_id, num_cpus,
+                          steps[k].num_threads) > lists) {
+        printf("Run script %s runs phase 7 on more threads than its %d "
+               "linked lists (num_threads, or the CPUs of its first step)\n",
+               run_script, lists);
+        exit(1);
+      }
+    }
+  } else {
+    /* Phases that are not run have no repetition */
+    steps = malloc(sizeof(phase_step) * NUM_PHASES);
+    for (k = 1; k <= NUM_PHASES; ++k) {
+      steps[num_steps] = defaults[k];
+      if (run_phases && !(run_phases & (1 << (k - 1)))) {
+        steps[num_steps].repeat = 0;
+      }
+      ++num_steps;
+    }
+  }
+
   if (bind_to_cpu_set) {
     printf("Binding to cpu set...\n");
   } else {
     printf("Binding to particular core within cpu set...\n");
   }
 
+  if (simd_select(simd_isa)) {
+    printf("Vector ISA %s is not supported on this CPU or by this build\n",
+           simd_isa_name(simd_isa));
+    exit(1);
+  }
+
+  if (((run_phases & 32) || !run_phases) &&
+      sparse_gen_matrix_size(&sparse_gen, &nrow, &ncol)) {
+    exit(1);
+  }
+
   /* Printing useful information */
   printf("-------- Input data --------\n");
   printf("Number of cpus %d\n", num_cpus);
+  topology_print();
+  printf("Thread placement %s\n", placement_name(thread_placement));
   printf("Array size %ld\n", array_size);
   printf("Linked list size %ld\n", llist_size);
+  printf("Linked list layout %s", llist_layout_name(&llist_layout));
+  if (llist_layout.order == LLIST_STRIDED) {
+    printf(" (stride %ld)", llist_layout.stride);
+  }
+  printf("%s\n", llist_layout.hugepages ? " on huge pages" : "");
   printf("Number of rows %d\n", nrow);
   printf("Number of columns %d\n", ncol);
+  printf("Sparse matrix generator %s", sparse_generator_name(sparse_gen.type));
+  if (sparse_gen.type == SPARSE_GEN_MTX) {
+    printf(" (%s)", sparse_gen.path);
+  } else if (sparse_gen.param) {
+    printf(" (%g)", sparse_gen.param);
+  }
+  printf("\n");
   printf("Number of particles %d\n", num_particles);
-  printf("Number of palindromes %d\n", num_palindromes);
-  printf("Number of random locations %d\n", num_randomloc);
+  printf("Phase 8 mode %s", phase8_mode_name(phase8_spec.mode));
+  if (phase8_spec.mode == PHASE8_CELLS) {
+    printf(" (cutoff %g)", phase8_spec.cutoff);
+  }
+  printf("\n");
+  printf("Vector ISA for phases 1, 4 and 8 %s (%s)\n",
+         simd_isa_name(simd_isa), simd_forced ? "forced" : "detected");
+  printf("Number of palindromes %d (%s)\n", num_palindromes,
+         phase9_mode_name(phase9_mode));
+  num_randomloc = gups_table_size(num_randomloc);
+  printf("Number of random locations %ld (%.1f MiB)\n", num_randomloc,
+         sizeof(uint64_t) * num_randomloc / 1048576.0);
+  printf("Random location updates %s", gups_update_name(gups_spec.update));
+  if (gups_spec.batch > 1) {
+    printf(" (batches of %d)", gups_spec.batch);
+  }
+  printf("\n");
   printf("Number of iterations %d\n", num_iterations);
+  for (k = 1; k <= NUM_PHASES; ++k) {
+    if (phase_target[k] > 0) {
+      printf("Phase %d target duration %g s\n", k, phase_target[k]);
+    }
+  }
+  printf("Runs per phase %d", num_runs);
+  if (stable_ci > 0) {
+    printf(" at most, until the 95%% confidence interval is within %g%%",
+           stable_ci);
+  }
+  printf(", after %d warm-up runs\n", num_warmup);
   printf("----------------------------\n");
 
+  if (roofline && roofline_peak.measured) {
+    printf("Measuring peak bandwidth and floating-point throughput...\n");
+    roofline_measure(&roofline_peak,
+                     get_num_threads(NULL, num_cpus, num_threads));
+    printf("Peak bandwidth %.3f GB/s, peak %.3f GFLOP/s\n",
+           roofline_peak.gbytes_per_s, roofline_peak.gflops_per_s);
+  }
+
+  if (results_path) {
+    char host[256] = "", compiler[1024], flags[4096];
+    if (results_open(results_path)) {
+      exit(1);
+    }
+    gethostname(host, sizeof(host));
+    compiler_information(argv[0], compiler, sizeof(compiler), flags,
+                         sizeof(flags));
+    results_param_str("version", "1.0");
+    results_param_long("start_time", rawtime);
+    results_param_str("host", host);
+    results_param_str("compiler", compiler);
+    results_param_str("compiler_flags", flags);
+    results_param_long("num_cpus", num_cpus);
+    results_param_long("num_threads", num_threads);
+    results_param_long("bind_to_cpu_set", bind_to_cpu_set);
+    results_param_str("placement", placement_name(thread_placement));
+    results_param_long("run_phases", run_phases);
+    if (run_script) {
+      results_param_str("run_script", run_script);
+    }
+    if (sweep_arg) {
+      results_param_str("sweep", sweep_arg);
+    }
+    if (latency_arg) {
+      results_param_str("latency", latency_arg);
+    }
+    results_param_long("num_iterations", num_iterations);
+    results_param_long("num_runs", num_runs);
+    results_param_long("num_warmup", num_warmup);
+    results_param_double("stable_ci", stable_ci);
+    for (k = 1; k <= NUM_PHASES; ++k) {
+      if (phase_target[k] > 0) {
+        char key[32];
+        snprintf(key, sizeof(key), "phase%d_target_seconds", k);
+        results_param_double(key, phase_target[k]);
+      }
+    }
+    results_param_long("array_size", array_size);
+    results_param_long("block_size", block_size);
+    results_param_long("llist_size", llist_size);
+    results_param_str("llist_layout", llist_layout_name(&llist_layout));
+    results_param_long("nrow", nrow);
+    results_param_long("ncol", ncol);
+    results_param_str("sparse_format", sparse_format_name(sparse_spec.format));
+    results_param_str("sparse_gen", sparse_generator_name(sparse_gen.type));
+    results_param_long("num_particles", num_particles);
+    results_param_str("phase8_mode", phase8_mode_name(phase8_spec.mode));
+    results_param_double("phase8_cutoff", phase8_spec.cutoff);
+    results_param_str("simd_isa", simd_isa_name(simd_isa));
+    results_param_long("num_palindromes", num_palindromes);
+    results_param_str("phase9_mode", phase9_mode_name(phase9_mode));
+    results_param_long("num_randomloc", num_randomloc);
+    results_param_str("gups_update", gups_update_name(gups_spec.update));
+    results_param_long("gups_batch", gups_spec.batch);
+    if (roofline) {
+      results_param_double("peak_gbytes_per_s", roofline_peak.gbytes_per_s);
+      results_param_double("peak_gflops_per_s", roofline_peak.gflops_per_s);
+    }
+  }
+
   int orig_num_threads = num_threads;
 
   if ((run_phases & 1) || (run_phases & 4) || (!run_phases)) {
-    vals = malloc(sizeof(double) * array_size);  
-    int_vals = malloc(sizeof(int) * array_size);
+    k = ((run_phases & 1) || !run_phases) ? 1 : 3;
+    vals_mem = mem_policy_for(&phase_mem[k], phase_cpu_id[k]);
+    vals = mem_alloc(sizeof(double) * array_size, &vals_mem);
+    int_vals = mem_alloc(sizeof(int) * array_size, &vals_mem);
   }
 
   if ((run_phases & 2) || (run_phases & 8) || (run_phases & 16) || 
       (!run_phases)) {
-    src1 = malloc(sizeof(double) * array_size);
-    src2 = malloc(sizeof(double) * array_size);
-    dest = malloc(sizeof(double) * array_size);
-    ind_src1 = malloc(sizeof(double) * array_size);
-    ind_src2 = malloc(sizeof(double) * array_size);  
+    k = ((run_phases & 2) || !run_phases) ? 2 : (run_phases & 8) ? 4 : 5;
+    vectors_mem = mem_policy_for(&phase_mem[k], phase_cpu_id[k]);
+    src1 = mem_alloc(sizeof(double) * array_size, &vectors_mem);
+    src2 = mem_alloc(sizeof(double) * array_size, &vectors_mem);
+    dest = mem_alloc(sizeof(double) * array_size, &vectors_mem);
+    ind_src1 = mem_alloc(sizeof(int) * array_size, &vectors_mem);
+    ind_src2 = mem_alloc(sizeof(int) * array_size, &vectors_mem);
   }
 
   if ((run_phases & 32) || (!run_phases)) {
-    sparse_matrix_indeces = malloc(sizeof(int*) * nrow);
-    sparse_matrix_values = malloc(sizeof(double*) * nrow);
-    sparse_matrix_nonzeros = malloc(sizeof(int) * nrow);
-    vect_in = malloc(sizeof(double) * ncol);
-    vect_out = malloc(sizeof(double) * nrow);   
+    matrix_mem = mem_policy_for(&phase_mem[6], phase_cpu_id[6]);
+    matrix = sparse_alloc(nrow, ncol, &sparse_spec, &matrix_mem);
+    vect_in = mem_alloc(sizeof(double) * ncol, &matrix_mem);
+    vect_out = mem_alloc(sizeof(double) * nrow, &matrix_mem);
   }
 
   if ((run_phases & 64) || (!run_phases)) {
-    llist = malloc(num_cpus * sizeof(linked_list*));  
-    for (i = 0; i < num_cpus; ++i) {
-      llist[i] = malloc(sizeof(linked_list*));
-    }
+    /* One list per thread, as phase 7 indexes them by thread number */
+    num_lists = get_num_threads(phase_cpu_id[7], num_cpus, orig_num_threads);
+    llist = malloc(num_lists * sizeof(linked_list*));
+    llist_mem = mem_policy_for(&phase_mem[7], phase_cpu_id[7]);
   }
 
   if ((run_phases & 128) || (!run_phases)) {
-    particles = malloc(sizeof(particle) * num_particles);
-    forces = calloc(num_particles-1, sizeof(double));
+    particles_mem = mem_policy_for(&phase_mem[8], phase_cpu_id[8]);
+    particles = alloc_particles(num_particles, &particles_mem);
+    forces = mem_alloc(sizeof(double) * num_particles, &particles_mem);
   }
   
   if ((run_phases & 256) || (!run_phases)) {
-    palindromes = calloc(num_palindromes, sizeof(unsigned long));  
+    palindromes_mem = mem_policy_for(&phase_mem[9], phase_cpu_id[9]);
+    palindromes = mem_alloc(sizeof(unsigned long) * num_palindromes,
+                            &palindromes_mem);
   }
   
   if ((run_phases & 512) || (!run_phases)) {
-    randomloc = calloc(num_randomloc, sizeof(int));  
+    randomloc_mem = mem_policy_for(&phase_mem[10], phase_cpu_id[10]);
+    randomloc = mem_alloc(sizeof(uint64_t) * num_randomloc, &randomloc_mem);
   }
 
 /*
@@ -282,14 +746,19 @@ int main(int argc, char** argv) {
          * restrict valid_forces = NULL;
   int * restrict valid_ind_src1 = NULL, * restrict valid_ind_src2 = NULL,
       * restrict valid_int_vals = NULL;
-  int ** restrict valid_sparse_matrix_indeces = NULL;
-  double ** restrict valid_sparse_matrix_values = NULL;
-  int * restrict valid_sparse_matrix_nonzeros = NULL;
   unsigned long* restrict valid_palindromes = NULL;
 #endif
 
 #if RED_VALIDATION
-  double* restrict valid_red_vals = malloc(sizeof(double) * array_size);
+  /* Also used for the output of phases 6 and 8 */
+  long valid_red_size = array_size;
+  if (((run_phases & 32) || !run_phases) && nrow > valid_red_size) {
+    valid_red_size = nrow;
+  }
+  if (((run_phases & 128) || !run_phases) && num_particles > valid_red_size) {
+    valid_red_size = num_particles;
+  }
+  double* restrict valid_red_vals = malloc(sizeof(double) * valid_red_size);
   int* restrict valid_red_int_vals = malloc(sizeof(int) * array_size);
   unsigned long* restrict valid_red_ulong_vals = malloc(sizeof(unsigned long) *
                                                         num_palindromes);
@@ -312,15 +781,12 @@ int main(int argc, char** argv) {
   }
 
   if ((run_phases & 32) || (!run_phases)) {
-    valid_sparse_matrix_indeces = malloc(sizeof(int*) * nrow);
-    valid_sparse_matrix_values = malloc(sizeof(double*) * nrow);
-    valid_sparse_matrix_nonzeros = malloc(sizeof(int) * nrow);
     valid_vect_in = malloc(sizeof(double) * ncol);
     valid_vect_out = malloc(sizeof(double) * nrow);
   }
 
   if ((run_phases & 128) || (!run_phases)) {
-    valid_forces = calloc(num_particles-1, sizeof(double));
+    valid_forces = calloc(num_particles, sizeof(double));
   }
 
   if ((run_phases & 256) || (!run_phases)) {
@@ -328,12 +794,6 @@ int main(int argc, char** argv) {
   }
 #endif
 
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  int retval = 0;
-  unsigned long long event_values[num_hwcntrs];
-  printf("Meabo.c num_hwcntrs %d\n", num_hwcntrs);
-#endif
-
   /*
    * As the number of phases grew, we split the initialisation per phase
    * as much as possible, to try to minimise the initialisation time.
@@ -341,76 +801,157 @@ int main(int argc, char** argv) {
    * For all initialisation, we use randomly-generated data. 
    */
 
+  /*
+   * The data of each phase is initialised in parallel, by the same number of
+   * threads, with the same CPU set and binding as the first phase that uses
+   * it, so that the pages are placed close to the threads consuming them.
+   */
+  cpu_set_t *init_cpu_id = NULL;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+
   printf("Starting array initialisation...\n");
   if ((run_phases & 1) || (run_phases & 4) || (!run_phases)) {
-    for (i = 0; i < array_size; ++i) {
-      vals[i] = (rand() % 1024) * cos(rand()%1024);
-      int_vals[i] = ceil(vals[i]);
-    }
+    init_cpu_id = ((run_phases & 1) || !run_phases) ? phase_cpu_id[1] :
+                                                      phase_cpu_id[3];
+    num_threads = get_num_threads(init_cpu_id, num_cpus, orig_num_threads);
+    init_vals(array_size, vals, int_vals, num_threads
+#if ENABLE_BINDING
+        , num_cpus, init_cpu_id, bind_to_cpu_set
+#endif
+        );
   }
 
   if ((run_phases & 2) || (run_phases & 8) || (run_phases & 16) || 
       (!run_phases)) {
-    for (i = 0; i < array_size; ++i) {
-      src1[i] = (rand() % 1024) * sin(rand()%1024);
-      src2[i] = (rand() % 1024) * sin(rand()%1024);
-      dest[i] = (rand() % 1024) * cos(rand()%1024);
-      ind_src1[i] = rand() % array_size;
-      ind_src2[i] = rand() % array_size;
-    }
+    init_cpu_id = ((run_phases & 2) || !run_phases) ? phase_cpu_id[2] :
+                  (run_phases & 8) ? phase_cpu_id[4] : phase_cpu_id[5];
+    num_threads = get_num_threads(init_cpu_id, num_cpus, orig_num_threads);
+    init_vectors(array_size, dest, src1, src2, ind_src1, ind_src2, num_threads
+#if ENABLE_BINDING
+        , num_cpus, init_cpu_id, bind_to_cpu_set
+#endif
+        );
   }
 
   if ((run_phases & 32) || !run_phases) {
     printf("Starting sparse matrix initialisation...\n");
-    for (i = 0; i < ncol; ++i) {
-       vect_in[i] = (rand() % 1024) * sin(rand()%1024);
-    }
-
-    for (i = 0; i < nrow; ++i) {
-      sparse_matrix_nonzeros[i] = rand() % ncol;
-      const int nonzeros = sparse_matrix_nonzeros[i];
-      sparse_matrix_indeces[i] = malloc(sizeof(int) * nonzeros);
-      int * restrict cols = sparse_matrix_indeces[i];
-      sparse_matrix_values[i] = malloc(sizeof(double) * nonzeros);
-      double * restrict values = sparse_matrix_values[i];
-
-      int* restrict columns = calloc((int)ceil(ncol/(sizeof(int)*8)),sizeof(int));
-      for (j = 0; j < nonzeros; ++j) {
-        col = rand() % ncol;
-        while ((1 << (col % 32)) & *(columns + col/32)) {
-          col = rand() % ncol;
-        }
-        cols[j] = col;
-        *(columns + col/32) |= 1<<col;
-        values[j] = (rand() % 1024) * cos(rand() % 1024);
-      }
-    }
+    num_threads = get_num_threads(phase_cpu_id[6], num_cpus,
+                                  orig_num_threads);
+    init_sparse_matrix(nrow, ncol, matrix, &sparse_gen, vect_in, vect_out,
+        num_threads
+#if ENABLE_BINDING
+        , num_cpus, phase_cpu_id[6], bind_to_cpu_set
+#endif
+        );
+    sparse_print_info(matrix);
   }
 
   if ((run_phases & 64) || !run_phases) {
     printf("Starting linked list initialisation...\n");
-    for (i = 0; i < num_cpus; ++i) {
-      linked_list *node = llist[i];
-      for (j = 0; j < llist_size; ++j) {
-        node->value = j;
-        if (j == llist_size - 1) {
-          node->next = NULL;
-        } else {
-          node->next = (linked_list*) malloc(sizeof(linked_list));
-        }
-        node = node->next;
-      }
+    num_threads = get_num_threads(phase_cpu_id[7], num_cpus,
+                                  orig_num_threads);
+    if (latency_arg) {
+      alloc_llist(llist_size, num_lists, llist, &llist_layout, &llist_mem);
+    } else {
+      init_llist(llist_size, num_lists, llist, &llist_layout, &llist_mem,
+          num_threads
+#if ENABLE_BINDING
+          , num_cpus, phase_cpu_id[7], bind_to_cpu_set
+#endif
+          );
     }
   }
 
   if ((run_phases & 128) || !run_phases) {
     printf("Starting particles initialisation...\n");
-    for (i = 0; i < num_particles; ++i) {
-      particles[i].x = rand() % 1024;
-      particles[i].y = rand() % 1024;
-      particles[i].z = rand() % 1024;
-      particles[i].charge = sin(rand()%1024);
+    num_threads = get_num_threads(phase_cpu_id[8], num_cpus,
+                                  orig_num_threads);
+    init_particles(particles, &phase8_spec, num_threads
+#if ENABLE_BINDING
+        , num_cpus, phase_cpu_id[8], bind_to_cpu_set
+#endif
+        );
+    init_zero(forces, sizeof(double) * num_particles, num_threads
+#if ENABLE_BINDING
+        , num_cpus, phase_cpu_id[8], bind_to_cpu_set
+#endif
+        );
+  }
+
+  if ((run_phases & 256) || !run_phases) {
+    num_threads = get_num_threads(phase_cpu_id[9], num_cpus,
+                                  orig_num_threads);
+    init_zero(palindromes, sizeof(unsigned long) * num_palindromes,
+        num_threads
+#if ENABLE_BINDING
+        , num_cpus, phase_cpu_id[9], bind_to_cpu_set
+#endif
+        );
+  }
+
+  if ((run_phases & 512) || !run_phases) {
+    num_threads = get_num_threads(phase_cpu_id[10], num_cpus,
+                                  orig_num_threads);
+    init_gups_table(num_randomloc, randomloc, num_threads
+#if ENABLE_BINDING
+        , num_cpus, phase_cpu_id[10], bind_to_cpu_set
+#endif
+        );
+  }
+
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
+  printf("Initialisation duration (ns): %llu\n", duration(t1, t2));
+
+  /* Where the pages of the data of each phase actually are */
+  if ((run_phases & 1) || (run_phases & 4) || (!run_phases)) {
+    mem_stats stats = { { 0 } };
+    mem_count(vals, &stats);
+    mem_count(int_vals, &stats);
+    mem_report("Phases 1 and 3", "memory_phases_1_3", &vals_mem, &stats);
+  }
+  if ((run_phases & 2) || (run_phases & 8) || (run_phases & 16) ||
+      (!run_phases)) {
+    mem_stats stats = { { 0 } };
+    mem_count(src1, &stats);
+    mem_count(src2, &stats);
+    mem_count(dest, &stats);
+    mem_count(ind_src1, &stats);
+    mem_count(ind_src2, &stats);
+    mem_report("Phases 2, 4 and 5", "memory_phases_2_4_5", &vectors_mem,
+               &stats);
+  }
+  if ((run_phases & 32) || (!run_phases)) {
+    mem_stats stats = { { 0 } };
+    sparse_count_pages(matrix, &stats);
+    mem_count(vect_in, &stats);
+    mem_count(vect_out, &stats);
+    mem_report("Phase 6", "memory_phase_6", &matrix_mem, &stats);
+  }
+  if ((run_phases & 64) || (!run_phases)) {
+    mem_stats stats = { { 0 } };
+    for (k = 0; k < num_lists; ++k) {
+      mem_count(llist[k], &stats);
     }
+    mem_report("Phase 7", "memory_phase_7", &llist_mem, &stats);
+  }
+  if ((run_phases & 128) || (!run_phases)) {
+    mem_stats stats = { { 0 } };
+    mem_count(particles->x, &stats);
+    mem_count(particles->y, &stats);
+    mem_count(particles->z, &stats);
+    mem_count(particles->charge, &stats);
+    mem_count(forces, &stats);
+    mem_report("Phase 8", "memory_phase_8", &particles_mem, &stats);
+  }
+  if ((run_phases & 256) || (!run_phases)) {
+    mem_stats stats = { { 0 } };
+    mem_count(palindromes, &stats);
+    mem_report("Phase 9", "memory_phase_9", &palindromes_mem, &stats);
+  }
+  if ((run_phases & 512) || (!run_phases)) {
+    mem_stats stats = { { 0 } };
+    mem_count(randomloc, &stats);
+    mem_report("Phase 10", "memory_phase_10", &randomloc_mem, &stats);
   }
 
 #if FULL_VALIDATION
@@ -432,894 +973,148 @@ int main(int argc, char** argv) {
     }
   }
 
+ /*
+  * The sparse matrix is only read by Phase 6, so the full validation runs on
+  * the same matrix, with its own input and output vectors.
+  */
  if ((run_phases & 32) || !run_phases) {
   for (i = 0; i < ncol; ++i) {
      valid_vect_in[i] = vect_in[i];
   }
-
-  for (i = 0; i < nrow; ++i) {
-    valid_sparse_matrix_nonzeros[i] = sparse_matrix_nonzeros[i];
-    const int nonzeros = valid_sparse_matrix_nonzeros[i];
-    valid_sparse_matrix_indeces[i] = malloc(sizeof(int) * nonzeros);
-    int * restrict cols = valid_sparse_matrix_indeces[i];
-    valid_sparse_matrix_values[i] = malloc(sizeof(double) * nonzeros);
-    double * restrict values = valid_sparse_matrix_values[i];
-
-    for (j = 0; j < nonzeros; ++j) {
-      cols[j] = sparse_matrix_indeces[i][j];
-      values[j] = sparse_matrix_values[i][j];
-    }
-  }
  }
 #endif
 
 #if ENABLE_BINDING
   printf("Per-phase core-binding enabled...\n");
 #endif
+#if ENABLE_COUNTERS
+  if (event_spec && (num_events = parse_event_spec(event_spec,
+                                                   &event_names)) < 0) {
+    exit(1);
+  }
+#endif
 #if ENABLE_PAPI
   printf("Enabling PAPI...\n");
   papi_info =  init_PAPI(num_hwcntrs);
+  if (!event_spec) {
+    event_names = papi_info->event_code_str;
+    num_events = papi_info->total_events;
+  }
+#elif ENABLE_PERF_EVENTS
+  printf("Enabling perf_event counters...\n");
+#endif
+#if ENABLE_COUNTERS
+  if (counters_init(event_names, num_events, counters_mode, num_hwcntrs)) {
+    exit(1);
+  }
 #endif
 #if ENABLE_ENERGY
   printf("Initializing energy readings...\n");
-  init_read_energy();
+  if (init_read_energy(energy_spec)) {
+    exit(1);
+  }
 #endif
 
   time(&rawtime);
   printf("All initialization completed at %s\n", ctime(&rawtime));
 
-  // Phase 1: Floating-point and integer operations with good data re-use
-
-if ((run_phases & 1) || !run_phases) {
-
-  time(&rawtime);
-  printf("Starting phase 1... %s\n", ctime(&rawtime));
-
-  num_threads = get_num_threads(phase1_cpu_id, num_cpus, orig_num_threads);
-
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase1_cpu_id, num_cpus, print);
-#endif
-#if ENABLE_ENERGY
-   read_energy("#PHASE1_START");
-#endif
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    papi_info->num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase1_compute(num_iterations, array_size, block_size, temp1, temp2, temp3,
-      int_temp1, int_temp2, int_temp3, vals, int_vals, 0, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase1_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
+  phase_data data = { num_cpus, bind_to_cpu_set, block_size, array_size,
+                      vals, src1, src2, dest, int_vals, ind_src1, ind_src2,
+                      reduction_var, matrix, vect_in, vect_out, llist_size,
+                      llist, particles, forces, phase8_spec, num_palindromes,
+                      palindromes, phase9_mode, num_randomloc, randomloc,
+                      gups_spec
+#if FULL_VALIDATION
+                      , valid_vals, valid_src1, valid_src2, valid_dest,
+                      valid_vect_in, valid_vect_out, valid_forces,
+                      valid_int_vals, valid_ind_src1, valid_ind_src2,
+                      valid_palindromes
 #endif
 #if RED_VALIDATION
-      , valid_red_vals, valid_red_int_vals
+                      , valid_red_vals, valid_red_int_vals,
+                      valid_red_ulong_vals, valid_red_reduction_var
 #endif
-    );
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
+                    };
 
-#if ENABLE_ENERGY
-   read_energy("#PHASE1_STOP");
-#endif
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
+  if (sweep.phase) {
+    total_exec_time += run_sweep(&data, &defaults[sweep.phase], &sweep);
+    num_steps = 0;
+  } else if (latency_arg) {
+    total_exec_time += run_latency(&data, &defaults[7], &latency);
+    num_steps = 0;
   }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
+  for (k = 0; k < num_steps; k += corun_steps) {
+    corun_steps = 1;
+    while (steps[k].corun && k + corun_steps < num_steps &&
+           steps[k + corun_steps].corun == steps[k].corun) {
+      ++corun_steps;
+    }
+    if (!steps[k].repeat) {
+      printf("Skipping phase %d...\n", steps[k].phase);
+    } else if (corun_steps > 1) {
+      total_exec_time += run_corun(&data, &steps[k], corun_steps, k);
+    } else {
+      total_exec_time += run_step(&data, &steps[k], run_script ? k : -1);
+    }
   }
-#endif
-  printf("Phase 1 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 1 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  validation_array("Reduced", array_size, vals, valid_red_vals, 1, rawtime);
-  validation_array("Reduced", array_size, int_vals, valid_red_int_vals,
-      1, rawtime);
-#endif
 
-#if FULL_VALIDATION
-  full_validation(phase1_compute_wrapper, 1, rawtime,
- #if RED_VALIDATION
-       20,
- #else
-       18,
- #endif
-       num_iterations, array_size, block_size, temp1, temp2, temp3,
-       int_temp1, int_temp2, int_temp3, valid_vals, valid_int_vals, 1,
-       num_threads
-#if ENABLE_BINDING
-       , num_cpus, phase1_cpu_id, bind_to_cpu_set
-#endif
- #if RED_VALIDATION
-     , valid_red_vals, valid_red_int_vals
- #endif
-     , vals, int_vals);
-#endif
-} else{
-  printf("Skipping phase 1...\n");
+printf("Total execution time (ns): %llu\n", total_exec_time);
+results_close(total_exec_time);
+if (roofline) {
+  roofline_summary(&roofline_peak);
 }
-  // Phase 2: Vector multiplication & addition, 1 level of indirection in 
-  // 1 source vector
-if ((run_phases & 2) || !run_phases) {
-
-  num_threads = get_num_threads(phase2_cpu_id, num_cpus, orig_num_threads);
 
-  time(&rawtime);
-  printf("Starting phase 2...%s\n", ctime(&rawtime));
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase2_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
+// Wrap-up & cleaning up
 
-#if ENABLE_ENERGY
-   read_energy("#PHASE2_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase2_compute(num_iterations, array_size, dest, src1, src2, ind_src2, 0,
-      num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase2_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
+  counters_free();
+#if ENABLE_PAPI
+  dinit_PAPI(papi_info);
 #endif
-  #if RED_VALIDATION
-      , valid_red_vals
-  #endif
-  );
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
 #if ENABLE_ENERGY
-   read_energy("#PHASE2_STOP");
+  exit_read_energy();
 #endif
+  
+if ((run_phases & 1) || (run_phases & 4) || (!run_phases)) {
+  mem_free(vals);  
+  mem_free(int_vals);
+}
 
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
+if ((run_phases & 2) || (run_phases & 8) || (run_phases & 16) || 
+    (!run_phases)) {
+  mem_free(src1);
+  mem_free(src2);
+  mem_free(dest);
+  mem_free(ind_src1);
+  mem_free(ind_src2);
+}
 
+if ((run_phases & 32) || (!run_phases)) {
+  sparse_free(matrix);
+  mem_free(vect_in);
+  mem_free(vect_out);
+}
 
-  printf("Phase 2 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 2 completed at %s\n", ctime(&rawtime));
+if ((run_phases & 64) || (!run_phases)) {
+  free_llist(num_lists, llist);
+  free(llist);  
+}
 
-#if RED_VALIDATION
-  validation_array("Reduced", array_size, dest, valid_red_vals, 2, rawtime);
-#endif
+if ((run_phases & 128) || (!run_phases)) {
+  free_particles(particles);
+  mem_free(forces);
+}
 
-#if FULL_VALIDATION
-  full_validation(phase2_compute_wrapper, 2, rawtime,
-  #if RED_VALIDATION
-        13,
-  #else
-        12,
-  #endif
-      num_iterations, array_size, valid_dest, valid_src1, valid_src2,
-      valid_ind_src2, 1, num_threads
-  #if ENABLE_BINDING
-      , num_cpus, phase2_cpu_id, bind_to_cpu_set
-  #endif
-  #if RED_VALIDATION
-      , valid_red_vals
-  #endif
-      , dest
-      );
-#endif
-} else {
-  printf("Skipping phase 2...\n");
+if ((run_phases & 256) || (!run_phases)) {
+  mem_free(palindromes);
 }
 
-  // Phase 3: Vector scalar addition and reductions
+if ((run_phases & 512) || (!run_phases)) {
+  mem_free(randomloc);  
+}
 
-if ((run_phases & 4) || !run_phases) {
-
-  num_threads = get_num_threads(phase3_cpu_id, num_cpus, orig_num_threads);
-
-  time(&rawtime);
-  printf("Starting phase 3...%s\n", ctime(&rawtime));
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase3_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-#if ENABLE_ENERGY
-   read_energy("#PHASE3_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase3_compute(num_iterations, array_size, vals, &reduction_var, 0,
-      num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase3_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-  #if RED_VALIDATION
-      , &valid_red_reduction_var
-  #endif
-      );
-
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
-#if ENABLE_ENERGY
-   read_energy("#PHASE3_STOP");
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
-
-
-  printf("Phase 3 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-    printf("Phase 3 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  reduced_validation_var(array_size, vals, valid_red_reduction_var, 3, rawtime);
-#endif
-
-#if FULL_VALIDATION
-  full_validation(phase3_compute_wrapper, 3, rawtime,
-#if RED_VALIDATION
-      11,
-#else
-      10,
-#endif
-      num_iterations, array_size, valid_vals, reduction_var, 1, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase3_cpu_id, bind_to_cpu_set
-#endif
-#if RED_VALIDATION
-      , valid_red_reduction_var
-#endif
-      , vals);
-#endif
-} else {
-  printf("Skipping phase 3...\n");
-}
-
-// Phase 4: Vector addition
-if ((run_phases & 8) || !run_phases) {
-
-  time(&rawtime);
-  printf("Starting phase 4...%s\n", ctime(&rawtime));
-
-  num_threads = get_num_threads(phase4_cpu_id, num_cpus, orig_num_threads);
-
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase4_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-#if ENABLE_ENERGY
-   read_energy("#PHASE4_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase4_compute(num_iterations, array_size, dest, src1, src2, 0, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase4_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-  #if RED_VALIDATION
-      , valid_red_vals
-  #endif
-      );
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
-#if ENABLE_ENERGY
-   read_energy("#PHASE4_STOP");
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values,
-                                   num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
-
-
-  printf("Phase 4 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 4 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  validation_array("Reduced", array_size, dest, valid_red_vals, 4, rawtime);
-#endif
-
-#if FULL_VALIDATION
-  full_validation(phase4_compute_wrapper, 4, rawtime,
- #if RED_VALIDATION
-       12,
- #else
-       11,
- #endif
-     num_iterations, array_size, valid_dest, valid_src1,
-     valid_src2, 1, num_threads
-#if ENABLE_BINDING
-     , num_cpus, phase4_cpu_id, bind_to_cpu_set
-#endif
- #if RED_VALIDATION
-     , valid_red_vals
- #endif
-     , dest
-     );
-#endif
-} else {
-  printf("Skipping phase 4...\n");
-}
-  // Phase 5: Vector addition, 1 level of indirection in both source vectors
-
-if ((run_phases & 16) || !run_phases) {
-
-  time(&rawtime);
-  printf("Starting phase 5...%s\n", ctime(&rawtime));
-
-  num_threads = get_num_threads(phase5_cpu_id, num_cpus, orig_num_threads);
-
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase5_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-#if ENABLE_ENERGY
-  read_energy("#PHASE5_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-
-  phase5_compute(num_iterations, array_size, dest, src1, src2, ind_src1,
-      ind_src2, 0, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase5_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-  #if RED_VALIDATION
-      , valid_red_vals
-  #endif
-      );
-
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
-#if ENABLE_ENERGY
-   read_energy("#PHASE5_STOP");
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
-
-
-  printf("Phase 5 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 5 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  validation_array("Reduced", array_size, dest, valid_red_vals, 5, rawtime);
-#endif
-
-#if FULL_VALIDATION
-  full_validation(phase5_compute_wrapper, 5, rawtime,
-  #if RED_VALIDATION
-        14,
-  #else
-        13,
-  #endif
-      num_iterations, array_size, valid_dest, valid_src1,
-      valid_src2, valid_ind_src1, valid_ind_src2, 1, num_threads
-  #if ENABLE_BINDING
-      , num_cpus, phase5_cpu_id, bind_to_cpu_set
-  #endif
-  #if RED_VALIDATION
-      , valid_red_vals
-  #endif
-      , dest
-      );
-#endif
-} else {
-  printf("Skipping phase 5...\n");
-}
-
-// Phase 6: Sparse matrix-vector multiplication 
-
-if ((run_phases & 32) || !run_phases) {
-
-  time(&rawtime);
-  printf("Starting phase 6...%s\n", ctime(&rawtime));
-
-  num_threads = get_num_threads(phase6_cpu_id, num_cpus, orig_num_threads);
-
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase6_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-#if ENABLE_ENERGY
-   read_energy("#PHASE6_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase6_compute(num_iterations, nrow, sparse_matrix_values, vect_in,
-      sparse_matrix_indeces, sparse_matrix_nonzeros, vect_out, 0, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase6_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-  #if RED_VALIDATION
-      , valid_red_vals
-  #endif
-      );
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
-#if ENABLE_ENERGY
-   read_energy("#PHASE6_STOP");
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
-
-
-  printf("Phase 6 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 6 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  int reallocation = 0;
-  if (nrow > array_size) {
-    printf("Reallocating valid_red_vals for reduced validation\n");
-    realloc(valid_red_vals, sizeof(double) * nrow);
-    reallocation = 1;
-  }
-  validation_array("Reduced", nrow, vect_out, valid_red_vals, 6, rawtime);
-  if (reallocation) {
-    printf("Reallocating back valid_red_vals after reduced validation\n");
-    realloc(valid_red_vals, sizeof(double) * array_size);
-  }
-
-  printf ("Reduced validation for phase 6 ended at %s\n", ctime(&rawtime));
-#endif
-
-#if FULL_VALIDATION
-  full_validation(phase6_compute_wrapper, 6, rawtime,
-  #if RED_VALIDATION
-        14,
-  #else
-        13,
-  #endif
-      num_iterations, nrow, valid_sparse_matrix_values,
-      valid_vect_in, valid_sparse_matrix_indeces,
-      valid_sparse_matrix_nonzeros, valid_vect_out, 1, num_threads
-  #if ENABLE_BINDING
-      , num_cpus, phase6_cpu_id, bind_to_cpu_set
-  #endif
-  #if RED_VALIDATION
-      , valid_red_vals
-  #endif
-      , vect_out
-      );
-#endif
-} else {
-  printf("Skipping phase 6...\n");
-}
-
-// Phase 7: Linked-list traversal
-if ((run_phases & 64) || !run_phases) {
-
-  time(&rawtime);
-  printf("Starting phase 7...%s\n", ctime(&rawtime));
-
-  num_threads = get_num_threads(phase7_cpu_id, num_cpus, orig_num_threads);
-
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase7_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-#if ENABLE_ENERGY
-   read_energy("#PHASE7_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase7_compute(num_iterations, llist_size, llist, 0, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase7_cpu_id, bind_to_cpu_set
-#endif
-#if  ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-#if RED_VALIDATION
-      , &valid_red_reduction_var
-#endif
-      );
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
-#if ENABLE_ENERGY
-   read_energy("#PHASE7_STOP");
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
-
-  printf("Phase 7 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 7 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  reduced_validation_sg_var(valid_red_reduction_var, (double) (llist_size - 1), 7, rawtime);
-#endif
-
-#if FULL_VALIDATION
-  printf("There is no full validation for phase 7, as we do not modify the "
-      "linked list data.\n");
-#endif
-} else {
-  printf("Skipping phase 7...\n");
-}
-
-// Phase 8: Electrostatic force calculations
-if ((run_phases & 128) || !run_phases) {
-
-  time(&rawtime);
-  printf("Starting phase 8...%s\n", ctime(&rawtime));
-
-  num_threads = get_num_threads(phase8_cpu_id, num_cpus, orig_num_threads);
-
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase8_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-#if ENABLE_ENERGY
-   read_energy("#PHASE8_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase8_compute(num_iterations, num_particles, particles, forces, 0,
-      num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase8_cpu_id, bind_to_cpu_set
-#endif
-#if  ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-#if RED_VALIDATION
-      , valid_red_vals
-#endif
-      );
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
-#if ENABLE_ENERGY
-   read_energy("#PHASE8_STOP");
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
-
-  printf("Phase 8 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 8 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  validation_array("Reduced", num_particles - 1, forces, valid_red_vals, 8,
-                    rawtime);
-#endif
-
-#if FULL_VALIDATION
-  full_validation(phase8_compute_wrapper, 8, rawtime,
-#if RED_VALIDATION
-      11,
-#else
-      10,
-#endif
-      num_iterations, num_particles, particles, valid_forces, 1, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase8_cpu_id, bind_to_cpu_set
-#endif
-#if RED_VALIDATION
-      , valid_red_vals
-#endif
-      , forces
-      );
-#endif
-} else {
-  printf("Skipping phase 8...\n");
-}
-
-// Phase 9: Palindrome caluclations
-if ((run_phases & 256) || !run_phases) {
-
-  time(&rawtime);
-  printf("Starting phase 9...%s\n", ctime(&rawtime));
-
-  num_threads = get_num_threads(phase9_cpu_id, num_cpus, orig_num_threads);
-
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase9_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-#if ENABLE_ENERGY
-   read_energy("#PHASE9_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase9_compute(num_iterations, num_palindromes, palindromes, 0,
-      num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase9_cpu_id, bind_to_cpu_set
-#endif
-#if  ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-#if RED_VALIDATION
-      , valid_red_ulong_vals
-#endif
-      );
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
-#if ENABLE_ENERGY
-   read_energy("#PHASE9_STOP");
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
-
-  printf("Phase 9 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 9 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  validation_array("Reduced", num_palindromes, palindromes,
-                    valid_red_ulong_vals, 9, rawtime);
-#endif
-
-#if FULL_VALIDATION
-  full_validation(phase9_compute_wrapper, 9, rawtime,
-#if RED_VALIDATION
-      11,
-#else
-      10,
-#endif
-      num_iterations, num_palindromes, valid_palindromes, 1, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase9_cpu_id, bind_to_cpu_set
-#endif
-#if  ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-#if RED_VALIDATION
-      , valid_red_ulong_vals
-#endif
-      , palindromes
-      );
-#endif
-} else {
-  printf("Skipping phase 9...\n");
-}
-
-// Phase 10: Random memory accesses
-if ((run_phases & 512) || !run_phases) {
-
-  time(&rawtime);
-  printf("Starting phase 10...%s\n", ctime(&rawtime));
-
-  num_threads = get_num_threads(phase10_cpu_id, num_cpus, orig_num_threads);
-
-#if ENABLE_BINDING
-  bind_to_cpu_w_reset(phase10_cpu_id, num_cpus, print);
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_start_counters(papi_info->event_code,
-                                    num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to start counters %d: %s\n", retval, handle_error(retval));
-  }
-#endif
-
-#if ENABLE_ENERGY
-   read_energy("#PHASE10_START");
-#endif
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
-  phase10_compute(num_iterations, num_randomloc, randomloc, 0, num_threads
-#if ENABLE_BINDING
-      , num_cpus, phase10_cpu_id, bind_to_cpu_set
-#endif
-#if  ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-      , papi_info
-#endif
-#if RED_VALIDATION
-      , valid_red_int_vals
-#endif
-      );
-  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
-#if ENABLE_ENERGY
-   read_energy("#PHASE10_STOP");
-#endif
-
-#if ENABLE_PAPI && (RED_VALIDATION || FULL_VALIDATION)
-  if ((retval = PAPI_stop_counters(event_values, num_hwcntrs)) != PAPI_OK) {
-    printf("Failed to stop counters %d: %s\n", retval, handle_error(retval));
-  }
-  for (i = 0; i < num_hwcntrs; ++i) {
-    printf("%s value = %lld\n", papi_info->event_code_str[i], event_values[i]);
-  }
-#endif
-
-  printf("Phase 10 duration (ns): %llu\n", duration(t1,t2));
-  total_exec_time += duration(t1, t2);
-  time(&rawtime);
-  printf("Phase 10 completed at %s\n", ctime(&rawtime));
-
-#if RED_VALIDATION
-  /* No need for validation */
-  printf("There is no reduced validation for phase 10, as we only perform random "
-      "memory reads.\n");
-#endif
-
-#if FULL_VALIDATION
-  /* No need for validation */
-  printf("There is no full validation for phase 10, as we only perform random "
-      "memory reads.\n");
-#endif
-} else {
-  printf("Skipping phase 10...\n");
-}
-
-printf("Total execution time (ns): %llu\n", total_exec_time);
-
-// Wrap-up & cleaning up
-
-#if ENABLE_PAPI
-  dinit_PAPI(papi_info);
-#endif
-#if ENABLE_ENERGY
-  exit_read_energy();
-#endif
-  
-if ((run_phases & 1) || (run_phases & 4) || (!run_phases)) {
-  free(vals);  
-  free(int_vals);
-}
-
-if ((run_phases & 2) || (run_phases & 8) || (run_phases & 16) || 
-    (!run_phases)) {
-  free(src1);
-  free(src2);
-  free(dest);
-  free(ind_src1);
-  free(ind_src2);
-}
-
-if ((run_phases & 32) || (!run_phases)) {
-  for (i = 0; i < nrow; ++i) {
-    free(sparse_matrix_indeces[i]);
-    free(sparse_matrix_values[i]);
-  }
-  free(sparse_matrix_indeces);
-  free(sparse_matrix_values);
-  free(sparse_matrix_nonzeros);
-  free(vect_in);
-  free(vect_out);
-}
-
-if ((run_phases & 64) || (!run_phases)) {
-  for (i = 0; i < num_cpus; ++i) {
-    free(llist[i]);
-  }
-  free(llist);  
-}
-
-if ((run_phases & 128) || (!run_phases)) {
-  free(particles);
-  free(forces);
-}
-
-if ((run_phases & 256) || (!run_phases)) {
-  free(palindromes);
-}
-
-if ((run_phases & 512) || (!run_phases)) {
-  free(randomloc);  
-}
+timing_free();
+topology_free();
+free(steps);
 
 #if RED_VALIDATION
   free(valid_red_vals);
@@ -1343,9 +1138,6 @@ if ((run_phases & 2) || (run_phases & 8) || (run_phases & 16) ||
 }
 
 if ((run_phases & 32) || (!run_phases)) {
-  free(valid_sparse_matrix_indeces);
-  free(valid_sparse_matrix_values);
-  free(valid_sparse_matrix_nonzeros);
   free(valid_vect_in);
   free(valid_vect_out);
 }
@@ -24,6 +24,7 @@
 #define _GNU_SOURCE
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <math.h>
 #include <time.h>
@@ -51,22 +52,94 @@
 
 // Control variables
 #define ENABLE_PAPI 0
+#define ENABLE_PERF_EVENTS 0
 #define ENABLE_BINDING 1
-#define ENABLE_ENERGY 0
+#define ENABLE_ENERGY 1
 #define FULL_VALIDATION 0 
 #define RED_VALIDATION 0
+#define ENABLE_HISTOGRAMS 1
 
 typedef struct linked_list {
     struct linked_list *next;
     double value;
 } linked_list;
 
-typedef struct particle {
-    int x;
-    int y;
-    int z;
-    double charge;
-} particle;
+/*
+ * Particles for Phase 8, stored as a structure of arrays. In the cell list
+ * mode the particles are sorted by cell: cell_start[c] is the index of the
+ * first particle of cell c, and cell_start[num_cells] is num_particles.
+ */
+typedef struct particle_set {
+    int num_particles;
+    double *x;
+    double *y;
+    double *z;
+    double *charge;
+    int cells_per_dim;
+    int *cell_start;
+} particle_set;
+
+/*
+ * Phase 8 force computation:
+ * - neighbour: the force between particles i and i + 1 only;
+ * - allpairs: the force on each particle from all the others, with the
+ *   other particles processed in cache-sized tiles;
+ * - cells: the force from the particles within a cutoff distance, found
+ *   through a cell list.
+ */
+typedef enum phase8_mode {
+    PHASE8_NEIGHBOUR = 0,
+    PHASE8_ALLPAIRS,
+    PHASE8_CELLS
+} phase8_mode;
+
+typedef struct phase8_spec {
+    phase8_mode mode;
+    double cutoff;
+} phase8_spec;
+
+/*
+ * Phase 9 palindrome computation:
+ * - constructive: each palindrome is built from its first half;
+ * - bruteforce: every integer is tested with trial division (integer ALU
+ *   stress, the original Meabo kernel).
+ */
+typedef enum phase9_mode {
+    PHASE9_CONSTRUCTIVE = 0,
+    PHASE9_BRUTEFORCE
+} phase9_mode;
+
+/*
+ * Phase 10 (GUPS) table updates:
+ * - atomic: table[r & mask] ^= r with an atomic XOR, so no update is lost;
+ * - racy: plain read-modify-write, as allowed by the HPCC RandomAccess rules
+ *   (concurrent updates to the same entry may be lost).
+ * With batch > 1, the indices of batch updates are generated and prefetched
+ * before the updates are applied.
+ */
+typedef enum gups_update {
+    GUPS_ATOMIC = 0,
+    GUPS_RACY
+} gups_update;
+
+typedef struct gups_spec {
+    gups_update update;
+    int batch;
+} gups_spec;
+
+/*
+ * Updates are split into blocks of GUPS_BLOCK updates, each with its own
+ * random stream, so that the sequence of updates does not depend on the
+ * number of threads.
+ */
+#define GUPS_BLOCK 1024
+#define GUPS_MAX_BATCH 1024
+
+/*
+ * Most independent pointer chains that each thread of the phase 7 latency
+ * ladder follows at the same time, to measure its memory-level parallelism.
+ */
+#define LATENCY_MAX_CHAINS 16
 
 #if ENABLE_PAPI
 #include "papi.h"
@@ -81,7 +154,7 @@ typedef struct PAPI_info {
 #endif
 
 #if ENABLE_ENERGY
-#include "readenergy.h"
+#include "read_energy.h"
 #endif
 
 #endif 
@@ -0,0 +1,497 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "memory.h"
+#include "topology.h"
+#include "results.h"
+
+#include <sys/mman.h>
+
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+/* Pages checked per call to move_pages, and at most per buffer */
+#define MEM_QUERY_PAGES 512
+#define MEM_SAMPLE_PAGES 8192
+
+/*
+ * Mappings made by mem_alloc, so that mem_free and mem_count only need the
+ * pointer. The lists of phase 7 are allocated in parallel.
+ */
+typedef struct mem_mapping {
+  char *addr;
+  size_t len;
+  size_t size;
+  long page_kb;             /* hugetlbfs page size, 0 for other mappings */
+  struct mem_mapping *next;
+} mem_mapping;
+
+static mem_mapping *mappings = NULL;
+static pthread_mutex_t mappings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t page_size(void) {
+  static size_t size = 0;
+  if (!size) {
+    size = sysconf(_SC_PAGESIZE);
+  }
+  return size;
+}
+
+/* Size of the transparent huge pages (PMD mappings) */
+static size_t thp_size(void) {
+  static size_t size = 0;
+  if (!size) {
+    FILE *file = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size",
+                       "r");
+    if (!file || fscanf(file, "%zu", &size) != 1 || !size) {
+      size = 2 * 1024 * 1024;
+    }
+    if (file) {
+      fclose(file);
+    }
+  }
+  return size;
+}
+
+static size_t round_up(const size_t size, const size_t align) {
+  return (size + align - 1) / align * align;
+}
+
+/* Parses a list of nodes, e.g. 0-1,3, into a node mask. */
+static int parse_node_list(const char *str, unsigned long *nodes) {
+  char *end;
+  *nodes = 0;
+  while (*str) {
+    long first = strtol(str, &end, 10), last = first;
+    if (end == str) {
+      return -1;
+    }
+    if (*end == '-') {
+      str = end + 1;
+      last = strtol(str, &end, 10);
+      if (end == str) {
+        return -1;
+      }
+    }
+    if (first < 0 || last < first || last >= MEM_MAX_NODES ||
+        (*end && *end != ',' && *end != '\n')) {
+      return -1;
+    }
+    for (long n = first; n <= last; ++n) {
+      *nodes |= 1UL << n;
+    }
+    str = (*end) ? end + 1 : end;
+  }
+  return *nodes ? 0 : -1;
+}
+
+/* Nodes with memory, for interleave without a list. */
+static unsigned long memory_nodes(void) {
+  const char *paths[] = { "/sys/devices/system/node/has_memory",
+                          "/sys/devices/system/node/online" };
+  char list[1024];
+  unsigned long nodes = 0;
+  for (int p = 0; p < 2 && !nodes; ++p) {
+    FILE *file = fopen(paths[p], "r");
+    if (file) {
+      if (!fgets(list, sizeof(list), file) ||
+          parse_node_list(list, &nodes)) {
+        nodes = 0;
+      }
+      fclose(file);
+    }
+  }
+  return nodes;
+}
+
+/*
+ * Parses a memory placement policy: first-touch, local, bind:<nodes> or
+ * interleave[:<nodes>], with the nodes as a list, e.g. 0-1,3. Returns 0 on
+ * success.
+ */
+int parse_mem_policy(const char *str, mem_policy *policy) {
+  policy->nodes = 0;
+  if (!strcmp(str, "first-touch")) {
+    policy->placement = MEM_FIRST_TOUCH;
+  } else if (!strcmp(str, "local")) {
+    policy->placement = MEM_LOCAL;
+  } else if (!strncmp(str, "bind:", 5)) {
+    policy->placement = MEM_BIND;
+    return parse_node_list(str + 5, &policy->nodes);
+  } else if (!strcmp(str, "interleave")) {
+    policy->placement = MEM_INTERLEAVE;
+  } else if (!strncmp(str, "interleave:", 11)) {
+    policy->placement = MEM_INTERLEAVE;
+    return parse_node_list(str + 11, &policy->nodes);
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+static void format_node_list(const unsigned long nodes, char *str,
+                             size_t size) {
+  int len = 0;
+  str[0] = 0;
+  for (int n = 0; n < MEM_MAX_NODES; ++n) {
+    if (!(nodes & (1UL << n))) {
+      continue;
+    }
+    int last = n;
+    while (last + 1 < MEM_MAX_NODES && (nodes & (1UL << (last + 1)))) {
+      ++last;
+    }
+    if (len < (int) size) {
+      len += snprintf(str + len, size - len, (last > n) ? "%s%d-%d" : "%s%d",
+                      len ? "," : "", n, last);
+    }
+    n = last;
+  }
+}
+
+void mem_policy_name(const mem_policy *policy, char *str, size_t size) {
+  char nodes[256];
+  format_node_list(policy->nodes, nodes, sizeof(nodes));
+  switch (policy->placement) {
+    case MEM_FIRST_TOUCH:
+      snprintf(str, size, "first-touch");
+      break;
+    case MEM_LOCAL:
+      snprintf(str, size, nodes[0] ? "local:%s" : "local", nodes);
+      break;
+    case MEM_BIND:
+      snprintf(str, size, "bind:%s", nodes);
+      break;
+    case MEM_INTERLEAVE:
+      snprintf(str, size, nodes[0] ? "interleave:%s" : "interleave", nodes);
+      break;
+  }
+}
+
+int parse_mem_pages(const char *str, mem_page_size *pages) {
+  const char *names[] = { "default", "base", "thp", "2m", "1g" };
+  for (int p = MEM_PAGES_DEFAULT; p <= MEM_PAGES_1G; ++p) {
+    if (!strcmp(str, names[p])) {
+      *pages = p;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+const char *mem_pages_name(const mem_page_size pages) {
+  switch (pages) {
+    case MEM_PAGES_BASE:
+      return "base";
+    case MEM_PAGES_THP:
+      return "thp";
+    case MEM_PAGES_2M:
+      return "2m";
+    case MEM_PAGES_1G:
+      return "1g";
+    default:
+      return "default";
+  }
+}
+
+/*
+ * Policy of the data of a phase running on cpu_id: local becomes the nodes
+ * of the CPU set (first-touch without NUMA nodes), and interleave without
+ * nodes all the nodes with memory.
+ */
+mem_policy mem_policy_for(const mem_policy *policy, const cpu_set_t *cpu_id) {
+  mem_policy resolved = *policy;
+  if (resolved.placement == MEM_LOCAL &&
+      !topology_nodes(cpu_id, &resolved.nodes, MEM_MAX_NODES)) {
+    resolved.placement = MEM_FIRST_TOUCH;
+  } else if (resolved.placement == MEM_INTERLEAVE && !resolved.nodes) {
+    resolved.nodes = memory_nodes();
+  }
+  return resolved;
+}
+
+/*
+ * Sets the policy of a page-aligned range that has not been touched yet.
+ * Returns 0, or -1 if the kernel refused it (the pages are then placed on
+ * first touch).
+ */
+static int mem_bind(void *addr, const size_t len, const mem_policy *policy) {
+  if (policy->placement == MEM_FIRST_TOUCH || !len) {
+    return 0;
+  }
+#ifdef SYS_mbind
+  const int mode = (policy->placement == MEM_INTERLEAVE) ? MPOL_INTERLEAVE :
+                                                           MPOL_BIND;
+  /* maxnode is one more than the number of bits of the mask */
+  if (!syscall(SYS_mbind, addr, len, mode, &policy->nodes,
+               8 * sizeof(policy->nodes) + 1, 0)) {
+    return 0;
+  }
+  perror("mbind");
+#else
+  printf("mbind is not available, the pages are placed on first touch\n");
+#endif
+  return -1;
+}
+
+/*
+ * Maps hugetlbfs pages of 1 << shift bytes. Without reserved pages, prints a
+ * warning once per page size and returns MAP_FAILED.
+ */
+static char *map_hugetlb(size_t *len, const int shift) {
+  static int warned[2] = { 0, 0 };
+  const size_t huge = (size_t) 1 << shift;
+  char *addr = mmap(NULL, round_up(*len, huge), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                    (shift << MAP_HUGE_SHIFT), -1, 0);
+  if (addr != MAP_FAILED) {
+    *len = round_up(*len, huge);
+  } else if (!__atomic_exchange_n(&warned[shift == 30], 1, __ATOMIC_RELAXED)) {
+    printf("Unable to map %s huge pages (%s), using transparent huge pages "
+           "instead\n", (shift == 30) ? "1G" : "2M", strerror(errno));
+  }
+  return addr;
+}
+
+/*
+ * Allocates zeroed, page-aligned data with a placement policy and page size,
+ * without touching it. Data on transparent huge pages is aligned and padded
+ * to the huge page size, so that all of it can use huge pages.
+ */
+void *mem_alloc(const size_t size, const mem_policy *policy) {
+  const size_t page = page_size();
+  size_t len = round_up(size ? size : 1, page);
+  mem_page_size pages = policy->pages;
+  long page_kb = 0;
+  char *addr = MAP_FAILED;
+
+  if (pages == MEM_PAGES_2M || pages == MEM_PAGES_1G) {
+    const int shift = (pages == MEM_PAGES_2M) ? 21 : 30;
+    if ((addr = map_hugetlb(&len, shift)) != MAP_FAILED) {
+      page_kb = 1L << (shift - 10);
+    } else {
+      pages = MEM_PAGES_THP;
+    }
+  }
+  if (addr == MAP_FAILED) {
+    const size_t align = (pages == MEM_PAGES_THP) ? thp_size() : page;
+    len = round_up(len, align);
+    char *start = mmap(NULL, len + align - page, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (start == MAP_FAILED) {
+      perror("mmap");
+      return NULL;
+    }
+    /* The mapping is trimmed to an aligned start */
+    addr = (char *) round_up((uintptr_t) start, align);
+    if (addr > start) {
+      munmap(start, addr - start);
+    }
+    if (start + len + align - page > addr + len) {
+      munmap(addr + len, start + len + align - page - (addr + len));
+    }
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    if (pages != MEM_PAGES_DEFAULT &&
+        madvise(addr, len, (pages == MEM_PAGES_BASE) ? MADV_NOHUGEPAGE :
+                                                       MADV_HUGEPAGE)) {
+      perror("madvise");
+    }
+#endif
+  }
+  mem_bind(addr, len, policy);
+
+  mem_mapping *mapping = malloc(sizeof(mem_mapping));
+  mapping->addr = addr;
+  mapping->len = len;
+  mapping->size = size;
+  mapping->page_kb = page_kb;
+  pthread_mutex_lock(&mappings_lock);
+  mapping->next = mappings;
+  mappings = mapping;
+  pthread_mutex_unlock(&mappings_lock);
+  return addr;
+}
+
+/* Finds the mapping of ptr, and unlinks it if unlink is set. */
+static mem_mapping *find_mapping(const void *ptr, const int unlink) {
+  mem_mapping **link, *mapping = NULL;
+  pthread_mutex_lock(&mappings_lock);
+  for (link = &mappings; *link; link = &(*link)->next) {
+    if ((*link)->addr == ptr) {
+      mapping = *link;
+      if (unlink) {
+        *link = mapping->next;
+      }
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mappings_lock);
+  return mapping;
+}
+
+void mem_free(void *ptr) {
+  mem_mapping *mapping = ptr ? find_mapping(ptr, 1) : NULL;
+  if (mapping) {
+    munmap(mapping->addr, mapping->len);
+    free(mapping);
+  }
+}
+
+/*
+ * Adds the nodes of the pages of a range to stats, as reported by move_pages
+ * without moving them. At most MEM_SAMPLE_PAGES pages, evenly spaced, are
+ * checked per range.
+ */
+static void count_nodes(const void *addr, const size_t len,
+                        mem_stats *stats) {
+  const size_t page = page_size();
+  const char *start = (const char *) ((uintptr_t) addr & ~(page - 1));
+  const long num_pages = ((const char *) addr + len - start + page - 1) /
+                         page;
+  const long step = (num_pages + MEM_SAMPLE_PAGES - 1) / MEM_SAMPLE_PAGES;
+  void *pages[MEM_QUERY_PAGES];
+  int status[MEM_QUERY_PAGES];
+
+  for (long first = 0; first < num_pages; ) {
+    int count = 0;
+    for (; count < MEM_QUERY_PAGES && first < num_pages; first += step) {
+      pages[count++] = (void *) (start + first * page);
+    }
+#ifdef SYS_move_pages
+    if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0)) {
+      stats->unknown += count;
+      continue;
+    }
+    for (int i = 0; i < count; ++i) {
+      if (status[i] >= 0 && status[i] < MEM_MAX_NODES) {
+        ++stats->pages[status[i]];
+      } else {
+        ++stats->unknown;
+      }
+    }
+#else
+    stats->unknown += count;
+#endif
+  }
+}
+
+/*
+ * Adds the resident memory and transparent huge pages of a range to stats,
+ * from the mappings of /proc/self/smaps that overlap it (in proportion to
+ * the overlap, as the kernel may merge neighbouring mappings).
+ */
+static void count_smaps(const uintptr_t start, const uintptr_t end,
+                        mem_stats *stats) {
+  char line[512];
+  double share = 0;
+  long kb;
+  FILE *file = fopen("/proc/self/smaps", "r");
+  if (!file) {
+    return;
+  }
+  while (fgets(line, sizeof(line), file)) {
+    unsigned long first, last;
+    if (sscanf(line, "%lx-%lx ", &first, &last) == 2) {
+      const uintptr_t lo = (first > start) ? first : start;
+      const uintptr_t hi = (last < end) ? last : end;
+      share = (hi > lo) ? (double) (hi - lo) / (last - first) : 0;
+    } else if (share > 0 && sscanf(line, "Rss: %ld kB", &kb) == 1) {
+      stats->resident_kb += kb * share;
+    } else if (share > 0 && sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) {
+      stats->thp_kb += kb * share;
+    }
+  }
+  fclose(file);
+}
+
+/*
+ * Adds the NUMA nodes and the pages of data allocated with mem_alloc to
+ * stats.
+ */
+void mem_count(const void *ptr, mem_stats *stats) {
+  const mem_mapping *mapping = ptr ? find_mapping(ptr, 0) : NULL;
+  if (!mapping) {
+    return;
+  }
+  count_nodes(mapping->addr, mapping->size, stats);
+  if (mapping->page_kb) {
+    stats->resident_kb += mapping->len / 1024;
+  } else {
+    count_smaps((uintptr_t) mapping->addr,
+                (uintptr_t) mapping->addr + mapping->len, stats);
+  }
+  const long page_kb = mapping->page_kb ? mapping->page_kb :
+                                          (long) page_size() / 1024;
+  if (page_kb > stats->page_kb) {
+    stats->page_kb = page_kb;
+  }
+}
+
+/*
+ * Prints the policy of some data, the share of its pages on each node and
+ * the size of its pages, and adds them to the run record of the results as
+ * key.
+ */
+void mem_report(const char *name, const char *key, const mem_policy *policy,
+                const mem_stats *stats) {
+  char str[1024];
+  long total = stats->unknown;
+  int len;
+  for (int n = 0; n < MEM_MAX_NODES; ++n) {
+    total += stats->pages[n];
+  }
+  mem_policy_name(policy, str, sizeof(str));
+  len = strlen(str);
+  for (int n = 0; n < MEM_MAX_NODES && total; ++n) {
+    if (stats->pages[n] && len < (int) sizeof(str)) {
+      len += snprintf(str + len, sizeof(str) - len, " node%d:%.1f%%", n,
+                      100.0 * stats->pages[n] / total);
+    }
+  }
+  if (stats->unknown && total && len < (int) sizeof(str)) {
+    len += snprintf(str + len, sizeof(str) - len, " unknown:%.1f%%",
+                    100.0 * stats->unknown / total);
+  }
+  if (len < (int) sizeof(str)) {
+    const long kb = stats->page_kb;
+    len += snprintf(str + len, sizeof(str) - len, ", pages %s (%ld%s pages",
+                    mem_pages_name(policy->pages),
+                    (kb >= 1048576) ? kb / 1048576 : (kb >= 1024) ? kb / 1024 :
+                    kb, (kb >= 1048576) ? "G" : (kb >= 1024) ? "M" : "K");
+  }
+  if (stats->thp_kb && stats->resident_kb && len < (int) sizeof(str)) {
+    len += snprintf(str + len, sizeof(str) - len,
+                    ", %.1f%% in %zuM transparent huge pages",
+                    100.0 * stats->thp_kb / stats->resident_kb,
+                    thp_size() >> 20);
+  }
+  if (len < (int) sizeof(str)) {
+    snprintf(str + len, sizeof(str) - len, ")");
+  }
+  printf("%s data placement %s\n", name, str);
+  results_param_str(key, str);
+}
@@ -0,0 +1,103 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+#include "meabo.h"
+
+/*
+ * NUMA placement of the data of a phase:
+ * - first-touch: no policy, each page lands on the node of the thread that
+ *   first writes it, i.e. the worker threads of the parallel initialisation;
+ * - local: bound to the nodes of the CPU set of the phase;
+ * - bind: bound to the given nodes;
+ * - interleave: pages spread round-robin over the given nodes (default: all
+ *   the nodes with memory).
+ * Policies are set with mbind before the data is first touched, so they do
+ * not need libnuma.
+ */
+typedef enum mem_placement {
+  MEM_FIRST_TOUCH = 0,
+  MEM_LOCAL,
+  MEM_BIND,
+  MEM_INTERLEAVE
+} mem_placement;
+
+/*
+ * Pages backing the data of a phase, to separate the TLB cost from the cache
+ * cost:
+ * - default: whatever the system gives (transparent huge pages if they are
+ *   enabled for all memory);
+ * - base: base pages only (4 KiB on most systems), with MADV_NOHUGEPAGE;
+ * - thp: transparent huge pages, with MADV_HUGEPAGE on huge page aligned data;
+ * - 2m, 1g: explicit hugetlbfs pages (MAP_HUGETLB), which must be reserved,
+ *   e.g. in /proc/sys/vm/nr_hugepages. Without reserved pages, the data falls
+ *   back to transparent huge pages.
+ */
+typedef enum mem_page_size {
+  MEM_PAGES_DEFAULT = 0,
+  MEM_PAGES_BASE,
+  MEM_PAGES_THP,
+  MEM_PAGES_2M,
+  MEM_PAGES_1G
+} mem_page_size;
+
+/* Nodes that fit in the node mask of a policy */
+#define MEM_MAX_NODES (8 * (int) sizeof(unsigned long))
+
+typedef struct mem_policy {
+  mem_placement placement;
+  unsigned long nodes;      /* bit n for node n */
+  mem_page_size pages;
+} mem_policy;
+
+/*
+ * Pages of some data per NUMA node, as reported by move_pages, and the page
+ * size actually obtained, from the mapping and /proc/self/smaps.
+ */
+typedef struct mem_stats {
+  long pages[MEM_MAX_NODES];
+  long unknown;             /* not present yet, or no NUMA support */
+  long page_kb;             /* largest page size of the mappings */
+  long resident_kb;
+  long thp_kb;              /* resident in transparent huge pages */
+} mem_stats;
+
+int parse_mem_policy(const char *str, mem_policy *policy);
+
+void mem_policy_name(const mem_policy *policy, char *str, size_t size);
+
+int parse_mem_pages(const char *str, mem_page_size *pages);
+
+const char *mem_pages_name(const mem_page_size pages);
+
+mem_policy mem_policy_for(const mem_policy *policy, const cpu_set_t *cpu_id);
+
+void *mem_alloc(const size_t size, const mem_policy *policy);
+
+void mem_free(void *ptr);
+
+void mem_count(const void *ptr, mem_stats *stats);
+
+void mem_report(const char *name, const char *key, const mem_policy *policy,
+                const mem_stats *stats);
+
+#endif /* MEMORY_H_ */
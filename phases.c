@@ -0,0 +1,1443 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "phases.h"
+#include "init_data.h"
+#include "validation.h"
+#include "util.h"
+#include "histogram.h"
+#include "counters.h"
+#include "results.h"
+#include "roofline.h"
+#include "topology.h"
+#include "stats.h"
+
+#include <limits.h>
+
+/* One run of a phase, with the size and particles of its step */
+typedef struct phase_run {
+  int phase;
+  int num_iterations;
+  long size;
+  int num_threads;
+  const cpu_set_t *cpu_id;
+  particle_set *particles;
+} phase_run;
+
+/*
+ * Phases that share data (or, with RED_VALIDATION, reduced validation
+ * arrays) cannot run at the same time.
+ */
+static int phase_data_class(const int phase) {
+  return (phase == 3) ? 1 : (phase == 4 || phase == 5) ? 2 : phase;
+}
+
+#if RED_VALIDATION
+static int phase_red_class(const int phase) {
+  return (phase == 3) ? 7 : (phase <= 6 || phase == 8) ? 1 : phase;
+}
+#endif
+
+/*
+ * The phases of a corun group must be different and have disjoint CPU sets,
+ * for their thread teams to compete for the shared caches and memory only.
+ */
+static int check_corun(const phase_step *steps, const int num_steps) {
+  for (int s = 0; s < num_steps; ++s) {
+    if (!steps[s].cpu_id) {
+      printf("Co-scheduled phase %d needs a CPU set (cpus=)\n",
+             steps[s].phase);
+      return -1;
+    }
+    for (int t = 0; t < s; ++t) {
+      if (cpu_lists_intersect(steps[s].cpu_id, steps[t].cpu_id)) {
+        printf("Co-scheduled phases %d and %d have overlapping CPU sets\n",
+               steps[t].phase, steps[s].phase);
+        return -1;
+      }
+      if (phase_data_class(steps[s].phase) ==
+          phase_data_class(steps[t].phase)) {
+        printf("Phases %d and %d share their data and cannot be "
+               "co-scheduled\n", steps[t].phase, steps[s].phase);
+        return -1;
+      }
+#if RED_VALIDATION
+      if (phase_red_class(steps[s].phase) ==
+          phase_red_class(steps[t].phase)) {
+        printf("Phases %d and %d share their reduced validation data and "
+               "cannot be co-scheduled\n", steps[t].phase, steps[s].phase);
+        return -1;
+      }
+#endif
+    }
+  }
+  return 0;
+}
+
+/*
+ * Phases whose working set shrinks with the size of a step. Phases 6 and 7
+ * have no size, and the gathers of phases 2 and 5 use indices drawn over the
+ * whole arrays, so they touch as many cache lines at any size.
+ */
+static int phase_has_size(const int phase) {
+  return phase != 2 && phase != 5 && phase != 6 && phase != 7;
+}
+
+/*
+ * Reads a run script: one step per line, "phase <n> [<key>=<value> ...]" or
+ * "idle <seconds>", where # starts a comment. The keys are iterations,
+ * target (seconds, see calibrated_step), threads, cpus, repeat, warmup and
+ * size (the array size of phases 1, 3 and 4, the number of particles,
+ * palindromes or random locations of phases 8 to 10; the indices of phases
+ * 2 and 5 span the whole arrays, so a smaller size would not shrink them);
+ * the keys that are not given are taken from defaults[phase]. cpus is a CPU
+ * set (see parse_cpu_list), and numbers can be given in hexadecimal. The
+ * phases between "corun [repeat=N]" and "end" are co-scheduled. Returns the
+ * number of steps, or -1.
+ */
+int parse_run_script(const char *path, const phase_step *defaults,
+    phase_step **steps) {
+  FILE *file = fopen(path, "r");
+  char line[1024];
+  int num_steps = 0, allocated = 0, line_num = 0;
+  int corun = 0, num_coruns = 0, corun_first = 0, corun_repeat = 1;
+  phase_step step;
+  *steps = NULL;
+  if (!file) {
+    printf("Unable to open run script %s\n", path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), file)) {
+    char *comment = strchr(line, '#'), *saveptr, *token, *end;
+    ++line_num;
+    if (comment) {
+      *comment = 0;
+    }
+    if (!(token = strtok_r(line, " \t\r\n", &saveptr))) {
+      continue;
+    }
+    if (!strcmp(token, "corun")) {
+      if (corun) {
+        goto error;
+      }
+      corun_repeat = 1;
+      if ((token = strtok_r(NULL, " \t\r\n", &saveptr)) &&
+          (strncmp(token, "repeat=", 7) ||
+           (corun_repeat = strtol(token + 7, &end, 0)) < 1 || *end ||
+           strtok_r(NULL, " \t\r\n", &saveptr))) {
+        goto error;
+      }
+      corun = ++num_coruns;
+      corun_first = num_steps;
+      continue;
+    }
+    if (!strcmp(token, "end")) {
+      if (!corun || strtok_r(NULL, " \t\r\n", &saveptr) ||
+          num_steps == corun_first) {
+        goto error;
+      }
+      if (check_corun(*steps + corun_first, num_steps - corun_first)) {
+        goto error;
+      }
+      for (int s = corun_first; s < num_steps; ++s) {
+        (*steps)[s].repeat = corun_repeat;
+      }
+      corun = 0;
+      continue;
+    }
+    if (!strcmp(token, "idle") && !corun) {
+      memset(&step, 0, sizeof(step));
+      step.phase = PHASE_IDLE;
+      step.repeat = 1;
+      if (!(token = strtok_r(NULL, " \t\r\n", &saveptr)) ||
+          (step.idle_seconds = strtod(token, &end)) < 0 || *end ||
+          strtok_r(NULL, " \t\r\n", &saveptr)) {
+        goto error;
+      }
+    } else if (!strcmp(token, "phase")) {
+      if (!(token = strtok_r(NULL, " \t\r\n", &saveptr))) {
+        goto error;
+      }
+      const long phase = strtol(token, &end, 10);
+      if (*end || phase < 1 || phase > NUM_PHASES) {
+        goto error;
+      }
+      step = defaults[phase];
+      step.corun = corun;
+      while ((token = strtok_r(NULL, " \t\r\n", &saveptr))) {
+        char *value = strchr(token, '=');
+        long number;
+        if (!value || !value[1]) {
+          goto error;
+        }
+        *value++ = 0;
+        if (!strcmp(token, "cpus")) {
+          if (parse_cpu_list(value, &step.cpu_id)) {
+            goto error;
+          }
+          continue;
+        }
+        if (!strcmp(token, "target")) {
+          if ((step.target_seconds = strtod(value, &end)) <= 0 || *end) {
+            goto error;
+          }
+          continue;
+        }
+        number = strtol(value, &end, 0);
+        if (*end) {
+          goto error;
+        }
+        if (!strcmp(token, "iterations") && number > 0) {
+          step.num_iterations = number;
+          step.target_seconds = 0;
+        } else if (!strcmp(token, "threads") && number >= 0) {
+          step.num_threads = number;
+        } else if (!strcmp(token, "repeat") && number > 0 && !corun) {
+          step.repeat = number;
+        } else if (!strcmp(token, "warmup") && number >= 0) {
+          step.warmup = number;
+        } else if (!strcmp(token, "size") && number > 0 &&
+                   phase_has_size(phase)) {
+          step.size = number;
+        } else {
+          goto error;
+        }
+      }
+    } else {
+      goto error;
+    }
+    if (num_steps == allocated) {
+      allocated = allocated ? 2 * allocated : 16;
+      *steps = realloc(*steps, sizeof(phase_step) * allocated);
+    }
+    (*steps)[num_steps++] = step;
+  }
+  fclose(file);
+  if (corun) {
+    printf("Missing end of corun in run script %s\n", path);
+    free(*steps);
+    *steps = NULL;
+    return -1;
+  }
+  if (!num_steps) {
+    printf("Run script %s has no step\n", path);
+    return -1;
+  }
+  return num_steps;
+
+error:
+  printf("Invalid step at line %d of run script %s\n", line_num, path);
+  printf("Steps are \"phase <n> [iterations=N] [target=<seconds>] "
+         "[threads=N] [cpus=<cpulist>] [repeat=N] [warmup=N] [size=N]\" or "
+         "\"idle <seconds>\", and co-scheduled phases are listed between "
+         "\"corun [repeat=N]\" and \"end\"\n");
+  fclose(file);
+  free(*steps);
+  *steps = NULL;
+  return -1;
+}
+
+static void run_kernel(phase_data *data, const phase_run *run) {
+  switch (run->phase) {
+    case 1:
+      phase1_compute(run->num_iterations, run->size, data->block_size,
+          1.0, 1.0, 1.0, 1, 1, 1, data->vals, data->int_vals, 0,
+          run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , data->valid_red_vals, data->valid_red_int_vals
+#endif
+          );
+      break;
+    case 2:
+      phase2_compute(run->num_iterations, run->size, data->dest, data->src1,
+          data->src2, data->ind_src2, 0, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , data->valid_red_vals
+#endif
+          );
+      break;
+    case 3:
+      phase3_compute(run->num_iterations, run->size, data->vals,
+          &data->reduction_var, 0, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , &data->valid_red_reduction_var
+#endif
+          );
+      break;
+    case 4:
+      phase4_compute(run->num_iterations, run->size, data->dest, data->src1,
+          data->src2, 0, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , data->valid_red_vals
+#endif
+          );
+      break;
+    case 5:
+      phase5_compute(run->num_iterations, run->size, data->dest, data->src1,
+          data->src2, data->ind_src1, data->ind_src2, 0, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , data->valid_red_vals
+#endif
+          );
+      break;
+    case 6:
+      phase6_compute(run->num_iterations, data->matrix, data->vect_in,
+          data->vect_out, 0, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , data->valid_red_vals
+#endif
+          );
+      break;
+    case 7:
+      phase7_compute(run->num_iterations, data->llist_size, data->llist, 0,
+          run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , &data->valid_red_reduction_var
+#endif
+          );
+      break;
+    case 8:
+      phase8_compute(run->num_iterations, run->particles, &data->phase8_spec,
+          data->forces, 0, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , data->valid_red_vals
+#endif
+          );
+      break;
+    case 9:
+      phase9_compute(run->num_iterations, run->size, data->palindromes,
+          data->phase9_mode, 0, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+#if RED_VALIDATION
+          , data->valid_red_ulong_vals
+#endif
+          );
+      break;
+    case 10:
+      phase10_compute(run->num_iterations, run->size, data->randomloc,
+          &data->gups_spec, 0, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+          );
+      break;
+  }
+}
+
+static phase_work run_work(const phase_data *data, const phase_run *run) {
+  switch (run->phase) {
+    case 1:
+      return phase1_work(run->num_iterations, run->size);
+    case 2:
+      return phase2_work(run->num_iterations, run->size);
+    case 3:
+      return phase3_work(run->num_iterations, run->size);
+    case 4:
+      return phase4_work(run->num_iterations, run->size);
+    case 5:
+      return phase5_work(run->num_iterations, run->size);
+    case 6:
+      return phase6_work(run->num_iterations, data->matrix);
+    case 7:
+      return phase7_work(run->num_iterations, data->llist_size,
+                         run->num_threads);
+    case 8:
+      return phase8_work(run->num_iterations, run->particles,
+                         &data->phase8_spec);
+    case 9:
+      return phase9_work(run->num_iterations, run->size);
+    default:
+      return phase10_work(run->num_iterations, run->size);
+  }
+}
+
+/*
+ * Validation of the run (see meabo.c): the full validation repeats the run
+ * serially on the validation arrays, so that it keeps up with any sequence
+ * of steps, and with the generic kernels, so that it also checks the
+ * hand-written ones (-V).
+ */
+static void validate_run(phase_data *data, const phase_run *run,
+    time_t rawtime) {
+#if RED_VALIDATION || FULL_VALIDATION
+  const int size = run->size;
+#endif
+#if FULL_VALIDATION
+  const simd_kernels kernels = simd_dispatch;
+  simd_select(SIMD_GENERIC);
+#endif
+  switch (run->phase) {
+    case 1:
+#if RED_VALIDATION
+      validation_array("Reduced", size, data->vals, data->valid_red_vals, 1,
+          rawtime);
+      validation_array("Reduced", size, data->int_vals,
+          data->valid_red_int_vals, 1, rawtime);
+#endif
+#if FULL_VALIDATION
+      full_validation(phase1_compute_wrapper, 1, rawtime,
+ #if RED_VALIDATION
+          20,
+ #else
+          18,
+ #endif
+          run->num_iterations, size, data->block_size, 1.0, 1.0, 1.0, 1, 1, 1,
+          data->valid_vals, data->valid_int_vals, 1, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+ #if RED_VALIDATION
+          , data->valid_red_vals, data->valid_red_int_vals
+ #endif
+          , data->vals, data->int_vals);
+#endif
+      break;
+    case 2:
+#if RED_VALIDATION
+      validation_array("Reduced", size, data->dest, data->valid_red_vals, 2,
+          rawtime);
+#endif
+#if FULL_VALIDATION
+      full_validation(phase2_compute_wrapper, 2, rawtime,
+ #if RED_VALIDATION
+          13,
+ #else
+          12,
+ #endif
+          run->num_iterations, size, data->valid_dest, data->valid_src1,
+          data->valid_src2, data->valid_ind_src2, 1, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+ #if RED_VALIDATION
+          , data->valid_red_vals
+ #endif
+          , data->dest);
+#endif
+      break;
+    case 3:
+#if RED_VALIDATION
+      reduced_validation_var(size, data->vals, data->valid_red_reduction_var,
+          3, rawtime);
+#endif
+#if FULL_VALIDATION
+      full_validation(phase3_compute_wrapper, 3, rawtime,
+ #if RED_VALIDATION
+          11,
+ #else
+          10,
+ #endif
+          run->num_iterations, size, data->valid_vals, data->reduction_var, 1,
+          run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+ #if RED_VALIDATION
+          , data->valid_red_reduction_var
+ #endif
+          , data->vals);
+#endif
+      break;
+    case 4:
+#if RED_VALIDATION
+      validation_array("Reduced", size, data->dest, data->valid_red_vals, 4,
+          rawtime);
+#endif
+#if FULL_VALIDATION
+      full_validation(phase4_compute_wrapper, 4, rawtime,
+ #if RED_VALIDATION
+          12,
+ #else
+          11,
+ #endif
+          run->num_iterations, size, data->valid_dest, data->valid_src1,
+          data->valid_src2, 1, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+ #if RED_VALIDATION
+          , data->valid_red_vals
+ #endif
+          , data->dest);
+#endif
+      break;
+    case 5:
+#if RED_VALIDATION
+      validation_array("Reduced", size, data->dest, data->valid_red_vals, 5,
+          rawtime);
+#endif
+#if FULL_VALIDATION
+      full_validation(phase5_compute_wrapper, 5, rawtime,
+ #if RED_VALIDATION
+          14,
+ #else
+          13,
+ #endif
+          run->num_iterations, size, data->valid_dest, data->valid_src1,
+          data->valid_src2, data->valid_ind_src1, data->valid_ind_src2, 1,
+          run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+ #if RED_VALIDATION
+          , data->valid_red_vals
+ #endif
+          , data->dest);
+#endif
+      break;
+    case 6:
+#if RED_VALIDATION
+      validation_array("Reduced", data->matrix->nrow, data->vect_out,
+          data->valid_red_vals, 6, rawtime);
+      printf("Reduced validation for phase 6 ended at %s\n", ctime(&rawtime));
+#endif
+#if FULL_VALIDATION
+      full_validation(phase6_compute_wrapper, 6, rawtime,
+ #if RED_VALIDATION
+          11,
+ #else
+          10,
+ #endif
+          run->num_iterations, data->matrix, data->valid_vect_in,
+          data->valid_vect_out, 1, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+ #if RED_VALIDATION
+          , data->valid_red_vals
+ #endif
+          , data->vect_out);
+#endif
+      break;
+    case 7:
+#if RED_VALIDATION
+      reduced_validation_sg_var(data->valid_red_reduction_var,
+          (double) (data->llist_size - 1), 7, rawtime);
+#endif
+#if FULL_VALIDATION
+      printf("There is no full validation for phase 7, as we do not modify "
+          "the linked list data.\n");
+#endif
+      break;
+    case 8:
+#if RED_VALIDATION
+      validation_array("Reduced",
+          (data->phase8_spec.mode == PHASE8_NEIGHBOUR ? size - 1 : size),
+          data->forces, data->valid_red_vals, 8, rawtime);
+#endif
+#if FULL_VALIDATION
+      full_validation(phase8_compute_wrapper, 8, rawtime,
+ #if RED_VALIDATION
+          11,
+ #else
+          10,
+ #endif
+          run->num_iterations, run->particles, &data->phase8_spec,
+          data->valid_forces, 1, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+ #if RED_VALIDATION
+          , data->valid_red_vals
+ #endif
+          , data->forces);
+#endif
+      break;
+    case 9:
+#if RED_VALIDATION
+      validation_array("Reduced", size, data->palindromes,
+          data->valid_red_ulong_vals, 9, rawtime);
+#endif
+#if FULL_VALIDATION
+      full_validation(phase9_compute_wrapper, 9, rawtime,
+ #if RED_VALIDATION
+          12,
+ #else
+          11,
+ #endif
+          run->num_iterations, size, data->valid_palindromes,
+          data->phase9_mode, 1, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+ #if RED_VALIDATION
+          , data->valid_red_ulong_vals
+ #endif
+          , data->palindromes);
+#endif
+      break;
+    case 10:
+#if RED_VALIDATION
+      /* All threads update the whole table */
+      printf("There is no reduced validation for phase 10, as all threads "
+          "update the whole table.\n");
+#endif
+#if FULL_VALIDATION
+      /*
+       * Replaying the updates serially undoes them. Racy updates may be lost;
+       * HPCC RandomAccess accepts up to 1% of wrong entries.
+       */
+      phase10_compute(run->num_iterations, size, data->randomloc,
+          &data->gups_spec, 1, run->num_threads
+#if ENABLE_BINDING
+          , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+          );
+      {
+        long errors = 0;
+        for (long j = 0; j < size; ++j) {
+          errors += (data->randomloc[j] != j);
+        }
+        printf("Full validation for phase 10: %ld wrong entries\n", errors);
+        if (errors && (data->gups_spec.update == GUPS_ATOMIC ||
+                       errors * 100 > size)) {
+          printf("Full validation for phase 10 failed\n");
+        } else {
+          printf("Full validation for phase 10 succeeded\n");
+        }
+      }
+#endif
+      break;
+  }
+#if FULL_VALIDATION
+  simd_dispatch = kernels;
+#endif
+}
+
+static void init_run(const phase_data *data, const phase_step *step,
+    phase_run *run, particle_set *particles) {
+  run->phase = step->phase;
+  run->num_iterations = step->num_iterations;
+  run->size = step->size;
+  run->num_threads = get_num_threads(step->cpu_id, data->num_cpus,
+                                     step->num_threads);
+  run->cpu_id = step->cpu_id;
+  run->particles = NULL;
+  /* Steps without a size run on the whole data */
+  if (!run->size) {
+    run->size = (run->phase <= 5) ? data->array_size :
+                (run->phase == 8) ? data->particles->num_particles :
+                (run->phase == 9) ? data->num_palindromes :
+                data->num_randomloc;
+  }
+  /* Smaller particle sets are the first particles of the whole set */
+  if (run->phase == 8) {
+    *particles = *data->particles;
+    particles->num_particles = run->size;
+    run->particles = particles;
+  }
+}
+
+#if ENABLE_BINDING
+/*
+ * Binds the OpenMP team of a run as its kernel will, before the kernel is
+ * timed: the master thread, which is thread 0 of the team, then the other
+ * threads. The runtime keeps the threads for the kernel, which finds them
+ * bound, so its duration does not include the affinity changes.
+ */
+static void bind_team(const phase_data *data, const phase_run *run,
+    const int print) {
+  if (data->bind_to_cpu_set) {
+    bind_to_cpu_w_reset(run->cpu_id, data->num_cpus, print);
+  } else {
+    bind_to_available_cpu_w_reset(run->cpu_id, data->num_cpus, print, 0);
+  }
+  #pragma omp parallel num_threads(run->num_threads)
+  {
+    if (data->bind_to_cpu_set) {
+      bind_to_cpu_w_reset(run->cpu_id, data->num_cpus, 0);
+    } else {
+#ifdef _OPENMP
+      bind_to_available_cpu_w_reset(run->cpu_id, data->num_cpus, 0,
+                                    omp_get_thread_num());
+#endif
+    }
+  }
+}
+#endif
+
+/*
+ * Runs the kernel outside of run_phase, to calibrate its iterations, and
+ * returns its duration. The run is validated like any other, so that the
+ * full validation keeps up with the data.
+ */
+static unsigned long long calibration_run(phase_data *data,
+    const phase_run *run) {
+  struct timespec t1, t2;
+  time_t rawtime;
+#if ENABLE_BINDING
+  bind_team(data, run, 0);
+#endif
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+  run_kernel(data, run);
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
+  time(&rawtime);
+  validate_run(data, run, rawtime);
+  return duration(t1, t2);
+}
+
+/*
+ * Iterations of a step that run for about target_ns: after a warm-up run of
+ * a few iterations, the iterations are doubled until a run takes
+ * 1/CALIBRATION_FRACTION of the target (at least CALIBRATION_MIN_NS), then
+ * scaled to the target. Phases 6 and 9 run their iterations by 5 and 10.
+ */
+#define CALIBRATION_MIN_NS 1000000ULL
+#define CALIBRATION_FRACTION 20
+
+static int calibrate_iterations(phase_data *data, const phase_step *step,
+    const double target_ns) {
+  particle_set particles;
+  phase_run run;
+  const int unit = (step->phase == 6) ? 5 : (step->phase == 9) ? 10 : 1;
+  double min_ns = target_ns / CALIBRATION_FRACTION, iterations;
+  unsigned long long ns;
+  if (min_ns < CALIBRATION_MIN_NS) {
+    min_ns = CALIBRATION_MIN_NS;
+  }
+  init_run(data, step, &run, &particles);
+  run.num_iterations = unit;
+  /* Warm-up: page faults, caches and frequency */
+  calibration_run(data, &run);
+  while ((ns = calibration_run(data, &run)) < min_ns &&
+         run.num_iterations <= INT_MAX / 4) {
+    run.num_iterations *= 2;
+  }
+  iterations = (double) run.num_iterations * target_ns / (ns ? ns : 1);
+  if (iterations > INT_MAX / 2) {
+    iterations = INT_MAX / 2;
+  }
+  return (iterations < unit) ? unit : (int) (iterations / unit) * unit;
+}
+
+static unsigned long long run_phase(phase_data *data,
+    const phase_step *step) {
+  struct timespec t1, t2;
+  time_t rawtime;
+  particle_set particles;
+  phase_run run;
+  init_run(data, step, &run, &particles);
+#if ENABLE_ENERGY
+  char start_label[32], stop_label[32];
+  snprintf(start_label, sizeof(start_label), "#PHASE%d_START", run.phase);
+  snprintf(stop_label, sizeof(stop_label), "#PHASE%d_STOP", run.phase);
+#endif
+
+  time(&rawtime);
+  printf("Starting phase %d... %s\n", run.phase, ctime(&rawtime));
+#if ENABLE_BINDING
+  const long affinity_changes = get_affinity_changes();
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+  bind_team(data, &run, 1);
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
+  printf("Phase %d binding duration (ns): %llu (%ld affinity changes)\n",
+         run.phase, duration(t1, t2),
+         get_affinity_changes() - affinity_changes);
+  results_phase_value("binding_ns", duration(t1, t2));
+  results_phase_value("affinity_changes",
+                      get_affinity_changes() - affinity_changes);
+#endif
+
+  /* In the repeat mode (-m), the phase is run once per counter group. */
+  do {
+#if ENABLE_ENERGY
+    read_energy(start_label);
+#endif
+    timing_start(run.num_threads);
+    results_start_phase(run.num_threads);
+    counters_start(run.num_threads);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+    run_kernel(data, &run);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
+    timing_stop();
+    counters_stop();
+#if ENABLE_ENERGY
+    read_energy(stop_label);
+#endif
+  } while (counters_next_run());
+
+  const phase_work work = run_work(data, &run);
+  printf("Phase %d duration (ns): %llu\n", run.phase, duration(t1, t2));
+  timing_report(run.phase);
+  counters_report(run.phase);
+  roofline_phase(run.phase, duration(t1, t2), work);
+#if ENABLE_ENERGY
+  energy_report(run.phase, work.bytes, work.flops);
+#endif
+  results_phase(run.phase, duration(t1, t2), work, run.num_threads,
+                run.cpu_id);
+  if (run.phase == 10) {
+    printf("Phase 10 GUP/s: %.6f\n",
+           (double) run.num_iterations * run.size / duration(t1, t2));
+  }
+  time(&rawtime);
+  printf("Phase %d completed at %s\n", run.phase, ctime(&rawtime));
+
+  validate_run(data, &run, rawtime);
+  return duration(t1, t2);
+}
+
+/*
+ * Idle steps sleep, so that the energy readings show the idle power between
+ * bursts of work. They are reported as phase 0.
+ */
+static void run_idle(const phase_step *step) {
+  struct timespec t1, t2, idle;
+  const phase_work work = { 0, 0, 0 };
+  idle.tv_sec = (time_t) step->idle_seconds;
+  idle.tv_nsec = (step->idle_seconds - idle.tv_sec) * 1e9;
+
+  printf("Idling for %g s...\n", step->idle_seconds);
+#if ENABLE_ENERGY
+  read_energy("#IDLE_START");
+#endif
+  timing_start(1);
+  results_start_phase(1);
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+  while (nanosleep(&idle, &idle) && errno == EINTR) {
+  }
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
+  timing_stop();
+#if ENABLE_ENERGY
+  read_energy("#IDLE_STOP");
+#endif
+
+  printf("Idle duration (ns): %llu\n", duration(t1, t2));
+#if ENABLE_ENERGY
+  energy_report(PHASE_IDLE, 0, 0);
+#endif
+  results_phase(PHASE_IDLE, duration(t1, t2), work, 0, NULL);
+}
+
+/*
+ * The step with its iterations calibrated to its target duration, if it has
+ * one, and the chosen iterations printed.
+ */
+static phase_step calibrated_step(phase_data *data, const phase_step *step) {
+  phase_step calibrated = *step;
+  if (step->phase != PHASE_IDLE && step->target_seconds > 0) {
+    calibrated.num_iterations =
+        calibrate_iterations(data, step, step->target_seconds * 1e9);
+    printf("Phase %d calibrated iterations: %d (target %g s)\n", step->phase,
+           calibrated.num_iterations, step->target_seconds);
+  }
+  return calibrated;
+}
+
+/* Warm-up runs of a step, untimed: page faults, caches and frequency */
+static void warm_up_step(phase_data *data, const phase_step *step) {
+  particle_set particles;
+  phase_run run;
+  if (step->phase == PHASE_IDLE || !step->warmup) {
+    return;
+  }
+  init_run(data, step, &run, &particles);
+  printf("Phase %d warm-up runs: %d\n", step->phase, step->warmup);
+  for (int w = 0; w < step->warmup; ++w) {
+    calibration_run(data, &run);
+  }
+}
+
+/*
+ * Runs a step repeat times, after its warm-up runs, and returns the time
+ * spent in the phase (idle steps do not count). With a stable_ci, the step
+ * stops repeating once its durations are stable (see run_stats_stable).
+ * The statistics of two runs or more are printed and written as a stats
+ * record. With a step_index (run scripts), the results records of the step
+ * have its index and the number of the repetition. Steps with a target
+ * duration are calibrated once, before their repetitions.
+ */
+unsigned long long run_step(phase_data *data, const phase_step *orig_step,
+    const int step_index) {
+  const phase_step calibrated = calibrated_step(data, orig_step);
+  const phase_step *step = &calibrated;
+  unsigned long long total = 0;
+  unsigned long long *durations = malloc(sizeof(unsigned long long) *
+                                         step->repeat);
+  run_stats stats;
+  int runs = 0, stable = 0;
+  warm_up_step(data, step);
+  for (int r = 0; r < step->repeat && !stable; ++r) {
+    if (step_index >= 0) {
+      results_phase_value("step", step_index);
+      results_phase_value("repetition", r);
+    }
+    if (step->phase == PHASE_IDLE) {
+      run_idle(step);
+      continue;
+    }
+    durations[runs] = run_phase(data, step);
+    total += durations[runs++];
+    if (step->stable_ci > 0) {
+      run_stats_compute(durations, runs, &stats);
+      stable = run_stats_stable(&stats, step->stable_ci);
+    }
+  }
+  if (runs > 1) {
+    run_stats_compute(durations, runs, &stats);
+    run_stats_print(step->phase, &stats);
+    if (step->stable_ci > 0) {
+      printf("Phase %d %s within %g%% after %d runs\n", step->phase,
+             stable ? "stable" : "not stable", step->stable_ci, runs);
+      results_phase_value("stable", stable);
+    }
+    if (step_index >= 0) {
+      results_phase_value("step", step_index);
+    }
+    results_stats(step->phase, &stats);
+  }
+  free(durations);
+  return total;
+}
+
+static int earlier(const struct timespec t1, const struct timespec t2) {
+  return t1.tv_sec < t2.tv_sec ||
+         (t1.tv_sec == t2.tv_sec && t1.tv_nsec < t2.tv_nsec);
+}
+
+/* Thread team of a co-scheduled phase */
+typedef struct corun_team {
+  phase_data *data;
+  phase_run run;
+  particle_set particles;
+  pthread_barrier_t *barrier;
+  struct timespec t1, t2;
+} corun_team;
+
+static void *corun_team_main(void *arg) {
+  corun_team *team = arg;
+#if ENABLE_BINDING
+  /* The OpenMP team of this thread is bound before the synchronised start */
+  bind_team(team->data, &team->run, 0);
+#endif
+  pthread_barrier_wait(team->barrier);
+  clock_gettime(CLOCK_MONOTONIC_RAW, &team->t1);
+  run_kernel(team->data, &team->run);
+  clock_gettime(CLOCK_MONOTONIC_RAW, &team->t2);
+#if ENABLE_BINDING
+  /* The team exits with this thread */
+  #pragma omp parallel num_threads(team->run.num_threads)
+  forget_affinity();
+#endif
+  return NULL;
+}
+
+/*
+ * Runs the steps of a corun group at the same time: each phase is first run
+ * alone, as the baseline, then all of them are started together, each by its
+ * own thread with its own OpenMP team. The slowdown of each phase is its
+ * co-scheduled duration over its duration alone. Co-scheduled runs have no
+ * iteration times, counters or energy readings of their own. Returns the
+ * time spent in the phases alone and in the co-scheduled runs (from the
+ * first start to the last end). The steps are calibrated (if they have a
+ * target duration) and warmed up alone.
+ */
+unsigned long long run_corun(phase_data *data, const phase_step *orig_steps,
+    const int num_steps, const int step_index) {
+  phase_step *steps = malloc(sizeof(phase_step) * num_steps);
+  corun_team *teams = calloc(num_steps, sizeof(corun_team));
+  pthread_t *threads = malloc(sizeof(pthread_t) * num_steps);
+  unsigned long long *alone = malloc(sizeof(unsigned long long) * num_steps);
+  unsigned long long total = 0;
+  pthread_barrier_t barrier;
+  time_t rawtime;
+
+  for (int s = 0; s < num_steps; ++s) {
+    steps[s] = calibrated_step(data, &orig_steps[s]);
+    warm_up_step(data, &steps[s]);
+    results_phase_value("step", step_index + s);
+    results_phase_value("alone", 1);
+    alone[s] = run_phase(data, &steps[s]);
+    total += alone[s];
+  }
+
+  pthread_barrier_init(&barrier, NULL, num_steps);
+  for (int r = 0; r < steps[0].repeat; ++r) {
+    struct timespec first, last;
+    time(&rawtime);
+    printf("Starting co-scheduled phases");
+    for (int s = 0; s < num_steps; ++s) {
+      printf(" %d", steps[s].phase);
+    }
+    printf("... %s\n", ctime(&rawtime));
+    timing_start(1);
+    timing_stop();
+    for (int s = 0; s < num_steps; ++s) {
+      teams[s].data = data;
+      teams[s].barrier = &barrier;
+      init_run(data, &steps[s], &teams[s].run, &teams[s].particles);
+      if (pthread_create(&threads[s], NULL, corun_team_main, &teams[s])) {
+        printf("Unable to start co-scheduled phase %d\n", steps[s].phase);
+        exit(1);
+      }
+    }
+    for (int s = 0; s < num_steps; ++s) {
+      pthread_join(threads[s], NULL);
+    }
+
+    first = teams[0].t1;
+    last = teams[0].t2;
+    for (int s = 0; s < num_steps; ++s) {
+      const phase_run *run = &teams[s].run;
+      const unsigned long long ns = duration(teams[s].t1, teams[s].t2);
+      const phase_work work = run_work(data, run);
+      const double slowdown = alone[s] ? (double) ns / alone[s] : 0;
+      if (earlier(teams[s].t1, first)) {
+        first = teams[s].t1;
+      }
+      if (earlier(last, teams[s].t2)) {
+        last = teams[s].t2;
+      }
+      printf("Phase %d co-scheduled duration (ns): %llu (alone %llu, "
+             "slowdown %.3fx, %.3f GB/s)\n", run->phase, ns, alone[s],
+             slowdown, ns ? work.bytes / ns : 0);
+      results_start_phase(run->num_threads);
+      results_phase_value("step", step_index + s);
+      results_phase_value("repetition", r);
+      results_phase_value("corun", steps[s].corun);
+      results_phase_value("alone_ns", alone[s]);
+      results_phase_value("slowdown", slowdown);
+      results_phase(run->phase, ns, work, run->num_threads, run->cpu_id);
+    }
+    printf("Co-scheduled phases duration (ns): %llu\n", duration(first, last));
+    total += duration(first, last);
+    time(&rawtime);
+    printf("Co-scheduled phases completed at %s\n", ctime(&rawtime));
+
+    for (int s = 0; s < num_steps; ++s) {
+      validate_run(data, &teams[s].run, rawtime);
+    }
+  }
+  pthread_barrier_destroy(&barrier);
+  free(alone);
+  free(threads);
+  free(teams);
+  free(steps);
+  return total;
+}
+
+/*
+ * Parses a sweep: <phase>[:<min size>[:<max size>[:<ms per size>]]], where
+ * empty fields take the defaults. Only the phases with a size can be swept
+ * (see phase_has_size). Returns 0, or -1 if the sweep is invalid.
+ */
+int parse_sweep_spec(const char *str, sweep_spec *sweep) {
+  const char *field = str;
+  char *end;
+  sweep->min_size = SWEEP_DEFAULT_MIN_SIZE;
+  sweep->max_size = 0;
+  sweep->point_ms = SWEEP_DEFAULT_POINT_MS;
+  sweep->phase = strtol(field, &end, 10);
+  if (end == field || (*end && *end != ':') || sweep->phase < 1 ||
+      sweep->phase > NUM_PHASES || !phase_has_size(sweep->phase)) {
+    return -1;
+  }
+  for (int f = 0; f < 3 && *end; ++f) {
+    field = end + 1;
+    if (*field == ':' || !*field) {
+      end = (char *) field;
+      continue;
+    }
+    if (f < 2) {
+      const long size = strtol(field, &end, 0);
+      if (size < 1) {
+        return -1;
+      }
+      *(f ? &sweep->max_size : &sweep->min_size) = size;
+    } else if ((sweep->point_ms = strtod(field, &end)) <= 0) {
+      return -1;
+    }
+    if (*end && *end != ':') {
+      return -1;
+    }
+  }
+  if (*end || (sweep->max_size && sweep->min_size > sweep->max_size)) {
+    return -1;
+  }
+  return 0;
+}
+
+/* Bytes of data touched by one iteration of a run (its working set) */
+static double sweep_working_set(const phase_run *run) {
+  switch (run->phase) {
+    case 1:
+      return (double) run->size * (sizeof(double) + sizeof(int));
+    case 2:
+      return (double) run->size * (3 * sizeof(double) + sizeof(int));
+    case 3:
+      return (double) run->size * sizeof(double);
+    case 4:
+      return (double) run->size * 3 * sizeof(double);
+    case 5:
+      return (double) run->size * (3 * sizeof(double) + 2 * sizeof(int));
+    case 8:
+      return (double) run->size * 5 * sizeof(double);
+    default:
+      return (double) run->size * sizeof(uint64_t);
+  }
+}
+
+/* Sizes of a sweep: its geometric series, without repeated sizes */
+static int sweep_sizes(const sweep_spec *sweep, const long max_size,
+    long **sizes) {
+  const double factor = pow(2.0, 1.0 / SWEEP_POINTS_PER_OCTAVE);
+  const long min_size = (sweep->min_size < max_size) ? sweep->min_size :
+                        max_size;
+  int num_sizes = 0;
+  *sizes = malloc(sizeof(long) *
+      (SWEEP_POINTS_PER_OCTAVE * (log2((double) max_size / min_size) + 1) +
+       2));
+  for (int k = 0; ; ++k) {
+    long size = (long) (min_size * pow(factor, k) + 0.5);
+    if (size >= max_size) {
+      size = max_size;
+    } else if (sweep->phase == 10) {
+      size = gups_table_size(size);
+    }
+    if (!num_sizes || size > (*sizes)[num_sizes - 1]) {
+      (*sizes)[num_sizes++] = size;
+    }
+    if (size >= max_size) {
+      return num_sizes;
+    }
+  }
+}
+
+/* Prints a number of bytes in KiB, MiB or GiB */
+static void print_bytes(const double bytes) {
+  if (bytes >= (1 << 30)) {
+    printf("%.1f GiB", bytes / (1 << 30));
+  } else if (bytes >= (1 << 20)) {
+    printf("%.1f MiB", bytes / (1 << 20));
+  } else {
+    printf("%.1f KiB", bytes / 1024);
+  }
+}
+
+/*
+ * Cache level whose size (over the CPUs of the threads) is nearest to the
+ * working sets around a knee, within a factor of 4, or 0.
+ */
+static int knee_cache_level(const long *cache_sizes, const int num_levels,
+    const double working_set1, const double working_set2) {
+  const double middle = sqrt(working_set1 * working_set2);
+  double best = log(4.0);
+  int level = 0;
+  for (int l = 0; l < num_levels; ++l) {
+    const double distance = cache_sizes[l] ?
+                            fabs(log(cache_sizes[l] / middle)) : best;
+    if (distance < best) {
+      best = distance;
+      level = l + 1;
+    }
+  }
+  return level;
+}
+
+/*
+ * Runs a sweep of its phase over the working-set sizes, each size as one
+ * run_phase (with the values sweep_point, sweep_size and working_set_bytes
+ * in its results record), then prints the bandwidth and the time per
+ * element of each size. A knee is a drop of the bandwidth by more than
+ * SWEEP_KNEE_DROP from the best bandwidth since the previous knee, up to
+ * the size where it stops falling; knees are matched with the caches of the
+ * CPUs of the threads. Returns the time
+ * spent in the phase runs.
+ */
+#define SWEEP_KNEE_DROP 0.2
+#define SWEEP_MAX_CACHE_LEVELS 4
+
+unsigned long long run_sweep(phase_data *data, const phase_step *step,
+    const sweep_spec *sweep) {
+  const double target_ns = sweep->point_ms * 1e6;
+  long cache_sizes[SWEEP_MAX_CACHE_LEVELS], *sizes;
+  unsigned long long total = 0;
+  particle_set particles;
+  phase_run run;
+  init_run(data, step, &run, &particles);
+  const long max_size = (sweep->max_size && sweep->max_size < run.size) ?
+                        sweep->max_size : run.size;
+  const int num_sizes = sweep_sizes(sweep, max_size, &sizes);
+  double *working_set = malloc(sizeof(double) * num_sizes);
+  double *bandwidth = malloc(sizeof(double) * num_sizes);
+  double *element_ns = malloc(sizeof(double) * num_sizes);
+  int *iterations = malloc(sizeof(int) * num_sizes);
+
+  printf("Sweeping phase %d over %d sizes from %ld to %ld, %g ms per "
+         "size...\n", step->phase, num_sizes, sizes[0], max_size,
+         sweep->point_ms);
+  for (int i = 0; i < num_sizes; ++i) {
+    phase_step point = *step;
+    point.size = sizes[i];
+    point.num_iterations = calibrate_iterations(data, &point, target_ns);
+    init_run(data, &point, &run, &particles);
+    const phase_work work = run_work(data, &run);
+    working_set[i] = sweep_working_set(&run);
+    iterations[i] = point.num_iterations;
+    results_phase_value("sweep_point", i);
+    results_phase_value("sweep_size", sizes[i]);
+    results_phase_value("working_set_bytes", working_set[i]);
+    const unsigned long long ns = run_phase(data, &point);
+    bandwidth[i] = ns ? work.bytes / ns : 0;
+    element_ns[i] = (work.iterations && sizes[i]) ?
+                    (double) ns / work.iterations / sizes[i] : 0;
+    total += ns;
+  }
+
+  for (int l = 0; l < SWEEP_MAX_CACHE_LEVELS; ++l) {
+    cache_sizes[l] = topology_cache_size(run.cpu_id, run.num_threads, l + 1);
+  }
+  printf("-------- Sweep of phase %d --------\n", step->phase);
+  printf("Phase %d caches over %d threads:", step->phase, run.num_threads);
+  for (int l = 0, first = 1; l < SWEEP_MAX_CACHE_LEVELS; ++l) {
+    if (cache_sizes[l]) {
+      printf("%s L%d ", first ? "" : ",", l + 1);
+      print_bytes(cache_sizes[l]);
+      first = 0;
+    }
+  }
+  printf("\n");
+  for (int i = 0; i < num_sizes; ++i) {
+    printf("Phase %d size %ld, working set ", step->phase, sizes[i]);
+    print_bytes(working_set[i]);
+    printf(": %.3f GB/s, %.3f ns per element (%d iterations)\n",
+           bandwidth[i], element_ns[i], iterations[i]);
+  }
+  for (int i = 1, best = 0; i < num_sizes; ++i) {
+    if (bandwidth[i] >= bandwidth[best]) {
+      best = i;
+    } else if (bandwidth[i] < (1 - SWEEP_KNEE_DROP) * bandwidth[best]) {
+      /* The knee goes on while the bandwidth keeps falling */
+      int last = i;
+      while (last + 1 < num_sizes && bandwidth[last + 1] <
+             (1 - SWEEP_KNEE_DROP / 2) * bandwidth[last]) {
+        ++last;
+      }
+      const int level = knee_cache_level(cache_sizes, SWEEP_MAX_CACHE_LEVELS,
+                                         working_set[i - 1],
+                                         working_set[last]);
+      printf("Phase %d knee between ", step->phase);
+      print_bytes(working_set[i - 1]);
+      printf(" and ");
+      print_bytes(working_set[last]);
+      printf(": %.3f to %.3f GB/s", bandwidth[best], bandwidth[last]);
+      if (level) {
+        printf(" (L%d ", level);
+        print_bytes(cache_sizes[level - 1]);
+        printf(")");
+      }
+      printf("\n");
+      best = i = last;
+    }
+  }
+
+  free(iterations);
+  free(element_ns);
+  free(bandwidth);
+  free(working_set);
+  free(sizes);
+  return total;
+}
+
+/* Parses a number of bytes, with an optional K, M or G suffix, or -1 */
+static long parse_bytes(const char *str, char **end) {
+  long bytes = strtol(str, end, 0);
+  if (*end == str || bytes < 1) {
+    return -1;
+  }
+  switch (**end) {
+    case 'G':
+      bytes <<= 10;
+      /* fall through */
+    case 'M':
+      bytes <<= 10;
+      /* fall through */
+    case 'K':
+      bytes <<= 10;
+      ++*end;
+  }
+  return bytes;
+}
+
+/*
+ * Parses a latency ladder: <min bytes>:<max bytes>[:<stride>[:<chains>]],
+ * with sizes in bytes (or K, M, G). The stride is a multiple of the node
+ * size, the chains a power of two up to LATENCY_MAX_CHAINS, and the
+ * smallest size holds a node per chain. Returns 0, or -1 if the ladder is
+ * invalid.
+ */
+int parse_latency_spec(const char *str, latency_spec *latency) {
+  char *end;
+  latency->stride = LATENCY_DEFAULT_STRIDE;
+  latency->max_chains = LATENCY_MAX_CHAINS;
+  if ((latency->min_bytes = parse_bytes(str, &end)) < 0 || *end != ':' ||
+      (latency->max_bytes = parse_bytes(end + 1, &end)) < 0) {
+    return -1;
+  }
+  if (*end == ':' && (latency->stride = parse_bytes(end + 1, &end)) < 0) {
+    return -1;
+  }
+  if (*end == ':') {
+    const char *chains = end + 1;
+    latency->max_chains = strtol(chains, &end, 10);
+    if (end == chains) {
+      return -1;
+    }
+  }
+  if (*end || latency->stride % sizeof(linked_list) ||
+      latency->max_chains < 1 || latency->max_chains > LATENCY_MAX_CHAINS ||
+      (latency->max_chains & (latency->max_chains - 1)) ||
+      latency->min_bytes < latency->stride * latency->max_chains ||
+      latency->min_bytes > latency->max_bytes) {
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * Follows the chains of a latency ladder size once, with the team of the
+ * run, and returns the duration.
+ */
+static unsigned long long chase_run(const phase_data *data,
+    const phase_run *run, linked_list **starts, const long num_steps,
+    const int num_chains) {
+  struct timespec t1, t2;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+  phase7_chase(num_steps, num_chains, starts, run->num_threads
+#if ENABLE_BINDING
+      , data->num_cpus, run->cpu_id, data->bind_to_cpu_set
+#endif
+      );
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t2);
+  return duration(t1, t2);
+}
+
+/*
+ * Runs a latency ladder with the threads and CPU set of phase 7, on the
+ * lists allocated for the largest size. The steps of each size are
+ * calibrated with one chain, so the time per access is the load-to-use
+ * latency; with more chains it falls as the core overlaps the misses, and
+ * the ratio to one chain is the memory-level parallelism (MLP) achieved.
+ * Each size and number of chains has a results record, with the values
+ * latency_bytes, chains and ns_per_access. Returns the time spent in the
+ * chains.
+ */
+unsigned long long run_latency(phase_data *data, const phase_step *step,
+    const latency_spec *latency) {
+  const double factor = pow(2.0, 1.0 / SWEEP_POINTS_PER_OCTAVE);
+  const double target_ns = LATENCY_POINT_MS * 1e6;
+  unsigned long long total = 0;
+  particle_set particles;
+  phase_run run;
+  init_run(data, step, &run, &particles);
+  linked_list **starts = malloc(sizeof(linked_list*) * LATENCY_MAX_CHAINS *
+                                run.num_threads);
+
+  printf("Latency ladder of phase 7 from %ld to %ld bytes, stride %ld, up "
+         "to %d chains per thread...\n", latency->min_bytes,
+         latency->max_bytes, latency->stride, latency->max_chains);
+  /* The records have no iteration times */
+  timing_start(1);
+  timing_stop();
+  for (long k = 0, size = 0, last = 0; !last; ++k) {
+    const long previous = size;
+    size = (long) (latency->min_bytes * pow(factor, k));
+    size -= size % latency->stride;
+    if (size >= latency->max_bytes) {
+      size = latency->max_bytes - latency->max_bytes % latency->stride;
+      last = 1;
+    }
+    if (size == previous) {
+      continue;
+    }
+    init_chains(size, latency->stride, run.num_threads, data->llist, starts,
+        run.num_threads
+#if ENABLE_BINDING
+        , data->num_cpus, run.cpu_id, data->bind_to_cpu_set
+#endif
+        );
+#if ENABLE_BINDING
+    bind_team(data, &run, 0);
+#endif
+
+    /* Steps of about target_ns with one chain */
+    long num_steps = 1024;
+    unsigned long long ns;
+    while ((ns = chase_run(data, &run, starts, num_steps, 1)) <
+           CALIBRATION_MIN_NS) {
+      num_steps *= 2;
+    }
+    num_steps = (long) ((double) num_steps * target_ns / ns) + 1;
+
+    double single_ns = 0;
+    printf("Phase 7 latency ");
+    print_bytes(size);
+    printf(":");
+    for (int chains = 1; chains <= latency->max_chains; chains *= 2) {
+      phase_work work = { num_steps, 0, 0 };
+      ns = chase_run(data, &run, starts, num_steps, chains);
+      const double access_ns = (double) ns / num_steps / chains;
+      work.bytes = (double) num_steps * chains * run.num_threads *
+                   sizeof(linked_list);
+      if (chains == 1) {
+        single_ns = access_ns;
+        printf(" 1 chain %.2f ns", access_ns);
+      } else {
+        printf(", %d chains %.2f ns (MLP %.2f)", chains, access_ns,
+               access_ns ? single_ns / access_ns : 0);
+      }
+      results_start_phase(run.num_threads);
+      results_phase_value("latency_bytes", size);
+      results_phase_value("chains", chains);
+      results_phase_value("ns_per_access", access_ns);
+      results_phase(7, ns, work, run.num_threads, run.cpu_id);
+      total += ns;
+    }
+    printf("\n");
+  }
+  free(starts);
+  return total;
+}
@@ -0,0 +1,149 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef PHASES_H_
+#define PHASES_H_
+
+#include "meabo.h"
+#include "compute_kernels.h"
+
+#define NUM_PHASES 10
+
+/* Phase number of the idle steps of a run script */
+#define PHASE_IDLE 0
+
+/*
+ * Data of all the phases, allocated and initialised once by main. The arrays
+ * are sized for the largest step that uses them.
+ */
+typedef struct phase_data {
+  int num_cpus;
+  int bind_to_cpu_set;
+  int block_size;
+  long array_size;
+  double *vals, *src1, *src2, *dest;
+  int *int_vals, *ind_src1, *ind_src2;
+  double reduction_var;
+  sparse_matrix *matrix;
+  double *vect_in, *vect_out;
+  long llist_size;
+  linked_list **llist;
+  particle_set *particles;
+  double *forces;
+  phase8_spec phase8_spec;
+  int num_palindromes;
+  unsigned long *palindromes;
+  phase9_mode phase9_mode;
+  long num_randomloc;
+  uint64_t *randomloc;
+  gups_spec gups_spec;
+#if FULL_VALIDATION
+  double *valid_vals, *valid_src1, *valid_src2, *valid_dest, *valid_vect_in,
+         *valid_vect_out, *valid_forces;
+  int *valid_int_vals, *valid_ind_src1, *valid_ind_src2;
+  unsigned long *valid_palindromes;
+#endif
+#if RED_VALIDATION
+  double *valid_red_vals;
+  int *valid_red_int_vals;
+  unsigned long *valid_red_ulong_vals;
+  double valid_red_reduction_var;
+#endif
+} phase_data;
+
+/*
+ * One step of a run: a phase (or PHASE_IDLE) run repeat times with its own
+ * number of iterations, threads (0: see get_num_threads), CPU set (NULL: all
+ * the CPUs) and size (0: the size given on the command line). With a target
+ * duration in seconds, the iterations are calibrated to it before the step
+ * runs. The step first runs warmup untimed runs; with a stable_ci (in % of
+ * the mean), its repetitions stop once the 95% confidence interval of their
+ * mean duration is within it.
+ * Consecutive steps with the same corun group (0: none) run at the same
+ * time, on disjoint CPU sets.
+ */
+typedef struct phase_step {
+  int phase;
+  int num_iterations;
+  int num_threads;
+  cpu_set_t *cpu_id;
+  int repeat;
+  long size;
+  double idle_seconds;
+  int corun;
+  double target_seconds;
+  int warmup;
+  double stable_ci;
+} phase_step;
+
+int parse_run_script(const char *path, const phase_step *defaults,
+    phase_step **steps);
+
+unsigned long long run_step(phase_data *data, const phase_step *step,
+    const int step_index);
+
+unsigned long long run_corun(phase_data *data, const phase_step *steps,
+    const int num_steps, const int step_index);
+
+/*
+ * Working-set sweep (-w): one phase run over a geometric series of sizes,
+ * SWEEP_POINTS_PER_OCTAVE per doubling, from min_size to max_size (0: the
+ * size of its data), on the data allocated for the largest size. The
+ * iterations of each size are calibrated to run for about point_ms.
+ */
+#define SWEEP_POINTS_PER_OCTAVE 2
+#define SWEEP_DEFAULT_MIN_SIZE 1024
+#define SWEEP_DEFAULT_POINT_MS 100
+
+typedef struct sweep_spec {
+  int phase;
+  long min_size;
+  long max_size;
+  double point_ms;
+} sweep_spec;
+
+int parse_sweep_spec(const char *str, sweep_spec *sweep);
+
+unsigned long long run_sweep(phase_data *data, const phase_step *step,
+    const sweep_spec *sweep);
+
+/*
+ * Latency ladder (-j): random cyclic pointer chains in the phase 7 list of
+ * each thread, over a geometric series of sizes, SWEEP_POINTS_PER_OCTAVE per
+ * doubling, from min_bytes to max_bytes, with one node every stride bytes.
+ * Each size is followed with 1, 2, 4, ... up to max_chains independent
+ * chains per thread, for about LATENCY_POINT_MS each.
+ */
+#define LATENCY_DEFAULT_STRIDE 64
+#define LATENCY_POINT_MS 20
+
+typedef struct latency_spec {
+  long min_bytes;
+  long max_bytes;
+  long stride;
+  int max_chains;
+} latency_spec;
+
+int parse_latency_spec(const char *str, latency_spec *latency);
+
+unsigned long long run_latency(phase_data *data, const phase_step *step,
+    const latency_spec *latency);
+
+#endif /* PHASES_H_ */
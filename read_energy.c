@@ -18,32 +18,405 @@
  *
  */
 
- #include "read_energy.h"
+#include "meabo.h"
+#include "read_energy.h"
+#include "results.h"
+#include "util.h"
 
- /* This file is still a stub. Energy reading features will be included 
- * in a later version.
+#include <fcntl.h>
+#include <glob.h>
+
+static energy_state state;
+static double start_joules[ENERGY_MAX_CHANNELS];
+static double stop_joules[ENERGY_MAX_CHANNELS];
+static double start_time, stop_time;
+
+static pthread_t sampler;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int sampling = 0;
+static long period_ns;
+
+static double now_s(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* Reads the first number of a sysfs file. */
+static int read_sysfs(const char *path, double *value) {
+  FILE *file = fopen(path, "r");
+  int ok;
+  if (file == NULL) {
+    return -1;
+  }
+  ok = (fscanf(file, "%lf", value) == 1);
+  fclose(file);
+  return ok ? 0 : -1;
+}
+
+/* Reads the first line of a sysfs file, without its newline. */
+static void read_sysfs_str(const char *path, char *str, size_t size) {
+  FILE *file = fopen(path, "r");
+  str[0] = 0;
+  if (file == NULL) {
+    return;
+  }
+  if (fgets(str, size, file) != NULL) {
+    str[strcspn(str, "\n")] = 0;
+  }
+  fclose(file);
+}
+
+static int add_channel(energy_state *s, const char *name, const char *path,
+                       const int is_power, const double max_range) {
+  if (s->num_channels == ENERGY_MAX_CHANNELS) {
+    return -1;
+  }
+  energy_channel *channel = &s->channels[s->num_channels++];
+  memset(channel, 0, sizeof(energy_channel));
+  snprintf(channel->name, sizeof(channel->name), "%.191s", name);
+  snprintf(channel->path, sizeof(channel->path), "%.255s", path);
+  channel->is_power = is_power;
+  channel->max_range = max_range;
+  return 0;
+}
+
+static int sysfs_read(energy_state *s, int channel, double *value) {
+  return read_sysfs(s->channels[channel].path, value);
+}
+
+/*
+ * RAPL through powercap: every zone and subzone with an energy_uj file that
+ * can be read (only root can, on kernels with the PLATYPUS mitigation).
+ * Subzones are named after their parent (e.g. package-0/core).
  */
+static int rapl_probe(energy_state *s, const char *arg) {
+  glob_t files;
+  if (glob("/sys/class/powercap/*/energy_uj", 0, NULL, &files)) {
+    return 0;
+  }
+  for (size_t f = 0; f < files.gl_pathc; ++f) {
+    char dir[256], path[512], name[64], parent_name[64] = "", full[192];
+    double max_range = 0, value;
+    if (read_sysfs(files.gl_pathv[f], &value)) {
+      continue;
+    }
+    snprintf(dir, sizeof(dir), "%s", files.gl_pathv[f]);
+    *strrchr(dir, '/') = 0;
+    snprintf(path, sizeof(path), "%s/name", dir);
+    read_sysfs_str(path, name, sizeof(name));
+    snprintf(path, sizeof(path), "%s/max_energy_range_uj", dir);
+    read_sysfs(path, &max_range);
+    /* intel-rapl:0:1 is a subzone of intel-rapl:0 */
+    char *zone = strrchr(dir, '/') + 1;
+    char *last_colon = strrchr(zone, ':');
+    if (last_colon && strchr(zone, ':') != last_colon) {
+      snprintf(path, sizeof(path), "%.*s/name",
+               (int) (last_colon - dir), dir);
+      read_sysfs_str(path, parent_name, sizeof(parent_name));
+    }
+    if (parent_name[0]) {
+      snprintf(full, sizeof(full), "%s/%s", parent_name, name);
+    } else {
+      snprintf(full, sizeof(full), "%s", name[0] ? name : zone);
+    }
+    add_channel(s, full, files.gl_pathv[f], 0, max_range);
+  }
+  globfree(&files);
+  return s->num_channels;
+}
 
 /*
- *
- *
+ * hwmon: energy counters in uJ and power in uW that can be read, named after
+ * the device and the label of the sensor.
  */
- void init_read_energy() {
- 	return;
- }
+static int hwmon_probe(energy_state *s, const char *arg) {
+  static const char *patterns[] = {
+    "/sys/class/hwmon/hwmon*/energy*_input",
+    "/sys/class/hwmon/hwmon*/power*_input"
+  };
+  for (int p = 0; p < 2; ++p) {
+    glob_t files;
+    if (glob(patterns[p], 0, NULL, &files)) {
+      continue;
+    }
+    for (size_t f = 0; f < files.gl_pathc; ++f) {
+      char path[512], device[64], label[64], full[192];
+      const char *file = files.gl_pathv[f];
+      const char *base = strrchr(file, '/') + 1;
+      double value;
+      if (read_sysfs(file, &value)) {
+        continue;
+      }
+      snprintf(path, sizeof(path), "%.*s/name", (int) (base - file - 1),
+               file);
+      read_sysfs_str(path, device, sizeof(device));
+      snprintf(path, sizeof(path), "%.*s_label",
+               (int) (strlen(file) - strlen("_input")), file);
+      read_sysfs_str(path, label, sizeof(label));
+      if (!label[0]) {
+        snprintf(label, sizeof(label), "%.*s",
+                 (int) (strlen(base) - strlen("_input")), base);
+      }
+      snprintf(full, sizeof(full), "%s/%s", device, label);
+      add_channel(s, full, file, p == 1, 0);
+    }
+    globfree(&files);
+  }
+  return s->num_channels;
+}
+
+/* Replay of a power trace, read from arg. */
+static int replay_probe(energy_state *s, const char *arg) {
+  FILE *file = fopen(arg, "r");
+  char line[1024];
+  int capacity = 0, num_channels = 0;
+  if (file == NULL) {
+    printf("Unable to open energy trace %s: %s\n", arg, strerror(errno));
+    return 0;
+  }
+  while (fgets(line, sizeof(line), file) != NULL) {
+    char *token, *save;
+    double values[ENERGY_MAX_CHANNELS + 1];
+    int n = 0;
+    if (line[0] == '#') {
+      if (!s->trace_len && !num_channels) {
+        for (token = strtok_r(line + 1, " \t\n", &save); token &&
+             num_channels < ENERGY_MAX_CHANNELS;
+             token = strtok_r(NULL, " \t\n", &save)) {
+          add_channel(s, token, arg, 0, 0);
+          ++num_channels;
+        }
+      }
+      continue;
+    }
+    for (token = strtok_r(line, " \t\n", &save);
+         token && n <= ENERGY_MAX_CHANNELS;
+         token = strtok_r(NULL, " \t\n", &save)) {
+      values[n++] = atof(token);
+    }
+    if (n < 2) {
+      continue;
+    }
+    if (!num_channels) {
+      for (int c = 0; c < n - 1; ++c) {
+        char name[64];
+        snprintf(name, sizeof(name), "channel%d", c);
+        add_channel(s, name, arg, 0, 0);
+      }
+      num_channels = n - 1;
+    }
+    if (s->trace_len == capacity) {
+      capacity = capacity ? 2 * capacity : 64;
+      s->trace_time = realloc(s->trace_time, sizeof(double) * capacity);
+      s->trace_watts = realloc(s->trace_watts,
+                               sizeof(double) * capacity * num_channels);
+    }
+    s->trace_time[s->trace_len] = values[0];
+    for (int c = 0; c < num_channels; ++c) {
+      s->trace_watts[s->trace_len * num_channels + c] =
+          (c + 1 < n) ? values[c + 1] : 0;
+    }
+    ++s->trace_len;
+  }
+  fclose(file);
+  if (!s->trace_len) {
+    s->num_channels = 0;
+  }
+  return s->num_channels;
+}
 
 /*
- *
- *
+ * Energy of a replay channel, in uJ, since the start of the run: the power
+ * of each line holds until the time of the next one, and the last one
+ * holds forever.
  */
- void read_energy(char* label) {
- 	return;
- }
+static int replay_read(energy_state *s, int channel, double *value) {
+  const double t = now_s() - s->start_time;
+  double joules = 0;
+  for (int i = 0; i < s->trace_len && s->trace_time[i] < t; ++i) {
+    const double end = (i + 1 < s->trace_len && s->trace_time[i + 1] < t) ?
+                       s->trace_time[i + 1] : t;
+    joules += s->trace_watts[i * s->num_channels + channel] *
+              (end - s->trace_time[i]);
+  }
+  *value = joules * 1e6;
+  return 0;
+}
+
+static const energy_source sources[] = {
+  { "rapl", rapl_probe, sysfs_read },
+  { "hwmon", hwmon_probe, sysfs_read },
+  { "replay", replay_probe, replay_read },
+};
 
 /*
- *
- *
+ * Takes a reading of every channel. Energy counters that went backwards
+ * wrapped around; power channels are integrated with the trapezoidal rule.
+ * Only the periodic samples update the peak power, as readings closer in
+ * time are dominated by the update interval of the counters.
+ */
+static void energy_update(const int sample) {
+  const double now = now_s();
+  const double dt = now - state.last_time;
+  for (int c = 0; c < state.num_channels; ++c) {
+    energy_channel *channel = &state.channels[c];
+    double raw, watts;
+    if (state.source->read(&state, c, &raw)) {
+      continue;
+    }
+    if (channel->is_power) {
+      watts = raw / 1e6;
+      channel->joules += (watts + channel->last_watts) / 2 * dt;
+    } else {
+      double delta = raw - channel->last_raw;
+      if (delta < 0) {
+        delta = (channel->max_range > 0) ? delta + channel->max_range : 0;
+      }
+      channel->joules += delta / 1e6;
+      watts = (dt > 0) ? delta / 1e6 / dt : 0;
+    }
+    channel->last_raw = raw;
+    channel->last_watts = watts;
+    if (sample && watts > channel->peak_watts) {
+      channel->peak_watts = watts;
+    }
+  }
+  state.last_time = now;
+}
+
+static void* sampler_loop(void *arg) {
+  struct timespec period = { period_ns / NANOS, period_ns % NANOS };
+  while (sampling) {
+    nanosleep(&period, NULL);
+    pthread_mutex_lock(&lock);
+    energy_update(1);
+    pthread_mutex_unlock(&lock);
+  }
+  return NULL;
+}
+
+/*
+ * Starts energy readings from spec: none, auto (rapl, else hwmon), rapl,
+ * hwmon or replay:<file>, followed by @<samples per second>. Returns 0 if
+ * readings are off (including auto without any channel) or started, -1 on
+ * error.
  */
- void exit_read_energy() {
- 	return;
- }
\ No newline at end of file
+int init_read_energy(const char *spec) {
+  char name[256];
+  const char *arg = NULL, *rate = strrchr(spec, '@');
+  double samples_per_s = ENERGY_DEFAULT_RATE;
+  snprintf(name, sizeof(name), "%.*s",
+           rate ? (int) (rate - spec) : (int) strlen(spec), spec);
+  if (rate && ((samples_per_s = atof(rate + 1)) <= 0)) {
+    printf("Invalid energy sampling rate %s\n", rate + 1);
+    return -1;
+  }
+  if (!strcmp(name, "none")) {
+    return 0;
+  }
+  if (!strncmp(name, "replay:", 7)) {
+    arg = name + 7;
+    name[6] = 0;
+  }
+
+  memset(&state, 0, sizeof(state));
+  state.start_time = now_s();
+  for (int s = 0; s < sizeof(sources) / sizeof(sources[0]); ++s) {
+    const int is_auto = !strcmp(name, "auto") && s < 2;
+    if ((is_auto || !strcmp(name, sources[s].name)) &&
+        sources[s].probe(&state, arg) > 0) {
+      state.source = &sources[s];
+      break;
+    }
+  }
+  if (state.source == NULL) {
+    printf("No energy channels found for %s\n", spec);
+    return strcmp(name, "auto") ? -1 : 0;
+  }
+
+  printf("Energy source %s, %d channels sampled %g times per second:",
+         state.source->name, state.num_channels, samples_per_s);
+  for (int c = 0; c < state.num_channels; ++c) {
+    double raw = 0;
+    state.source->read(&state, c, &raw);
+    state.channels[c].last_raw = raw;
+    printf(" %s", state.channels[c].name);
+  }
+  printf("\n");
+  state.last_time = now_s();
+
+  period_ns = NANOS / samples_per_s;
+  sampling = 1;
+  if (pthread_create(&sampler, NULL, sampler_loop, NULL)) {
+    printf("Unable to start the energy sampling thread\n");
+    sampling = 0;
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * Reading at the start (label ending with _START) or at the end of a phase.
+ */
+void read_energy(char* label) {
+  if (!sampling) {
+    return;
+  }
+  const int start = (strstr(label, "_START") != NULL);
+  pthread_mutex_lock(&lock);
+  energy_update(0);
+  for (int c = 0; c < state.num_channels; ++c) {
+    if (start) {
+      start_joules[c] = state.channels[c].joules;
+      state.channels[c].peak_watts = 0;
+    } else {
+      stop_joules[c] = state.channels[c].joules;
+    }
+  }
+  if (start) {
+    start_time = state.last_time;
+  } else {
+    stop_time = state.last_time;
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+/*
+ * Prints the energy of each channel between the last two readings, with the
+ * average and peak power, and the energy per flop (or per byte for phases
+ * without flops). Phases shorter than the sampling period have no sample of
+ * their own, and their peak is their average.
+ */
+void energy_report(const int phase, const double bytes, const double flops) {
+  if (!sampling) {
+    return;
+  }
+  const double seconds = stop_time - start_time;
+  for (int c = 0; c < state.num_channels; ++c) {
+    const double joules = stop_joules[c] - start_joules[c];
+    const double ops = flops ? flops : bytes;
+    const double watts = (seconds > 0) ? joules / seconds : 0;
+    const double peak = (state.channels[c].peak_watts > watts) ?
+                        state.channels[c].peak_watts : watts;
+    char key[sizeof("energy_j_") + sizeof(state.channels[c].name)];
+    printf("Phase %d energy %s: %.3f J, %.3f W average, %.3f W peak",
+           phase, state.channels[c].name, joules, watts, peak);
+    if (ops > 0) {
+      printf(", %.4f nJ/%s", joules / ops * 1e9, flops ? "FLOP" : "byte");
+    }
+    printf("\n");
+    snprintf(key, sizeof(key), "energy_j_%s", state.channels[c].name);
+    results_phase_value(key, joules);
+  }
+}
+
+void exit_read_energy() {
+  if (sampling) {
+    sampling = 0;
+    pthread_join(sampler, NULL);
+  }
+  free(state.trace_time);
+  free(state.trace_watts);
+  state.trace_time = state.trace_watts = NULL;
+}
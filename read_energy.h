@@ -18,16 +18,61 @@
  *
  */
 
-
 #ifndef READ_ENERGY_H_
 #define READ_ENERGY_H_
 
-/* This file is still a stub. Energy reading features will be included 
- * in a later version.
+/*
+ * Energy readings. A source exposes one or more channels, each either a
+ * cumulative energy counter (in uJ) or an instantaneous power (in uW):
+ * - rapl: Linux powercap zones (/sys/class/powercap/intel-rapl:*), energy;
+ * - hwmon: hwmon energy*_input (e.g. ARM Juno energy meters, energy) and
+ *   power*_input files (power);
+ * - replay:<file>: power trace for testing, one line per time step with the
+ *   time in seconds and the power of each channel in watts (a first line
+ *   starting with # names the channels).
+ * A background thread samples the channels, so that wrapping counters are
+ * accounted for and power channels are integrated; read_energy takes a
+ * reading at the start and at the end of each phase.
  */
+#define ENERGY_MAX_CHANNELS 16
+#define ENERGY_DEFAULT_RATE 100   /* samples per second */
+
+typedef struct energy_channel {
+  char name[192];
+  char path[256];
+  int is_power;
+  double max_range;    /* value at which an energy counter wraps, or 0 */
+  double last_raw;
+  double last_watts;
+  double joules;       /* energy since init_read_energy */
+  double peak_watts;   /* highest power since the last start reading */
+} energy_channel;
+
+typedef struct energy_state energy_state;
+
+typedef struct energy_source {
+  const char *name;
+  /* Finds the channels; returns their number, 0 if none */
+  int (*probe)(energy_state *state, const char *arg);
+  /* Raw value of a channel: energy in uJ or power in uW */
+  int (*read)(energy_state *state, int channel, double *value);
+} energy_source;
+
+struct energy_state {
+  const energy_source *source;
+  int num_channels;
+  energy_channel channels[ENERGY_MAX_CHANNELS];
+  double start_time;
+  double last_time;
+  /* Replay trace */
+  int trace_len;
+  double *trace_time;
+  double *trace_watts;
+};
 
-void init_read_energy();
+int init_read_energy(const char *spec);
 void read_energy(char* label);
+void energy_report(const int phase, const double bytes, const double flops);
 void exit_read_energy();
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,377 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "results.h"
+#include "histogram.h"
+
+#include <stdarg.h>
+
+typedef struct results_field {
+  char key[64];
+  char value[1024];
+  int quoted;
+} results_field;
+
+typedef struct results_record {
+  const char *type;
+  int phase;
+  int thread;
+  int num_fields;
+  results_field fields[RESULTS_MAX_FIELDS];
+} results_record;
+
+static FILE *results_file = NULL;
+static results_format format = RESULTS_JSON;
+
+/* Run record, written before the first phase record */
+static results_record run_record;
+static int run_written = 0;
+
+/* Values added to the next phase record */
+static results_record phase_values;
+
+/* Counters of each thread for the current phase */
+static char **counter_names = NULL;
+static int num_counter_names = 0;
+static unsigned long long *thread_counters = NULL;
+static int *thread_num_counters = NULL;
+static int counter_threads = 0;
+
+static void record_init(results_record *record, const char *type,
+    const int phase, const int thread) {
+  record->type = type;
+  record->phase = phase;
+  record->thread = thread;
+  record->num_fields = 0;
+}
+
+/* Warns, once, that a record has no room left for key and the next values */
+static void record_full(const results_record *record, const char *key) {
+  static int warned = 0;
+  if (!warned) {
+    printf("Too many values in a %s record of the results, dropping %s and "
+           "the next ones\n", record->type, key);
+    warned = 1;
+  }
+}
+
+static void __attribute__((format(printf, 4, 5)))
+record_add(results_record *record, const char *key, const int quoted,
+    const char *fmt, ...) {
+  if (record->num_fields == RESULTS_MAX_FIELDS) {
+    record_full(record, key);
+    return;
+  }
+  results_field *field = &record->fields[record->num_fields++];
+  va_list args;
+  snprintf(field->key, sizeof(field->key), "%s", key);
+  va_start(args, fmt);
+  vsnprintf(field->value, sizeof(field->value), fmt, args);
+  va_end(args);
+  field->quoted = quoted;
+}
+
+static void write_json_string(const char *str) {
+  fputc('"', results_file);
+  for (; *str; ++str) {
+    if (*str == '"' || *str == '\\') {
+      fprintf(results_file, "\\%c", *str);
+    } else if ((unsigned char) *str < 0x20) {
+      fprintf(results_file, "\\u%04x", *str);
+    } else {
+      fputc(*str, results_file);
+    }
+  }
+  fputc('"', results_file);
+}
+
+static void write_csv_string(const char *str) {
+  fputc('"', results_file);
+  for (; *str; ++str) {
+    if (*str == '"') {
+      fputc('"', results_file);
+    }
+    fputc(*str, results_file);
+  }
+  fputc('"', results_file);
+}
+
+static void record_write(const results_record *record) {
+  if (format == RESULTS_CSV) {
+    for (int f = 0; f < record->num_fields; ++f) {
+      fprintf(results_file, "%s,", record->type);
+      if (record->phase >= 0) {
+        fprintf(results_file, "%d", record->phase);
+      }
+      fputc(',', results_file);
+      if (record->thread >= 0) {
+        fprintf(results_file, "%d", record->thread);
+      }
+      fprintf(results_file, ",%s,", record->fields[f].key);
+      if (record->fields[f].quoted) {
+        write_csv_string(record->fields[f].value);
+      } else {
+        fputs(record->fields[f].value, results_file);
+      }
+      fputc('\n', results_file);
+    }
+    return;
+  }
+  fprintf(results_file, "{\"record\":\"%s\"", record->type);
+  if (record->phase >= 0) {
+    fprintf(results_file, ",\"phase\":%d", record->phase);
+  }
+  if (record->thread >= 0) {
+    fprintf(results_file, ",\"thread\":%d", record->thread);
+  }
+  for (int f = 0; f < record->num_fields; ++f) {
+    fprintf(results_file, ",\"%s\":", record->fields[f].key);
+    if (record->fields[f].quoted) {
+      write_json_string(record->fields[f].value);
+    } else {
+      fputs(record->fields[f].value, results_file);
+    }
+  }
+  fputs("}\n", results_file);
+}
+
+static void write_run_record(void) {
+  if (!run_written) {
+    record_write(&run_record);
+    run_written = 1;
+  }
+}
+
+/*
+ * Opens the results file; the format is CSV if its name ends with .csv and
+ * JSON Lines otherwise.
+ */
+int results_open(const char *path) {
+  const size_t len = strlen(path);
+  format = (len >= 4 && !strcmp(path + len - 4, ".csv")) ? RESULTS_CSV :
+                                                           RESULTS_JSON;
+  if ((results_file = fopen(path, "w")) == NULL) {
+    printf("Unable to open results file %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  if (format == RESULTS_CSV) {
+    fprintf(results_file, "record,phase,thread,key,value\n");
+  }
+  record_init(&run_record, "run", -1, -1);
+  record_init(&phase_values, "phase", -1, -1);
+  return 0;
+}
+
+/* Writes the total execution time and closes the file. */
+void results_close(const unsigned long long total_ns) {
+  if (results_file) {
+    static results_record record;
+    write_run_record();
+    record_init(&record, "total", -1, -1);
+    record_add(&record, "duration_ns", 0, "%llu", total_ns);
+    record_write(&record);
+    fclose(results_file);
+    results_file = NULL;
+  }
+  free(thread_counters);
+  free(thread_num_counters);
+  thread_counters = NULL;
+  thread_num_counters = NULL;
+  counter_threads = 0;
+}
+
+void results_param_long(const char *key, const long value) {
+  if (results_file) {
+    record_add(&run_record, key, 0, "%ld", value);
+  }
+}
+
+void results_param_double(const char *key, const double value) {
+  if (results_file) {
+    record_add(&run_record, key, 0, "%.17g", value);
+  }
+}
+
+void results_param_str(const char *key, const char *value) {
+  if (results_file) {
+    record_add(&run_record, key, 1, "%s", value);
+  }
+}
+
+void results_counter_names(char **names, const int num_counters) {
+  counter_names = names;
+  num_counter_names = num_counters;
+}
+
+/*
+ * Clears the counter slots of num_threads threads.
+ */
+void results_start_phase(const int num_threads) {
+  if (!results_file) {
+    return;
+  }
+  if (num_threads > counter_threads) {
+    free(thread_counters);
+    free(thread_num_counters);
+    thread_counters = malloc(sizeof(unsigned long long) *
+                             RESULTS_MAX_COUNTERS * num_threads);
+    thread_num_counters = malloc(sizeof(int) * num_threads);
+    counter_threads = num_threads;
+  }
+  memset(thread_num_counters, 0, sizeof(int) * counter_threads);
+}
+
+/* Counter values of a thread of the phase. */
+void results_counters(const int thread, const int num_counters,
+    const unsigned long long *values) {
+  if (!results_file || thread >= counter_threads) {
+    return;
+  }
+  const int n = (num_counters < RESULTS_MAX_COUNTERS) ? num_counters :
+                                                        RESULTS_MAX_COUNTERS;
+  memcpy(thread_counters + (long) thread * RESULTS_MAX_COUNTERS, values,
+         sizeof(unsigned long long) * n);
+  thread_num_counters[thread] = n;
+}
+
+static void add_counters(results_record *record, const int thread) {
+  for (int c = 0; c < thread_num_counters[thread]; ++c) {
+    char key[64];
+    if (c < num_counter_names && counter_names[c]) {
+      snprintf(key, sizeof(key), "%s", counter_names[c]);
+    } else {
+      snprintf(key, sizeof(key), "counter%d", c);
+    }
+    record_add(record, key, 0, "%llu",
+               thread_counters[(long) thread * RESULTS_MAX_COUNTERS + c]);
+  }
+}
+
+/* Moves the values added with results_phase_value to record. */
+static void add_phase_values(results_record *record) {
+  for (int f = 0; f < phase_values.num_fields; ++f) {
+    if (record->num_fields == RESULTS_MAX_FIELDS) {
+      record_full(record, phase_values.fields[f].key);
+      break;
+    }
+    record->fields[record->num_fields++] = phase_values.fields[f];
+  }
+  phase_values.num_fields = 0;
+}
+
+/* Adds a value, e.g. an energy reading, to the next phase record. */
+void results_phase_value(const char *key, const double value) {
+  if (results_file) {
+    record_add(&phase_values, key, 0, "%.17g", value);
+  }
+}
+
+/*
+ * Writes the phase record and the records of its threads, from the duration,
+ * the work model, the iteration histograms and the counters of the phase.
+ */
+void results_phase(const int phase, const unsigned long long duration_ns,
+    const phase_work work, const int num_threads, const cpu_set_t *cpu_id) {
+  static results_record record;
+  timing_stats stats;
+  char cpus[1024];
+  const double seconds = duration_ns / 1e9;
+  if (!results_file) {
+    return;
+  }
+  write_run_record();
+
+  record_init(&record, "phase", phase, -1);
+  record_add(&record, "duration_ns", 0, "%llu", duration_ns);
+  record_add(&record, "iterations", 0, "%ld", work.iterations);
+  record_add(&record, "threads", 0, "%d", num_threads);
+  format_cpu_list(cpu_id, cpus, sizeof(cpus));
+  record_add(&record, "cpus", 1, "%s", cpus);
+  record_add(&record, "bytes", 0, "%.0f", work.bytes);
+  record_add(&record, "flops", 0, "%.0f", work.flops);
+  record_add(&record, "gbytes_per_s", 0, "%.6g",
+             seconds > 0 ? work.bytes / seconds / 1e9 : 0);
+  record_add(&record, "gflops_per_s", 0, "%.6g",
+             seconds > 0 ? work.flops / seconds / 1e9 : 0);
+  record_add(&record, "flops_per_byte", 0, "%.6g",
+             work.bytes > 0 ? work.flops / work.bytes : 0);
+  if (timing_summary(&stats)) {
+    record_add(&record, "samples", 0, "%llu",
+               (unsigned long long) stats.samples);
+    record_add(&record, "p50_ns", 0, "%llu", (unsigned long long) stats.p50);
+    record_add(&record, "p99_ns", 0, "%llu", (unsigned long long) stats.p99);
+    record_add(&record, "p999_ns", 0, "%llu",
+               (unsigned long long) stats.p999);
+    record_add(&record, "max_ns", 0, "%llu", (unsigned long long) stats.max);
+    record_add(&record, "imbalance", 0, "%.6g", stats.imbalance);
+  }
+  add_phase_values(&record);
+  record_write(&record);
+
+  for (int t = 0; t < num_threads; ++t) {
+    const int has_samples = (t < phase_timing.num_threads &&
+                             phase_timing.threads[t].count);
+    const int has_counters = (t < counter_threads && thread_num_counters[t]);
+    if (!has_samples && !has_counters) {
+      continue;
+    }
+    record_init(&record, "thread", phase, t);
+    if (has_samples) {
+      const latency_hist *hist = &phase_timing.threads[t];
+      record_add(&record, "cpu", 0, "%d", hist->cpu);
+      record_add(&record, "samples", 0, "%llu",
+                 (unsigned long long) hist->count);
+      record_add(&record, "busy_ns", 0, "%llu",
+                 (unsigned long long) hist->total_ns);
+      record_add(&record, "p50_ns", 0, "%llu",
+                 (unsigned long long) hist_percentile(hist, 0.5));
+      record_add(&record, "max_ns", 0, "%llu",
+                 (unsigned long long) hist->max_ns);
+    }
+    if (has_counters) {
+      add_counters(&record, t);
+    }
+    record_write(&record);
+  }
+  fflush(results_file);
+}
+
+/*
+ * Writes the statistics of the repeated runs of a step, with the values
+ * added since its last phase record (e.g. whether it became stable).
+ */
+void results_stats(const int phase, const run_stats *stats) {
+  static results_record record;
+  if (!results_file) {
+    return;
+  }
+  record_init(&record, "stats", phase, -1);
+  record_add(&record, "runs", 0, "%d", stats->runs);
+  record_add(&record, "mean_ns", 0, "%.17g", stats->mean);
+  record_add(&record, "median_ns", 0, "%.17g", stats->median);
+  record_add(&record, "stddev_ns", 0, "%.17g", stats->stddev);
+  record_add(&record, "min_ns", 0, "%.17g", stats->min);
+  record_add(&record, "max_ns", 0, "%.17g", stats->max);
+  record_add(&record, "ci95_ns", 0, "%.17g", stats->ci95);
+  record_add(&record, "outliers", 0, "%d", stats->outliers);
+  add_phase_values(&record);
+  record_write(&record);
+  fflush(results_file);
+}
@@ -0,0 +1,72 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef RESULTS_H_
+#define RESULTS_H_
+
+#include "meabo.h"
+#include "compute_kernels.h"
+#include "stats.h"
+
+/*
+ * Machine-readable results (-o file): a run record with the parameters and
+ * the build, then per phase a phase record and one record per thread, and a
+ * stats record after the repeated runs of a step.
+ * - .csv files: one row per value, with the columns
+ *   record,phase,thread,key,value;
+ * - other files: JSON Lines, one JSON object per record.
+ */
+typedef enum results_format {
+  RESULTS_JSON = 0,
+  RESULTS_CSV
+} results_format;
+
+/*
+ * A record has room for the counters of all the events (COUNTERS_MAX_EVENTS),
+ * each with the fraction of the time it was counted, besides its own fields.
+ */
+#define RESULTS_MAX_COUNTERS 64
+#define RESULTS_MAX_FIELDS (2 * RESULTS_MAX_COUNTERS + 64)
+
+int results_open(const char *path);
+
+void results_close(const unsigned long long total_ns);
+
+void results_param_long(const char *key, const long value);
+
+void results_param_double(const char *key, const double value);
+
+void results_param_str(const char *key, const char *value);
+
+void results_counter_names(char **names, const int num_counters);
+
+void results_start_phase(const int num_threads);
+
+void results_counters(const int thread, const int num_counters,
+    const unsigned long long *values);
+
+void results_phase_value(const char *key, const double value);
+
+void results_phase(const int phase, const unsigned long long duration_ns,
+    const phase_work work, const int num_threads, const cpu_set_t *cpu_id);
+
+void results_stats(const int phase, const run_stats *stats);
+
+#endif /* RESULTS_H_ */
@@ -0,0 +1,93 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef RNG_H_
+#define RNG_H_
+
+#include <stdint.h>
+
+#define RNG_SEED 0x4d6561626fULL
+
+/*
+ * Stream identifiers. Every array gets its own stream, so that two arrays
+ * filled with the same counters do not end up with the same contents.
+ */
+enum rng_stream {
+  RNG_VALS = 1,
+  RNG_SRC1,
+  RNG_SRC2,
+  RNG_DEST,
+  RNG_IND_SRC1,
+  RNG_IND_SRC2,
+  RNG_VECT_IN,
+  RNG_SPARSE,
+  RNG_PARTICLES,
+  RNG_LLIST,
+  RNG_SPARSE_VALUES,
+  RNG_GUPS,
+  RNG_CHAINS
+};
+
+/*
+ * Counter-based generator: the result only depends on (stream, counter), so
+ * any thread can produce element i of an array without sharing state with
+ * the other threads, and the data does not depend on the number of threads.
+ * The mixing function is the SplitMix64 finaliser.
+ */
+static inline uint64_t rng_hash(uint64_t stream, uint64_t counter) {
+  uint64_t z = RNG_SEED ^ (stream * 0xd1342543de82ef95ULL);
+  z += (counter + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/*
+ * Low and high 31-bit halves of a draw, as drop-in replacements for two
+ * consecutive rand() calls.
+ */
+static inline int rng_lo(uint64_t r) {
+  return (int) (r & 0x7fffffff);
+}
+
+static inline int rng_hi(uint64_t r) {
+  return (int) ((r >> 32) & 0x7fffffff);
+}
+
+/*
+ * Uniform double in [0, 1) from the top 53 bits of a draw.
+ */
+static inline double rng_unit(uint64_t r) {
+  return (r >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * xorshift64* step, for long sequential streams (state must not be 0).
+ */
+static inline uint64_t rng_xorshift(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545f4914f6cdd1dULL;
+}
+
+#endif /* RNG_H_ */
@@ -0,0 +1,168 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "roofline.h"
+#include "simd_kernels.h"
+
+#define ROOFLINE_MAX_PHASES 10
+
+/* Result of the peak kernel, kept so that it is not optimised away */
+static volatile double peak_sink;
+
+/* Rates of the phases run so far */
+static struct {
+  int run;
+  double gbytes_per_s;
+  double gflops_per_s;
+  double intensity;
+} phase_rates[ROOFLINE_MAX_PHASES + 1];
+
+/*
+ * Parses the -k argument: "measure", or the peak bandwidth and throughput
+ * as <GB/s>:<GFLOP/s>. Returns 0 on success.
+ */
+int parse_roofline_peak(const char *str, roofline_peak *peak) {
+  if (!strcmp(str, "measure")) {
+    peak->measured = 1;
+    return 0;
+  }
+  peak->measured = 0;
+  if (sscanf(str, "%lf:%lf", &peak->gbytes_per_s, &peak->gflops_per_s) != 2 ||
+      peak->gbytes_per_s <= 0 || peak->gflops_per_s <= 0) {
+    return -1;
+  }
+  return 0;
+}
+
+static double now_s(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/*
+ * Measures the peaks with num_threads threads: the best of
+ * ROOFLINE_REPETITIONS runs of a STREAM triad (3 x 8 bytes per element,
+ * without write allocation), and of the floating-point peak kernel of the
+ * selected ISA.
+ */
+void roofline_measure(roofline_peak *peak, int num_threads) {
+  const long n = ROOFLINE_STREAM_SIZE;
+  double *a = malloc(sizeof(double) * n);
+  double *b = malloc(sizeof(double) * n);
+  double *c = malloc(sizeof(double) * n);
+  double best_triad = 0, best_flops = 0, sink = 0;
+
+  #pragma omp parallel for schedule(static) num_threads(num_threads)
+  for (long i = 0; i < n; ++i) {
+    a[i] = 0;
+    b[i] = 1;
+    c[i] = 2;
+  }
+  for (int r = 0; r < ROOFLINE_REPETITIONS; ++r) {
+    const double start = now_s();
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (long i = 0; i < n; ++i) {
+      a[i] = b[i] + 3.0 * c[i];
+    }
+    const double rate = 3.0 * sizeof(double) * n / (now_s() - start) / 1e9;
+    best_triad = (rate > best_triad) ? rate : best_triad;
+  }
+
+  for (int r = 0; r < ROOFLINE_REPETITIONS; ++r) {
+    double flops = 0;
+    const double start = now_s();
+    #pragma omp parallel num_threads(num_threads) reduction(+:flops, sink)
+    {
+      double thread_sink;
+      flops += simd_dispatch.peak_flops(ROOFLINE_PEAK_ITERATIONS,
+                                        &thread_sink);
+      sink += thread_sink;
+    }
+    const double rate = flops / (now_s() - start) / 1e9;
+    best_flops = (rate > best_flops) ? rate : best_flops;
+  }
+
+  peak->gbytes_per_s = best_triad;
+  peak->gflops_per_s = best_flops;
+  peak_sink = sink;
+  free(a);
+  free(b);
+  free(c);
+}
+
+/*
+ * Prints and keeps the rates of a phase, unless it has no work model (Phase
+ * 9) or ran no iteration.
+ */
+void roofline_phase(const int phase, const unsigned long long duration_ns,
+    const phase_work work) {
+  if (phase < 1 || phase > ROOFLINE_MAX_PHASES || !duration_ns ||
+      !work.iterations || (!work.bytes && !work.flops)) {
+    return;
+  }
+  phase_rates[phase].run = 1;
+  phase_rates[phase].gbytes_per_s = work.bytes / duration_ns;
+  phase_rates[phase].gflops_per_s = work.flops / duration_ns;
+  phase_rates[phase].intensity = work.bytes ? work.flops / work.bytes : 0;
+  printf("Phase %d rates: %.3f GB/s", phase, phase_rates[phase].gbytes_per_s);
+  if (work.flops) {
+    printf(", %.3f GFLOP/s, %.3f FLOP/byte", phase_rates[phase].gflops_per_s,
+           phase_rates[phase].intensity);
+  }
+  printf("\n");
+}
+
+/*
+ * For each phase, the attainable rate is min(peak GFLOP/s, intensity x peak
+ * GB/s); phases below the ridge point (peak GFLOP/s / peak GB/s) are memory
+ * bound. Phases without flops are only compared to the peak bandwidth. Above
+ * 100% of the roof, the data of the phase stays in the caches.
+ */
+void roofline_summary(const roofline_peak *peak) {
+  const double ridge = peak->gflops_per_s / peak->gbytes_per_s;
+  printf("-------- Roofline --------\n");
+  printf("Peak bandwidth %.3f GB/s, peak %.3f GFLOP/s (%s), "
+         "ridge point %.3f FLOP/byte\n", peak->gbytes_per_s,
+         peak->gflops_per_s, peak->measured ? "measured" : "given", ridge);
+  printf("Phase     GB/s  GFLOP/s  FLOP/byte  %% of roof  bound\n");
+  for (int phase = 1; phase <= ROOFLINE_MAX_PHASES; ++phase) {
+    if (!phase_rates[phase].run) {
+      continue;
+    }
+    const double intensity = phase_rates[phase].intensity;
+    double fraction;
+    if (intensity > 0) {
+      const double roof = (intensity * peak->gbytes_per_s <
+                           peak->gflops_per_s) ?
+                          intensity * peak->gbytes_per_s : peak->gflops_per_s;
+      fraction = phase_rates[phase].gflops_per_s / roof;
+    } else {
+      fraction = phase_rates[phase].gbytes_per_s / peak->gbytes_per_s;
+    }
+    printf("%5d %8.3f %8.3f %10.3f %10.1f  %s%s\n", phase,
+           phase_rates[phase].gbytes_per_s, phase_rates[phase].gflops_per_s,
+           intensity, 100 * fraction,
+           (intensity == 0) ? "no flops" :
+           (intensity < ridge) ? "memory" : "compute",
+           (fraction > 1) ? " (in cache)" : "");
+  }
+  printf("--------------------------\n");
+}
@@ -0,0 +1,53 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef ROOFLINE_H_
+#define ROOFLINE_H_
+
+#include "meabo.h"
+#include "compute_kernels.h"
+
+/*
+ * Rates of each phase (GB/s, GFLOP/s, arithmetic intensity) from its work
+ * model, and roofline summary against the peak memory bandwidth and
+ * floating-point throughput of the machine (-k): measured at startup, or
+ * given on the command line.
+ */
+typedef struct roofline_peak {
+  int measured;
+  double gbytes_per_s;
+  double gflops_per_s;
+} roofline_peak;
+
+/* Triad arrays of the bandwidth measurement, in doubles (3 x 64 MiB) */
+#define ROOFLINE_STREAM_SIZE (1L << 23)
+#define ROOFLINE_REPETITIONS 5
+#define ROOFLINE_PEAK_ITERATIONS (1L << 22)
+
+int parse_roofline_peak(const char *str, roofline_peak *peak);
+
+void roofline_measure(roofline_peak *peak, int num_threads);
+
+void roofline_phase(const int phase, const unsigned long long duration_ns,
+    const phase_work work);
+
+void roofline_summary(const roofline_peak *peak);
+
+#endif /* ROOFLINE_H_ */
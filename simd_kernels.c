@@ -0,0 +1,715 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "simd_kernels.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+#define SIMD_AARCH64 1
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#if __GNUC__ >= 10 || defined(__clang__)
+#define SIMD_HAVE_SVE 1
+#endif
+#endif
+
+/* Coulomb's constant, used by Phase 8. */
+#define PHASE8_K (8.987551 * 1000000000)
+
+/*
+ * All the kernels are built without floating-point contraction: -ffast-math
+ * would otherwise fuse some multiplies and adds into FMAs, differently in
+ * each variant, and the Phase 1, 4 and 8 kernels would no longer compute the
+ * same values as the generic ones. The Phase 8 tiles still add up their
+ * forces in an order that depends on the vector width, and the peak kernels
+ * call fma explicitly.
+ */
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+
+/*
+ * Generic kernels: the original loops of the phases.
+ */
+static void phase1_generic(double *vals, int *int_vals, long begin,
+                           long end) {
+  #pragma omp simd
+  for (long j = begin; j < end; ++j) {
+    double temp1, temp2, temp3;
+    int int_temp1, int_temp2, int_temp3;
+    temp1 = vals[j];
+    int_temp1 = int_vals[j];
+    temp1 *= temp1;
+    temp2 = temp1 + vals[j];
+    temp3 = temp2 / (1024 + temp1);
+    temp3 -= vals[j];
+    int_temp1 *= int_temp1;
+    int_temp2 = int_temp1 + int_vals[j];
+    int_temp3 = int_temp2 / (1024 + int_temp1);
+    int_temp3 -= int_vals[j];
+    vals[j] = temp3;
+    int_vals[j] += (int_temp1 + int_temp2 + int_temp3) % 1024;
+  }
+}
+
+static void phase4_generic(double *dest, const double *src1,
+                           const double *src2, long begin, long end) {
+  #pragma omp simd
+  for (long i = begin; i < end; ++i) {
+    dest[i] += src1[i] + src2[i];
+  }
+}
+
+static void phase8_generic(const particle_set *particles, double *forces,
+                           long begin, long end) {
+  const double * restrict x = particles->x, * restrict y = particles->y;
+  const double * restrict z = particles->z;
+  const double * restrict charge = particles->charge;
+  #pragma omp simd
+  for (long i = begin; i < end; ++i) {
+    double r = (x[i+1] - x[i]) * (x[i+1] - x[i]) +
+               (y[i+1] - y[i]) * (y[i+1] - y[i]) +
+               (z[i+1] - z[i]) * (z[i+1] - z[i]);
+
+    forces[i] = (PHASE8_K * charge[i] * charge[i+1]) / r;
+  }
+}
+
+/*
+ * Adds to forces[i], for i in [i_begin, i_end), the force from the particles
+ * j in [j_begin, j_end) that are closer than sqrt(cutoff2). The j particles
+ * form a tile that stays in the L1 cache while all the i particles stream
+ * through it. Coincident particles (including i itself) are skipped.
+ *
+ * There is no hand-written version of this kernel: the body is inlined into
+ * one function per ISA, each compiled for its own target by the compiler.
+ */
+static inline __attribute__((always_inline))
+void phase8_tile_body(const particle_set *particles, double *forces,
+                      long i_begin, long i_end, long j_begin, long j_end,
+                      double cutoff2) {
+  const double * restrict x = particles->x, * restrict y = particles->y;
+  const double * restrict z = particles->z;
+  const double * restrict charge = particles->charge;
+  for (long i = i_begin; i < i_end; ++i) {
+    const double xi = x[i], yi = y[i], zi = z[i];
+    double sum = 0;
+    #pragma omp simd reduction(+:sum)
+    for (long j = j_begin; j < j_end; ++j) {
+      const double dx = x[j] - xi, dy = y[j] - yi, dz = z[j] - zi;
+      const double r = dx * dx + dy * dy + dz * dz;
+      sum += (r > 0 && r < cutoff2) ? charge[j] / r : 0;
+    }
+    forces[i] += PHASE8_K * charge[i] * sum;
+  }
+}
+
+static void phase8_tile_generic(const particle_set *particles,
+                                double *forces, long i_begin, long i_end,
+                                long j_begin, long j_end, double cutoff2) {
+  phase8_tile_body(particles, forces, i_begin, i_end, j_begin, j_end,
+                   cutoff2);
+}
+
+/*
+ * Floating-point peak: lanes independent multiply-add chains, i.e. 8 vectors
+ * of the ISA, enough to keep two FMA pipelines with a latency of 4 cycles
+ * busy. The chains converge to 1, so no value overflows or becomes denormal.
+ * Like the tile kernel, the body is compiled once per ISA.
+ */
+#define PEAK_MAX_LANES 64
+
+static inline __attribute__((always_inline))
+double peak_flops_body(long iterations, double *sink, const int lanes,
+                       const int fma) {
+  double acc[PEAK_MAX_LANES];
+  double sum = 0;
+  for (int k = 0; k < lanes; ++k) {
+    acc[k] = k;
+  }
+  for (long i = 0; i < iterations; ++i) {
+    #pragma omp simd
+    for (int k = 0; k < lanes; ++k) {
+      acc[k] = fma ? __builtin_fma(acc[k], 0.999999, 1e-6) :
+                     acc[k] * 0.999999 + 1e-6;
+    }
+  }
+  for (int k = 0; k < lanes; ++k) {
+    sum += acc[k];
+  }
+  *sink = sum;
+  return 2.0 * lanes * iterations;
+}
+
+static double peak_flops_generic(long iterations, double *sink) {
+  return peak_flops_body(iterations, sink, 16, 0);
+}
+
+/*
+ * The integer part of Phase 1 has no vector division on any of the ISAs
+ * below but SVE. The 32-bit operands are converted to double, which holds
+ * them exactly, and the truncated double quotient is the integer quotient.
+ * x % 1024 is x minus x rounded towards zero to a multiple of 1024.
+ */
+
+#if SIMD_X86
+/*
+ * SSE2 (2 doubles or 4 ints per vector).
+ */
+__attribute__((target("sse2")))
+static inline __m128i mullo_epi32_sse2(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i div_epi32_sse2(__m128i a, __m128i b) {
+  __m128i a_hi = _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2));
+  __m128i b_hi = _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2));
+  __m128d lo = _mm_div_pd(_mm_cvtepi32_pd(a), _mm_cvtepi32_pd(b));
+  __m128d hi = _mm_div_pd(_mm_cvtepi32_pd(a_hi), _mm_cvtepi32_pd(b_hi));
+  return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i mod1024_epi32_sse2(__m128i x) {
+  __m128i bias = _mm_and_si128(_mm_srai_epi32(x, 31), _mm_set1_epi32(1023));
+  __m128i trunc = _mm_and_si128(_mm_add_epi32(x, bias),
+                                _mm_set1_epi32(~1023));
+  return _mm_sub_epi32(x, trunc);
+}
+
+__attribute__((target("sse2")))
+static void phase1_sse2(double *vals, int *int_vals, long begin, long end) {
+  const __m128d c1024 = _mm_set1_pd(1024);
+  const __m128i i1024 = _mm_set1_epi32(1024);
+  long j = begin;
+  for (; j + 4 <= end; j += 4) {
+    for (int h = 0; h < 4; h += 2) {
+      __m128d v = _mm_loadu_pd(vals + j + h);
+      __m128d temp1 = _mm_mul_pd(v, v);
+      __m128d temp2 = _mm_add_pd(temp1, v);
+      __m128d temp3 = _mm_div_pd(temp2, _mm_add_pd(c1024, temp1));
+      _mm_storeu_pd(vals + j + h, _mm_sub_pd(temp3, v));
+    }
+    __m128i iv = _mm_loadu_si128((__m128i*) (int_vals + j));
+    __m128i int_temp1 = mullo_epi32_sse2(iv, iv);
+    __m128i int_temp2 = _mm_add_epi32(int_temp1, iv);
+    __m128i int_temp3 = div_epi32_sse2(int_temp2,
+                                       _mm_add_epi32(i1024, int_temp1));
+    int_temp3 = _mm_sub_epi32(int_temp3, iv);
+    __m128i sum = _mm_add_epi32(_mm_add_epi32(int_temp1, int_temp2),
+                                int_temp3);
+    _mm_storeu_si128((__m128i*) (int_vals + j),
+                     _mm_add_epi32(iv, mod1024_epi32_sse2(sum)));
+  }
+  phase1_generic(vals, int_vals, j, end);
+}
+
+__attribute__((target("sse2")))
+static void phase4_sse2(double *dest, const double *src1, const double *src2,
+                        long begin, long end) {
+  long i = begin;
+  for (; i + 2 <= end; i += 2) {
+    __m128d sum = _mm_add_pd(_mm_loadu_pd(src1 + i), _mm_loadu_pd(src2 + i));
+    _mm_storeu_pd(dest + i, _mm_add_pd(_mm_loadu_pd(dest + i), sum));
+  }
+  phase4_generic(dest, src1, src2, i, end);
+}
+
+__attribute__((target("sse2")))
+static void phase8_sse2(const particle_set *particles, double *forces,
+                        long begin, long end) {
+  const double *x = particles->x, *y = particles->y, *z = particles->z;
+  const double *charge = particles->charge;
+  const __m128d k = _mm_set1_pd(PHASE8_K);
+  long i = begin;
+  for (; i + 2 <= end; i += 2) {
+    __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + i + 1), _mm_loadu_pd(x + i));
+    __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + i + 1), _mm_loadu_pd(y + i));
+    __m128d dz = _mm_sub_pd(_mm_loadu_pd(z + i + 1), _mm_loadu_pd(z + i));
+    __m128d c0 = _mm_loadu_pd(charge + i);
+    __m128d c1 = _mm_loadu_pd(charge + i + 1);
+    __m128d r = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+                           _mm_mul_pd(dz, dz));
+    _mm_storeu_pd(forces + i,
+                  _mm_div_pd(_mm_mul_pd(_mm_mul_pd(k, c0), c1), r));
+  }
+  phase8_generic(particles, forces, i, end);
+}
+
+__attribute__((target("sse2")))
+static void phase8_tile_sse2(const particle_set *particles, double *forces,
+                             long i_begin, long i_end, long j_begin,
+                             long j_end, double cutoff2) {
+  phase8_tile_body(particles, forces, i_begin, i_end, j_begin, j_end,
+                   cutoff2);
+}
+
+/*
+ * AVX2 (4 doubles, with the matching 4 ints in an SSE register).
+ */
+__attribute__((target("avx2")))
+static void phase1_avx2(double *vals, int *int_vals, long begin, long end) {
+  const __m256d c1024 = _mm256_set1_pd(1024);
+  const __m128i i1024 = _mm_set1_epi32(1024);
+  long j = begin;
+  for (; j + 4 <= end; j += 4) {
+    __m256d v = _mm256_loadu_pd(vals + j);
+    __m256d temp1 = _mm256_mul_pd(v, v);
+    __m256d temp2 = _mm256_add_pd(temp1, v);
+    __m256d temp3 = _mm256_div_pd(temp2, _mm256_add_pd(c1024, temp1));
+    _mm256_storeu_pd(vals + j, _mm256_sub_pd(temp3, v));
+
+    __m128i iv = _mm_loadu_si128((__m128i*) (int_vals + j));
+    __m128i int_temp1 = _mm_mullo_epi32(iv, iv);
+    __m128i int_temp2 = _mm_add_epi32(int_temp1, iv);
+    __m256d quot = _mm256_div_pd(
+        _mm256_cvtepi32_pd(int_temp2),
+        _mm256_cvtepi32_pd(_mm_add_epi32(i1024, int_temp1)));
+    __m128i int_temp3 = _mm_sub_epi32(_mm256_cvttpd_epi32(quot), iv);
+    __m128i sum = _mm_add_epi32(_mm_add_epi32(int_temp1, int_temp2),
+                                int_temp3);
+    _mm_storeu_si128((__m128i*) (int_vals + j),
+                     _mm_add_epi32(iv, mod1024_epi32_sse2(sum)));
+  }
+  phase1_generic(vals, int_vals, j, end);
+}
+
+__attribute__((target("avx2")))
+static void phase4_avx2(double *dest, const double *src1, const double *src2,
+                        long begin, long end) {
+  long i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m256d sum = _mm256_add_pd(_mm256_loadu_pd(src1 + i),
+                                _mm256_loadu_pd(src2 + i));
+    _mm256_storeu_pd(dest + i, _mm256_add_pd(_mm256_loadu_pd(dest + i), sum));
+  }
+  phase4_generic(dest, src1, src2, i, end);
+}
+
+__attribute__((target("avx2")))
+static void phase8_avx2(const particle_set *particles, double *forces,
+                        long begin, long end) {
+  const double *x = particles->x, *y = particles->y, *z = particles->z;
+  const double *charge = particles->charge;
+  const __m256d k = _mm256_set1_pd(PHASE8_K);
+  long i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i + 1),
+                               _mm256_loadu_pd(x + i));
+    __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i + 1),
+                               _mm256_loadu_pd(y + i));
+    __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(z + i + 1),
+                               _mm256_loadu_pd(z + i));
+    __m256d c0 = _mm256_loadu_pd(charge + i);
+    __m256d c1 = _mm256_loadu_pd(charge + i + 1);
+    __m256d r = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+                                            _mm256_mul_pd(dy, dy)),
+                              _mm256_mul_pd(dz, dz));
+    _mm256_storeu_pd(forces + i,
+                     _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(k, c0), c1),
+                                   r));
+  }
+  phase8_generic(particles, forces, i, end);
+}
+
+__attribute__((target("avx2,fma")))
+static double peak_flops_avx2(long iterations, double *sink) {
+  return peak_flops_body(iterations, sink, 32, 1);
+}
+
+__attribute__((target("avx2,fma")))
+static void phase8_tile_avx2(const particle_set *particles, double *forces,
+                             long i_begin, long i_end, long j_begin,
+                             long j_end, double cutoff2) {
+  phase8_tile_body(particles, forces, i_begin, i_end, j_begin, j_end,
+                   cutoff2);
+}
+
+/*
+ * AVX-512F (8 doubles, with the matching 8 ints in an AVX2 register).
+ */
+__attribute__((target("avx512f")))
+static inline __m256i mod1024_epi32_avx2(__m256i x) {
+  __m256i bias = _mm256_and_si256(_mm256_srai_epi32(x, 31),
+                                  _mm256_set1_epi32(1023));
+  __m256i trunc = _mm256_and_si256(_mm256_add_epi32(x, bias),
+                                   _mm256_set1_epi32(~1023));
+  return _mm256_sub_epi32(x, trunc);
+}
+
+__attribute__((target("avx512f")))
+static void phase1_avx512(double *vals, int *int_vals, long begin,
+                          long end) {
+  const __m512d c1024 = _mm512_set1_pd(1024);
+  const __m256i i1024 = _mm256_set1_epi32(1024);
+  long j = begin;
+  for (; j + 8 <= end; j += 8) {
+    __m512d v = _mm512_loadu_pd(vals + j);
+    __m512d temp1 = _mm512_mul_pd(v, v);
+    __m512d temp2 = _mm512_add_pd(temp1, v);
+    __m512d temp3 = _mm512_div_pd(temp2, _mm512_add_pd(c1024, temp1));
+    _mm512_storeu_pd(vals + j, _mm512_sub_pd(temp3, v));
+
+    __m256i iv = _mm256_loadu_si256((__m256i*) (int_vals + j));
+    __m256i int_temp1 = _mm256_mullo_epi32(iv, iv);
+    __m256i int_temp2 = _mm256_add_epi32(int_temp1, iv);
+    __m512d quot = _mm512_div_pd(
+        _mm512_cvtepi32_pd(int_temp2),
+        _mm512_cvtepi32_pd(_mm256_add_epi32(i1024, int_temp1)));
+    __m256i int_temp3 = _mm256_sub_epi32(_mm512_cvttpd_epi32(quot), iv);
+    __m256i sum = _mm256_add_epi32(_mm256_add_epi32(int_temp1, int_temp2),
+                                   int_temp3);
+    _mm256_storeu_si256((__m256i*) (int_vals + j),
+                        _mm256_add_epi32(iv, mod1024_epi32_avx2(sum)));
+  }
+  phase1_avx2(vals, int_vals, j, end);
+}
+
+__attribute__((target("avx512f")))
+static void phase4_avx512(double *dest, const double *src1,
+                          const double *src2, long begin, long end) {
+  long i = begin;
+  for (; i + 8 <= end; i += 8) {
+    __m512d sum = _mm512_add_pd(_mm512_loadu_pd(src1 + i),
+                                _mm512_loadu_pd(src2 + i));
+    _mm512_storeu_pd(dest + i, _mm512_add_pd(_mm512_loadu_pd(dest + i), sum));
+  }
+  phase4_avx2(dest, src1, src2, i, end);
+}
+
+__attribute__((target("avx512f")))
+static void phase8_avx512(const particle_set *particles, double *forces,
+                          long begin, long end) {
+  const double *x = particles->x, *y = particles->y, *z = particles->z;
+  const double *charge = particles->charge;
+  const __m512d k = _mm512_set1_pd(PHASE8_K);
+  long i = begin;
+  for (; i + 8 <= end; i += 8) {
+    __m512d dx = _mm512_sub_pd(_mm512_loadu_pd(x + i + 1),
+                               _mm512_loadu_pd(x + i));
+    __m512d dy = _mm512_sub_pd(_mm512_loadu_pd(y + i + 1),
+                               _mm512_loadu_pd(y + i));
+    __m512d dz = _mm512_sub_pd(_mm512_loadu_pd(z + i + 1),
+                               _mm512_loadu_pd(z + i));
+    __m512d c0 = _mm512_loadu_pd(charge + i);
+    __m512d c1 = _mm512_loadu_pd(charge + i + 1);
+    __m512d r = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx),
+                                            _mm512_mul_pd(dy, dy)),
+                              _mm512_mul_pd(dz, dz));
+    _mm512_storeu_pd(forces + i,
+                     _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(k, c0), c1),
+                                   r));
+  }
+  phase8_avx2(particles, forces, i, end);
+}
+
+__attribute__((target("avx512f,fma,prefer-vector-width=512")))
+static double peak_flops_avx512(long iterations, double *sink) {
+  return peak_flops_body(iterations, sink, 64, 1);
+}
+
+__attribute__((target("avx512f,fma,prefer-vector-width=512")))
+static void phase8_tile_avx512(const particle_set *particles,
+                               double *forces, long i_begin, long i_end,
+                               long j_begin, long j_end, double cutoff2) {
+  phase8_tile_body(particles, forces, i_begin, i_end, j_begin, j_end,
+                   cutoff2);
+}
+#endif /* SIMD_X86 */
+
+#if SIMD_AARCH64
+/*
+ * NEON (2 doubles, with the matching 2 ints in a 64-bit register).
+ */
+static inline int32x2_t mod1024_s32_neon(int32x2_t x) {
+  int32x2_t bias = vand_s32(vshr_n_s32(x, 31), vdup_n_s32(1023));
+  int32x2_t trunc = vand_s32(vadd_s32(x, bias), vdup_n_s32(~1023));
+  return vsub_s32(x, trunc);
+}
+
+static void phase1_neon(double *vals, int *int_vals, long begin, long end) {
+  const float64x2_t c1024 = vdupq_n_f64(1024);
+  long j = begin;
+  for (; j + 2 <= end; j += 2) {
+    float64x2_t v = vld1q_f64(vals + j);
+    float64x2_t temp1 = vmulq_f64(v, v);
+    float64x2_t temp2 = vaddq_f64(temp1, v);
+    float64x2_t temp3 = vdivq_f64(temp2, vaddq_f64(c1024, temp1));
+    vst1q_f64(vals + j, vsubq_f64(temp3, v));
+
+    int32x2_t iv = vld1_s32(int_vals + j);
+    int32x2_t int_temp1 = vmul_s32(iv, iv);
+    int32x2_t int_temp2 = vadd_s32(int_temp1, iv);
+    float64x2_t quot = vdivq_f64(
+        vcvtq_f64_s64(vmovl_s32(int_temp2)),
+        vcvtq_f64_s64(vmovl_s32(vadd_s32(vdup_n_s32(1024), int_temp1))));
+    int32x2_t int_temp3 = vsub_s32(vmovn_s64(vcvtq_s64_f64(quot)), iv);
+    int32x2_t sum = vadd_s32(vadd_s32(int_temp1, int_temp2), int_temp3);
+    vst1_s32(int_vals + j, vadd_s32(iv, mod1024_s32_neon(sum)));
+  }
+  phase1_generic(vals, int_vals, j, end);
+}
+
+static void phase4_neon(double *dest, const double *src1, const double *src2,
+                        long begin, long end) {
+  long i = begin;
+  for (; i + 2 <= end; i += 2) {
+    float64x2_t sum = vaddq_f64(vld1q_f64(src1 + i), vld1q_f64(src2 + i));
+    vst1q_f64(dest + i, vaddq_f64(vld1q_f64(dest + i), sum));
+  }
+  phase4_generic(dest, src1, src2, i, end);
+}
+
+static void phase8_neon(const particle_set *particles, double *forces,
+                        long begin, long end) {
+  const double *x = particles->x, *y = particles->y, *z = particles->z;
+  const double *charge = particles->charge;
+  const float64x2_t k = vdupq_n_f64(PHASE8_K);
+  long i = begin;
+  for (; i + 2 <= end; i += 2) {
+    float64x2_t dx = vsubq_f64(vld1q_f64(x + i + 1), vld1q_f64(x + i));
+    float64x2_t dy = vsubq_f64(vld1q_f64(y + i + 1), vld1q_f64(y + i));
+    float64x2_t dz = vsubq_f64(vld1q_f64(z + i + 1), vld1q_f64(z + i));
+    float64x2_t c0 = vld1q_f64(charge + i);
+    float64x2_t c1 = vld1q_f64(charge + i + 1);
+    float64x2_t r = vaddq_f64(vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy)),
+                              vmulq_f64(dz, dz));
+    vst1q_f64(forces + i, vdivq_f64(vmulq_f64(vmulq_f64(k, c0), c1), r));
+  }
+  phase8_generic(particles, forces, i, end);
+}
+
+static double peak_flops_neon(long iterations, double *sink) {
+  return peak_flops_body(iterations, sink, 16, 1);
+}
+
+#if SIMD_HAVE_SVE
+#pragma GCC push_options
+#pragma GCC target("+sve")
+#include <arm_sve.h>
+
+/*
+ * SVE, vector length agnostic. The ints of Phase 1 are widened to 64-bit
+ * lanes, so that they line up with the doubles; every 32-bit operation is
+ * followed by a sign extension of the low word to keep the 32-bit
+ * wrap-around, and the store narrows them back.
+ */
+static void phase1_sve(double *vals, int *int_vals, long begin, long end) {
+  for (long j = begin; j < end; j += svcntd()) {
+    svbool_t pg = svwhilelt_b64(j, end);
+    svfloat64_t v = svld1_f64(pg, vals + j);
+    svfloat64_t temp1 = svmul_f64_x(pg, v, v);
+    svfloat64_t temp2 = svadd_f64_x(pg, temp1, v);
+    svfloat64_t temp3 = svdiv_f64_x(pg, temp2,
+                                    svadd_n_f64_x(pg, temp1, 1024));
+    svst1_f64(pg, vals + j, svsub_f64_x(pg, temp3, v));
+
+    svint64_t iv = svld1sw_s64(pg, int_vals + j);
+    svint64_t int_temp1 = svextw_s64_x(pg, svmul_s64_x(pg, iv, iv));
+    svint64_t int_temp2 = svextw_s64_x(pg, svadd_s64_x(pg, int_temp1, iv));
+    svint64_t divisor = svextw_s64_x(pg, svadd_n_s64_x(pg, int_temp1, 1024));
+    svint64_t int_temp3 = svextw_s64_x(pg,
+        svsub_s64_x(pg, svdiv_s64_x(pg, int_temp2, divisor), iv));
+    svint64_t sum = svextw_s64_x(pg, svadd_s64_x(pg,
+        svadd_s64_x(pg, int_temp1, int_temp2), int_temp3));
+    svint64_t rem = svsub_s64_x(pg, sum,
+        svmul_n_s64_x(pg, svdiv_n_s64_x(pg, sum, 1024), 1024));
+    svst1w_s64(pg, int_vals + j, svadd_s64_x(pg, iv, rem));
+  }
+}
+
+static void phase4_sve(double *dest, const double *src1, const double *src2,
+                       long begin, long end) {
+  for (long i = begin; i < end; i += svcntd()) {
+    svbool_t pg = svwhilelt_b64(i, end);
+    svfloat64_t sum = svadd_f64_x(pg, svld1_f64(pg, src1 + i),
+                                  svld1_f64(pg, src2 + i));
+    svst1_f64(pg, dest + i, svadd_f64_x(pg, svld1_f64(pg, dest + i), sum));
+  }
+}
+
+static void phase8_sve(const particle_set *particles, double *forces,
+                       long begin, long end) {
+  const double *x = particles->x, *y = particles->y, *z = particles->z;
+  const double *charge = particles->charge;
+  for (long i = begin; i < end; i += svcntd()) {
+    svbool_t pg = svwhilelt_b64(i, end);
+    svfloat64_t dx = svsub_f64_x(pg, svld1_f64(pg, x + i + 1),
+                                 svld1_f64(pg, x + i));
+    svfloat64_t dy = svsub_f64_x(pg, svld1_f64(pg, y + i + 1),
+                                 svld1_f64(pg, y + i));
+    svfloat64_t dz = svsub_f64_x(pg, svld1_f64(pg, z + i + 1),
+                                 svld1_f64(pg, z + i));
+    svfloat64_t r = svadd_f64_x(pg, svadd_f64_x(pg, svmul_f64_x(pg, dx, dx),
+                                                svmul_f64_x(pg, dy, dy)),
+                                svmul_f64_x(pg, dz, dz));
+    svfloat64_t c0 = svld1_f64(pg, charge + i);
+    svfloat64_t c1 = svld1_f64(pg, charge + i + 1);
+    svst1_f64(pg, forces + i, svdiv_f64_x(pg,
+        svmul_f64_x(pg, svmul_n_f64_x(pg, c0, PHASE8_K), c1), r));
+  }
+}
+
+static void phase8_tile_sve(const particle_set *particles, double *forces,
+                            long i_begin, long i_end, long j_begin,
+                            long j_end, double cutoff2) {
+  phase8_tile_body(particles, forces, i_begin, i_end, j_begin, j_end,
+                   cutoff2);
+}
+
+static double peak_flops_sve(long iterations, double *sink) {
+  return peak_flops_body(iterations, sink, PEAK_MAX_LANES, 1);
+}
+
+#pragma GCC pop_options
+#endif /* SIMD_HAVE_SVE */
+#endif /* SIMD_AARCH64 */
+
+#pragma GCC pop_options
+
+/*
+ * Kernels built into this binary, indexed by ISA.
+ */
+static const simd_kernels simd_table[SIMD_NUM_ISAS] = {
+  [SIMD_GENERIC] = { SIMD_GENERIC, phase1_generic, phase4_generic,
+                     phase8_generic, phase8_tile_generic,
+                     peak_flops_generic },
+#if SIMD_X86
+  [SIMD_SSE2] = { SIMD_SSE2, phase1_sse2, phase4_sse2, phase8_sse2,
+                  phase8_tile_sse2, peak_flops_generic },
+  [SIMD_AVX2] = { SIMD_AVX2, phase1_avx2, phase4_avx2, phase8_avx2,
+                  phase8_tile_avx2, peak_flops_avx2 },
+  [SIMD_AVX512] = { SIMD_AVX512, phase1_avx512, phase4_avx512,
+                    phase8_avx512, phase8_tile_avx512, peak_flops_avx512 },
+#endif
+#if SIMD_AARCH64
+  [SIMD_NEON] = { SIMD_NEON, phase1_neon, phase4_neon, phase8_neon,
+                  phase8_tile_generic, peak_flops_neon },
+#if SIMD_HAVE_SVE
+  [SIMD_SVE] = { SIMD_SVE, phase1_sve, phase4_sve, phase8_sve,
+                 phase8_tile_sve, peak_flops_sve },
+#endif
+#endif
+};
+
+simd_kernels simd_dispatch = { SIMD_GENERIC, phase1_generic, phase4_generic,
+                               phase8_generic, phase8_tile_generic,
+                               peak_flops_generic };
+
+static const char *simd_isa_names[SIMD_NUM_ISAS] = {
+  "generic", "sse2", "avx2", "avx512", "neon", "sve"
+};
+
+/*
+ * Parses an ISA name; "auto" selects the best ISA of the CPU. Returns 0 on
+ * success.
+ */
+int parse_simd_isa(const char *str, simd_isa *isa) {
+  if (!strcmp(str, "auto")) {
+    *isa = simd_detect();
+    return 0;
+  }
+  for (int i = 0; i < SIMD_NUM_ISAS; ++i) {
+    if (!strcmp(str, simd_isa_names[i])) {
+      *isa = i;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+const char* simd_isa_name(const simd_isa isa) {
+  return (isa >= 0 && isa < SIMD_NUM_ISAS) ? simd_isa_names[isa] : "unknown";
+}
+
+/*
+ * Whether the kernels of isa are built into this binary and can run on this
+ * CPU.
+ */
+int simd_supported(const simd_isa isa) {
+  if (isa < 0 || isa >= SIMD_NUM_ISAS || simd_table[isa].phase1 == NULL) {
+    return 0;
+  }
+  switch (isa) {
+#if SIMD_X86
+    case SIMD_SSE2:
+      return __builtin_cpu_supports("sse2");
+    /* The peak kernels of avx2 and avx512 use FMA */
+    case SIMD_AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case SIMD_AVX512:
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("fma");
+#endif
+#if SIMD_AARCH64
+    case SIMD_NEON:
+#ifdef HWCAP_ASIMD
+      return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+      return 1;
+#endif
+    case SIMD_SVE:
+#ifdef HWCAP_SVE
+      return (getauxval(AT_HWCAP) & HWCAP_SVE) != 0;
+#else
+      return 0;
+#endif
+#endif
+    default:
+      return isa == SIMD_GENERIC;
+  }
+}
+
+/*
+ * Widest ISA supported by the CPU.
+ */
+simd_isa simd_detect(void) {
+  static const simd_isa preference[] = {
+    SIMD_AVX512, SIMD_AVX2, SIMD_SSE2, SIMD_SVE, SIMD_NEON
+  };
+#if SIMD_X86
+  __builtin_cpu_init();
+#endif
+  for (int i = 0; i < sizeof(preference) / sizeof(preference[0]); ++i) {
+    if (simd_supported(preference[i])) {
+      return preference[i];
+    }
+  }
+  return SIMD_GENERIC;
+}
+
+/*
+ * Makes the kernels of isa the ones used by Phases 1, 4 and 8. Returns 0 on
+ * success, -1 if isa cannot be used on this CPU.
+ */
+int simd_select(const simd_isa isa) {
+  if (!simd_supported(isa)) {
+    return -1;
+  }
+  simd_dispatch = simd_table[isa];
+  return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef SIMD_KERNELS_H_
+#define SIMD_KERNELS_H_
+
+#include "meabo.h"
+
+/*
+ * Hand-vectorised inner loops of Phases 1, 4 and 8 (the Phase 8 all pairs
+ * and cell list tiles are compiler-vectorised for each ISA), and the
+ * floating-point peak kernel of the roofline.
+ *
+ * Every variant is compiled into the binary with a per-function target
+ * attribute, so no extra compiler flags are needed, and the best one the CPU
+ * supports is selected at startup (or forced with -V):
+ * - generic: plain C, vectorised (or not) by the compiler for the flags of
+ *   the Makefile;
+ * - sse2, avx2, avx512: x86_64 (avx2 and avx512 also need FMA, and avx512
+ *   needs no AVX-512 extension beyond AVX-512F);
+ * - neon, sve: AArch64 (sve is vector length agnostic).
+ */
+typedef enum simd_isa {
+  SIMD_GENERIC = 0,
+  SIMD_SSE2,
+  SIMD_AVX2,
+  SIMD_AVX512,
+  SIMD_NEON,
+  SIMD_SVE,
+  SIMD_NUM_ISAS
+} simd_isa;
+
+/* Each kernel processes the elements [begin, end) of its phase. */
+typedef struct simd_kernels {
+  simd_isa isa;
+  void (*phase1)(double *vals, int *int_vals, long begin, long end);
+  void (*phase4)(double *dest, const double *src1, const double *src2,
+                 long begin, long end);
+  void (*phase8)(const particle_set *particles, double *forces, long begin,
+                 long end);
+  void (*phase8_tile)(const particle_set *particles, double *forces,
+                      long i_begin, long i_end, long j_begin, long j_end,
+                      double cutoff2);
+  /* Returns the number of flops done; *sink keeps the result alive. */
+  double (*peak_flops)(long iterations, double *sink);
+} simd_kernels;
+
+/* Kernels in use; set by simd_select. */
+extern simd_kernels simd_dispatch;
+
+int parse_simd_isa(const char *str, simd_isa *isa);
+
+const char* simd_isa_name(const simd_isa isa);
+
+int simd_supported(const simd_isa isa);
+
+simd_isa simd_detect(void);
+
+int simd_select(const simd_isa isa);
+
+/*
+ * Range of [0, n) that the calling thread gets under a static OpenMP
+ * schedule, so that explicit kernels touch the same elements as the
+ * initialisation loops.
+ */
+static inline void simd_thread_range(const long n, long *begin, long *end) {
+#ifdef _OPENMP
+  const long num_threads = omp_get_num_threads();
+  const long thread = omp_get_thread_num();
+#else
+  const long num_threads = 1, thread = 0;
+#endif
+  const long q = n / num_threads, r = n % num_threads;
+  *begin = thread * q + (thread < r ? thread : r);
+  *end = *begin + q + (thread < r);
+}
+
+#endif /* SIMD_KERNELS_H_ */
@@ -0,0 +1,366 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "sparse.h"
+
+typedef struct sparse_row_len {
+  int len;
+  int row;
+} sparse_row_len;
+
+/*
+ * Longest rows first; rows of equal length keep their original order, so the
+ * permutation does not depend on the qsort implementation.
+ */
+static int compare_row_len(const void *a, const void *b) {
+  const sparse_row_len *ra = a, *rb = b;
+  if (ra->len != rb->len) {
+    return rb->len - ra->len;
+  }
+  return ra->row - rb->row;
+}
+
+static int compare_int(const void *a, const void *b) {
+  return *(const int*) a - *(const int*) b;
+}
+
+/*
+ * Parses a format of the form csr, sell[:C[:sigma]] or bell[:B].
+ * Returns 0 on success.
+ */
+int parse_sparse_format(const char *str, sparse_format_spec *spec) {
+  spec->format = SPARSE_CSR;
+  spec->chunk_size = SPARSE_DEFAULT_CHUNK;
+  spec->sigma = SPARSE_DEFAULT_SIGMA;
+  spec->block_size = SPARSE_DEFAULT_BLOCK;
+
+  if (!strcmp(str, "csr")) {
+    spec->format = SPARSE_CSR;
+  } else if (!strncmp(str, "sell", 4)) {
+    spec->format = SPARSE_SELL;
+    sscanf(str, "sell:%d:%d", &spec->chunk_size, &spec->sigma);
+    if (spec->chunk_size < 1 || spec->sigma < 1) {
+      return -1;
+    }
+  } else if (!strncmp(str, "bell", 4)) {
+    spec->format = SPARSE_BELL;
+    sscanf(str, "bell:%d", &spec->block_size);
+    if (spec->block_size < 1) {
+      return -1;
+    }
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+const char* sparse_format_name(const sparse_format format) {
+  switch (format) {
+    case SPARSE_SELL:
+      return "SELL-C-sigma";
+    case SPARSE_BELL:
+      return "blocked ELL";
+    default:
+      return "CSR";
+  }
+}
+
+/*
+ * Allocates an empty matrix and its CSR row pointers. The caller fills
+ * row_ptr with the row lengths (row_ptr[i + 1] holds the length of row i),
+ * then calls sparse_alloc_csr. The arrays used by the kernels are allocated
+ * with the memory policy of the matrix.
+ */
+sparse_matrix* sparse_alloc(const int nrow, const int ncol,
+                            const sparse_format_spec *spec,
+                            const mem_policy *policy) {
+  sparse_matrix *matrix = calloc(1, sizeof(sparse_matrix));
+  matrix->spec = *spec;
+  matrix->mem = *policy;
+  matrix->nrow = nrow;
+  matrix->ncol = ncol;
+  matrix->row_ptr = mem_alloc(sizeof(long) * (nrow + 1), policy);
+  return matrix;
+}
+
+/*
+ * Turns the row lengths into row offsets and allocates the column index and
+ * value arrays. The arrays are not touched, so that the rows can be first
+ * touched by the threads that will process them.
+ */
+void sparse_alloc_csr(sparse_matrix *matrix) {
+  for (int i = 0; i < matrix->nrow; ++i) {
+    matrix->row_ptr[i + 1] += matrix->row_ptr[i];
+  }
+  matrix->nnz = matrix->row_ptr[matrix->nrow];
+  matrix->stored = matrix->nnz;
+  matrix->col_idx = mem_alloc(sizeof(int) * matrix->nnz, &matrix->mem);
+  matrix->values = mem_alloc(sizeof(double) * matrix->nnz, &matrix->mem);
+}
+
+static void sparse_free_csr(sparse_matrix *matrix) {
+  mem_free(matrix->col_idx);
+  mem_free(matrix->values);
+  matrix->col_idx = NULL;
+  matrix->values = NULL;
+}
+
+/*
+ * CSR to SELL-C-sigma. Must be called by all threads of a parallel region.
+ */
+static void sparse_convert_sell(sparse_matrix *matrix) {
+  const int nrow = matrix->nrow;
+  const int C = matrix->spec.chunk_size;
+  const int sigma = matrix->spec.sigma;
+  const int num_chunks = (nrow + C - 1) / C;
+  const int num_windows = (nrow + sigma - 1) / sigma;
+  const long *row_ptr = matrix->row_ptr;
+
+  #pragma omp single
+  {
+    matrix->num_chunks = num_chunks;
+    matrix->row_perm = malloc(sizeof(int) * num_chunks * C);
+    matrix->chunk_len = malloc(sizeof(int) * num_chunks);
+    matrix->chunk_ptr = malloc(sizeof(long) * (num_chunks + 1));
+    for (int i = nrow; i < num_chunks * C; ++i) {
+      matrix->row_perm[i] = -1;
+    }
+  }
+
+  sparse_row_len *window = malloc(sizeof(sparse_row_len) * sigma);
+  #pragma omp for schedule(static)
+  for (int w = 0; w < num_windows; ++w) {
+    const int first = w * sigma;
+    const int last = (first + sigma < nrow) ? first + sigma : nrow;
+    for (int i = first; i < last; ++i) {
+      window[i - first].len = row_ptr[i + 1] - row_ptr[i];
+      window[i - first].row = i;
+    }
+    qsort(window, last - first, sizeof(sparse_row_len), compare_row_len);
+    for (int i = first; i < last; ++i) {
+      matrix->row_perm[i] = window[i - first].row;
+    }
+  }
+  free(window);
+
+  #pragma omp for schedule(static)
+  for (int c = 0; c < num_chunks; ++c) {
+    int len = 0;
+    for (int r = 0; r < C; ++r) {
+      const int row = matrix->row_perm[c * C + r];
+      if (row >= 0 && row_ptr[row + 1] - row_ptr[row] > len) {
+        len = row_ptr[row + 1] - row_ptr[row];
+      }
+    }
+    matrix->chunk_len[c] = len;
+  }
+
+  #pragma omp single
+  {
+    matrix->chunk_ptr[0] = 0;
+    for (int c = 0; c < num_chunks; ++c) {
+      matrix->chunk_ptr[c + 1] = matrix->chunk_ptr[c] +
+                                 (long) matrix->chunk_len[c] * C;
+    }
+    matrix->stored = matrix->chunk_ptr[num_chunks];
+    matrix->sell_cols = mem_alloc(sizeof(int) * matrix->stored, &matrix->mem);
+    matrix->sell_values = mem_alloc(sizeof(double) * matrix->stored,
+                                    &matrix->mem);
+  }
+
+  #pragma omp for schedule(static)
+  for (int c = 0; c < num_chunks; ++c) {
+    int * restrict cols = matrix->sell_cols + matrix->chunk_ptr[c];
+    double * restrict values = matrix->sell_values + matrix->chunk_ptr[c];
+    for (int r = 0; r < C; ++r) {
+      const int row = matrix->row_perm[c * C + r];
+      const long len = (row >= 0) ? row_ptr[row + 1] - row_ptr[row] : 0;
+      for (int j = 0; j < matrix->chunk_len[c]; ++j) {
+        if (j < len) {
+          cols[j * C + r] = matrix->col_idx[row_ptr[row] + j];
+          values[j * C + r] = matrix->values[row_ptr[row] + j];
+        } else {
+          cols[j * C + r] = 0;
+          values[j * C + r] = 0.0;
+        }
+      }
+    }
+  }
+}
+
+/*
+ * CSR to blocked ELL. Must be called by all threads of a parallel region.
+ */
+static void sparse_convert_bell(sparse_matrix *matrix) {
+  const int nrow = matrix->nrow;
+  const int B = matrix->spec.block_size;
+  const int num_block_rows = (nrow + B - 1) / B;
+  const int num_block_cols = (matrix->ncol + B - 1) / B;
+  const long *row_ptr = matrix->row_ptr;
+  int width = 0;
+
+  /* seen[bc] holds the last block row in which block column bc was found. */
+  int *seen = malloc(sizeof(int) * num_block_cols);
+  int *pos = malloc(sizeof(int) * num_block_cols);
+  int *list = malloc(sizeof(int) * num_block_cols);
+  for (int bc = 0; bc < num_block_cols; ++bc) {
+    seen[bc] = -1;
+  }
+
+  #pragma omp for schedule(static) nowait
+  for (int br = 0; br < num_block_rows; ++br) {
+    int count = 0;
+    for (int i = br * B; i < (br + 1) * B && i < nrow; ++i) {
+      for (long j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+        const int bc = matrix->col_idx[j] / B;
+        if (seen[bc] != br) {
+          seen[bc] = br;
+          ++count;
+        }
+      }
+    }
+    if (count > width) {
+      width = count;
+    }
+  }
+
+  /* width is private to each thread; matrix->ell_width starts at 0. */
+  #pragma omp critical
+  {
+    if (width > matrix->ell_width) {
+      matrix->ell_width = width;
+    }
+  }
+  #pragma omp barrier
+
+  #pragma omp single
+  {
+    matrix->num_block_rows = num_block_rows;
+    matrix->stored = (long) num_block_rows * matrix->ell_width * B * B;
+    matrix->bell_cols = mem_alloc(sizeof(int) * num_block_rows *
+                                  matrix->ell_width, &matrix->mem);
+    matrix->bell_values = mem_alloc(sizeof(double) * matrix->stored,
+                                    &matrix->mem);
+  }
+
+  width = matrix->ell_width;
+  for (int bc = 0; bc < num_block_cols; ++bc) {
+    seen[bc] = -1;
+  }
+
+  #pragma omp for schedule(static)
+  for (int br = 0; br < num_block_rows; ++br) {
+    int * restrict cols = matrix->bell_cols + (long) br * width;
+    double * restrict values = matrix->bell_values +
+                               (long) br * width * B * B;
+    int count = 0;
+    for (int i = br * B; i < (br + 1) * B && i < nrow; ++i) {
+      for (long j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+        const int bc = matrix->col_idx[j] / B;
+        if (seen[bc] != br) {
+          seen[bc] = br;
+          list[count++] = bc;
+        }
+      }
+    }
+    qsort(list, count, sizeof(int), compare_int);
+    for (int k = 0; k < width; ++k) {
+      cols[k] = (k < count) ? list[k] : -1;
+      if (k < count) {
+        pos[list[k]] = k;
+      }
+    }
+    memset(values, 0, sizeof(double) * width * B * B);
+    for (int i = br * B; i < (br + 1) * B && i < nrow; ++i) {
+      for (long j = row_ptr[i]; j < row_ptr[i + 1]; ++j) {
+        const int col = matrix->col_idx[j];
+        values[((long) pos[col / B] * B + (i - br * B)) * B + col % B] =
+            matrix->values[j];
+      }
+    }
+  }
+
+  free(seen);
+  free(pos);
+  free(list);
+}
+
+/*
+ * Converts a CSR matrix to the format of its spec, then releases the CSR
+ * arrays (which are no longer used by the kernel). Must be called by all
+ * threads of a parallel region, after the CSR arrays have been filled: the
+ * new arrays are first touched with the same static schedule as Phase 6.
+ */
+void sparse_convert(sparse_matrix *matrix) {
+  switch (matrix->spec.format) {
+    case SPARSE_SELL:
+      sparse_convert_sell(matrix);
+      break;
+    case SPARSE_BELL:
+      sparse_convert_bell(matrix);
+      break;
+    default:
+      return;
+  }
+  #pragma omp single
+  {
+    sparse_free_csr(matrix);
+  }
+}
+
+void sparse_free(sparse_matrix *matrix) {
+  if (matrix == NULL) {
+    return;
+  }
+  sparse_free_csr(matrix);
+  mem_free(matrix->row_ptr);
+  free(matrix->chunk_ptr);
+  free(matrix->chunk_len);
+  free(matrix->row_perm);
+  mem_free(matrix->sell_cols);
+  mem_free(matrix->sell_values);
+  mem_free(matrix->bell_cols);
+  mem_free(matrix->bell_values);
+  free(matrix);
+}
+
+/* Adds the pages of the arrays used by the kernels to stats. */
+void sparse_count_pages(const sparse_matrix *matrix, mem_stats *stats) {
+  const void *arrays[] = { matrix->row_ptr, matrix->col_idx, matrix->values,
+                           matrix->sell_cols, matrix->sell_values,
+                           matrix->bell_cols, matrix->bell_values };
+  for (int i = 0; i < 7; ++i) {
+    mem_count(arrays[i], stats);
+  }
+}
+
+void sparse_print_info(const sparse_matrix *matrix) {
+  printf("Sparse matrix format %s", sparse_format_name(matrix->spec.format));
+  if (matrix->spec.format == SPARSE_SELL) {
+    printf(" (C %d, sigma %d)", matrix->spec.chunk_size, matrix->spec.sigma);
+  } else if (matrix->spec.format == SPARSE_BELL) {
+    printf(" (block %d, width %d)", matrix->spec.block_size,
+           matrix->ell_width);
+  }
+  printf("\n");
+  printf("Sparse matrix nonzeros %ld, stored values %ld (fill %.3f)\n",
+         matrix->nnz, matrix->stored,
+         matrix->nnz ? (double) matrix->stored / matrix->nnz : 0.0);
+}
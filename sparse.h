@@ -0,0 +1,102 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef SPARSE_H_
+#define SPARSE_H_
+
+#include "meabo.h"
+#include "memory.h"
+
+/*
+ * Sparse matrix storage for Phase 6.
+ *
+ * The matrix is always generated in CSR (compressed sparse row) format, with
+ * all rows stored in two contiguous arrays. It can then be converted into:
+ * - SELL-C-sigma: rows are sorted by length within windows of sigma rows,
+ *   grouped into chunks of C rows and each chunk is padded to its longest row
+ *   and stored column-major, so that C rows are processed per SIMD lane group;
+ * - blocked ELL: the matrix is divided into BxB dense blocks and every block
+ *   row stores the same number of blocks (padded with empty blocks).
+ */
+typedef enum sparse_format {
+  SPARSE_CSR = 0,
+  SPARSE_SELL,
+  SPARSE_BELL
+} sparse_format;
+
+#define SPARSE_DEFAULT_CHUNK 8
+#define SPARSE_DEFAULT_SIGMA 128
+#define SPARSE_DEFAULT_BLOCK 4
+
+typedef struct sparse_format_spec {
+  sparse_format format;
+  int chunk_size;   /* SELL: C */
+  int sigma;        /* SELL: sorting window, in rows */
+  int block_size;   /* Blocked ELL: B */
+} sparse_format_spec;
+
+typedef struct sparse_matrix {
+  sparse_format_spec spec;
+  mem_policy mem;
+  int nrow;
+  int ncol;
+  long nnz;
+  /* Number of stored values, including padding. */
+  long stored;
+
+  /* CSR */
+  long *row_ptr;
+  int *col_idx;
+  double *values;
+
+  /* SELL-C-sigma */
+  int num_chunks;
+  long *chunk_ptr;
+  int *chunk_len;
+  int *row_perm;
+  int *sell_cols;
+  double *sell_values;
+
+  /* Blocked ELL */
+  int num_block_rows;
+  int ell_width;
+  int *bell_cols;
+  double *bell_values;
+} sparse_matrix;
+
+int parse_sparse_format(const char *str, sparse_format_spec *spec);
+
+const char* sparse_format_name(const sparse_format format);
+
+sparse_matrix* sparse_alloc(const int nrow, const int ncol,
+                            const sparse_format_spec *spec,
+                            const mem_policy *policy);
+
+void sparse_alloc_csr(sparse_matrix *matrix);
+
+void sparse_convert(sparse_matrix *matrix);
+
+void sparse_free(sparse_matrix *matrix);
+
+void sparse_count_pages(const sparse_matrix *matrix, mem_stats *stats);
+
+void sparse_print_info(const sparse_matrix *matrix);
+
+#endif /* SPARSE_H_ */
@@ -0,0 +1,518 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "sparse_gen.h"
+#include "rng.h"
+#include <ctype.h>
+
+#define MTX_LINE_LEN 1024
+
+typedef struct sparse_entry {
+  int col;
+  double value;
+} sparse_entry;
+
+static int compare_entry(const void *a, const void *b) {
+  return ((const sparse_entry*) a)->col - ((const sparse_entry*) b)->col;
+}
+
+static int compare_int(const void *a, const void *b) {
+  return *(const int*) a - *(const int*) b;
+}
+
+/*
+ * Parses the number after the colon of param, an integer or not, or takes
+ * dflt without param. Returns 0 on success.
+ */
+static int parse_param(const char *param, const int integer,
+                       const double dflt, double *value) {
+  char *end;
+  if (param == NULL) {
+    *value = dflt;
+    return 0;
+  }
+  *value = integer ? strtol(param + 1, &end, 10) : strtod(param + 1, &end);
+  return (end == param + 1 || *end) ? -1 : 0;
+}
+
+/*
+ * Parses a generator of the form <name>[:<param>]. Returns 0 on success.
+ */
+int parse_sparse_generator(const char *str, sparse_generator *gen) {
+  char name[32] = "";
+  const char *param = strchr(str, ':');
+
+  gen->path = NULL;
+  sscanf(str, "%31[a-z0-9]", name);
+  if (!strcmp(name, "random")) {
+    gen->type = SPARSE_GEN_RANDOM;
+    gen->param = 0;
+  } else if (!strcmp(name, "banded")) {
+    gen->type = SPARSE_GEN_BANDED;
+    if (parse_param(param, 1, SPARSE_GEN_DEFAULT_BAND, &gen->param) ||
+        gen->param < 0) {
+      return -1;
+    }
+  } else if (!strcmp(name, "powerlaw")) {
+    gen->type = SPARSE_GEN_POWERLAW;
+    if (parse_param(param, 0, SPARSE_GEN_DEFAULT_ALPHA, &gen->param) ||
+        gen->param <= 1.0) {
+      return -1;
+    }
+  } else if (!strcmp(name, "stencil2d")) {
+    gen->type = SPARSE_GEN_STENCIL2D;
+    gen->param = 0;
+  } else if (!strcmp(name, "stencil3d")) {
+    gen->type = SPARSE_GEN_STENCIL3D;
+    gen->param = 0;
+  } else if (!strcmp(name, "blockdiag")) {
+    gen->type = SPARSE_GEN_BLOCKDIAG;
+    if (parse_param(param, 1, SPARSE_GEN_DEFAULT_BLOCK, &gen->param) ||
+        gen->param < 1) {
+      return -1;
+    }
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+const char* sparse_generator_name(const sparse_gen_type type) {
+  switch (type) {
+    case SPARSE_GEN_BANDED:
+      return "banded";
+    case SPARSE_GEN_POWERLAW:
+      return "powerlaw";
+    case SPARSE_GEN_STENCIL2D:
+      return "stencil2d";
+    case SPARSE_GEN_STENCIL3D:
+      return "stencil3d";
+    case SPARSE_GEN_BLOCKDIAG:
+      return "blockdiag";
+    case SPARSE_GEN_MTX:
+      return "Matrix Market";
+    default:
+      return "random";
+  }
+}
+
+/*
+ * Matrix Market header. Only sparse (coordinate) matrices of real, integer
+ * or pattern type are supported; symmetric and skew-symmetric matrices are
+ * expanded to general ones.
+ */
+typedef struct mtx_header {
+  int pattern;
+  int symmetric;
+  int skew;
+  int nrow;
+  int ncol;
+  long entries;
+  long line;        /* number of the last line read */
+} mtx_header;
+
+/* Comment and blank lines, which the reader skips wherever they are. */
+static int mtx_skipped(const char *line) {
+  if (line[0] == '%') {
+    return 1;
+  }
+  while (isspace((unsigned char) *line)) {
+    ++line;
+  }
+  return *line == '\0';
+}
+
+static FILE* mtx_open(const char *path, mtx_header *header) {
+  char line[MTX_LINE_LEN], object[32], format[32], field[32], symmetry[32];
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    perror(path);
+    return NULL;
+  }
+
+  header->line = 1;
+  if (fgets(line, sizeof(line), file) == NULL ||
+      sscanf(line, "%%%%MatrixMarket %31s %31s %31s %31s", object, format,
+             field, symmetry) != 4 ||
+      strcmp(object, "matrix") || strcmp(format, "coordinate") ||
+      !(strcmp(field, "real") == 0 || strcmp(field, "integer") == 0 ||
+        strcmp(field, "pattern") == 0)) {
+    printf("%s: unsupported Matrix Market header %s", path, line);
+    fclose(file);
+    return NULL;
+  }
+  header->pattern = !strcmp(field, "pattern");
+  header->skew = !strcmp(symmetry, "skew-symmetric");
+  header->symmetric = header->skew || !strcmp(symmetry, "symmetric");
+
+  do {
+    if (fgets(line, sizeof(line), file) == NULL) {
+      printf("%s: missing Matrix Market size line\n", path);
+      fclose(file);
+      return NULL;
+    }
+    ++header->line;
+  } while (mtx_skipped(line));
+
+  if (sscanf(line, "%d %d %ld", &header->nrow, &header->ncol,
+             &header->entries) != 3) {
+    printf("%s: invalid Matrix Market size line %ld: %s", path,
+           header->line, line);
+    fclose(file);
+    return NULL;
+  }
+  return file;
+}
+
+/*
+ * Reads the next entry, converting indices to 0-based. Returns 0 at the end
+ * of the file, or -1 after printing an error if a field of the entry is
+ * missing or not a number.
+ */
+static int mtx_next(FILE *file, mtx_header *header, const char *path,
+                    int *row, int *col, double *value) {
+  char line[MTX_LINE_LEN];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    char *start = line, *end;
+    ++header->line;
+    if (mtx_skipped(line)) {
+      continue;
+    }
+    *row = strtol(start, &end, 10) - 1;
+    if (end != start) {
+      *col = strtol(start = end, &end, 10) - 1;
+    }
+    *value = 1.0;
+    if (end != start && !header->pattern) {
+      *value = strtod(start = end, &end);
+    }
+    if (end == start) {
+      printf("%s: invalid Matrix Market entry at line %ld: %s", path,
+             header->line, line);
+      return -1;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * Goes back to the first entry: skips the banner, the comments, the blank
+ * lines and the size line.
+ */
+static void mtx_rewind(FILE *file, mtx_header *header) {
+  char line[MTX_LINE_LEN];
+  rewind(file);
+  header->line = 0;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    ++header->line;
+    if (!mtx_skipped(line)) {
+      break;
+    }
+  }
+}
+
+/*
+ * Adjusts the matrix size to the generator: Matrix Market files carry their
+ * own size and stencil matrices are square. Returns 0 on success.
+ */
+int sparse_gen_matrix_size(const sparse_generator *gen, int *nrow,
+                           int *ncol) {
+  if (gen->type == SPARSE_GEN_MTX) {
+    mtx_header header;
+    FILE *file = mtx_open(gen->path, &header);
+    if (file == NULL) {
+      return -1;
+    }
+    fclose(file);
+    *nrow = header.nrow;
+    *ncol = header.ncol;
+  } else if (gen->type == SPARSE_GEN_STENCIL2D ||
+             gen->type == SPARSE_GEN_STENCIL3D) {
+    *ncol = *nrow;
+  }
+  return 0;
+}
+
+/*
+ * Grid sizes for the stencils: nx * ny (* nz) covers at least nrow points.
+ */
+static int stencil_nx(const sparse_generator *gen, const int nrow) {
+  if (gen->type == SPARSE_GEN_STENCIL3D) {
+    return (int) ceil(cbrt((double) nrow));
+  }
+  return (int) ceil(sqrt((double) nrow));
+}
+
+/*
+ * Column indices of row i for the structured generators, in ascending order.
+ * Returns the row length; cols may be NULL to only get the length.
+ */
+static long structured_row(const sparse_matrix *matrix,
+                           const sparse_generator *gen, const int i,
+                           int *cols) {
+  const int nrow = matrix->nrow, ncol = matrix->ncol;
+  long len = 0;
+  switch (gen->type) {
+    case SPARSE_GEN_BANDED: {
+      const long w = (long) gen->param;
+      const long center = (long) i * ncol / nrow;
+      for (long c = center - w; c <= center + w; ++c) {
+        if (c >= 0 && c < ncol) {
+          if (cols) {
+            cols[len] = c;
+          }
+          ++len;
+        }
+      }
+      break;
+    }
+    case SPARSE_GEN_BLOCKDIAG: {
+      const long b = (long) gen->param;
+      const long first = (long) i / b * b;
+      for (long c = first; c < first + b && c < ncol; ++c) {
+        if (cols) {
+          cols[len] = c;
+        }
+        ++len;
+      }
+      break;
+    }
+    case SPARSE_GEN_STENCIL2D:
+    case SPARSE_GEN_STENCIL3D: {
+      const long nx = stencil_nx(gen, nrow);
+      const long plane = (gen->type == SPARSE_GEN_STENCIL3D) ? nx * nx : 0;
+      const long x = i % nx, y = (i / nx) % nx;
+      const long neighbours[7] = {
+        plane ? i - plane : -1,
+        (plane ? y > 0 : i >= nx) ? i - nx : -1,
+        x > 0 ? i - 1 : -1,
+        i,
+        x < nx - 1 ? i + 1 : -1,
+        (plane ? y < nx - 1 : 1) ? i + nx : -1,
+        plane ? i + plane : -1
+      };
+      for (int k = 0; k < 7; ++k) {
+        if (neighbours[k] >= 0 && neighbours[k] < ncol) {
+          if (cols) {
+            cols[len] = neighbours[k];
+          }
+          ++len;
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return len;
+}
+
+/*
+ * Row length for the random generators. Row i owns the counters
+ * [i << 32, (i + 1) << 32) of the stream.
+ */
+static long random_row_len(const sparse_matrix *matrix,
+                           const sparse_generator *gen, const int i) {
+  const uint64_t r = rng_hash(RNG_SPARSE, (uint64_t) i << 32);
+  if (gen->type == SPARSE_GEN_POWERLAW) {
+    /* Inverse transform sampling of a Pareto distribution. */
+    const double u = ((r >> 11) + 1) * (1.0 / 9007199254740992.0);
+    const double len = SPARSE_GEN_POWERLAW_MIN *
+                       pow(u, -1.0 / (gen->param - 1.0));
+    return (len < matrix->ncol) ? (long) len : matrix->ncol;
+  }
+  return r % matrix->ncol;
+}
+
+/*
+ * Draws len distinct random columns with Robert Floyd's sampling algorithm,
+ * which needs exactly len draws, then sorts them. taken is a zeroed bitmap of
+ * ncol bits, and is left zeroed.
+ */
+static void random_row(const sparse_matrix *matrix, const int i,
+                       const long len, int *cols, unsigned int *taken) {
+  const int ncol = matrix->ncol;
+  uint64_t counter = ((uint64_t) i << 32) + 1;
+  long k = 0;
+  for (long j = ncol - len; j < ncol; ++j) {
+    int col = rng_hash(RNG_SPARSE, counter++) % (j + 1);
+    if (taken[col / 32] & (1U << (col % 32))) {
+      col = j;
+    }
+    taken[col / 32] |= 1U << (col % 32);
+    cols[k++] = col;
+  }
+  for (long j = 0; j < len; ++j) {
+    taken[cols[j] / 32] = 0;
+  }
+  qsort(cols, len, sizeof(int), compare_int);
+}
+
+/*
+ * Streams a Matrix Market file into the CSR arrays: one pass to count the
+ * row lengths, then a second pass to fill the rows. Must be called by all
+ * threads of a parallel region; the file is read by one thread, but the rows
+ * are first touched and sorted by the threads that will process them.
+ */
+static void mtx_generate(sparse_matrix *matrix, const sparse_generator *gen) {
+  /* Shared by all threads of the team. */
+  static FILE *file;
+  static mtx_header header;
+  static long *fill;
+  long num_read = 0;
+  int row, col, status;
+  double value;
+
+  #pragma omp single
+  {
+    file = mtx_open(gen->path, &header);
+    if (file == NULL || header.nrow != matrix->nrow ||
+        header.ncol != matrix->ncol) {
+      printf("Unable to read %s\n", gen->path);
+      exit(1);
+    }
+    while ((status = mtx_next(file, &header, gen->path, &row, &col,
+                              &value)) > 0) {
+      if (row < 0 || row >= header.nrow || col < 0 || col >= header.ncol ||
+          (header.symmetric && col >= header.nrow)) {
+        printf("%s: entry (%d, %d) out of range at line %ld\n", gen->path,
+               row + 1, col + 1, header.line);
+        exit(1);
+      }
+      ++matrix->row_ptr[row + 1];
+      if (header.symmetric && row != col) {
+        ++matrix->row_ptr[col + 1];
+      }
+      ++num_read;
+    }
+    if (status < 0) {
+      exit(1);
+    }
+    if (num_read != header.entries) {
+      printf("%s: %ld entries instead of the %ld of the size line\n",
+             gen->path, num_read, header.entries);
+      exit(1);
+    }
+    sparse_alloc_csr(matrix);
+  }
+
+  #pragma omp for schedule(static)
+  for (int i = 0; i < matrix->nrow; ++i) {
+    const long first = matrix->row_ptr[i], last = matrix->row_ptr[i + 1];
+    memset(matrix->col_idx + first, 0, sizeof(int) * (last - first));
+    memset(matrix->values + first, 0, sizeof(double) * (last - first));
+  }
+
+  #pragma omp single
+  {
+    fill = malloc(sizeof(long) * matrix->nrow);
+    memcpy(fill, matrix->row_ptr, sizeof(long) * matrix->nrow);
+    mtx_rewind(file, &header);
+    while (mtx_next(file, &header, gen->path, &row, &col, &value) > 0) {
+      matrix->col_idx[fill[row]] = col;
+      matrix->values[fill[row]++] = value;
+      if (header.symmetric && row != col) {
+        matrix->col_idx[fill[col]] = row;
+        matrix->values[fill[col]++] = header.skew ? -value : value;
+      }
+    }
+    fclose(file);
+    free(fill);
+  }
+
+  #pragma omp for schedule(static)
+  for (int i = 0; i < matrix->nrow; ++i) {
+    const long first = matrix->row_ptr[i];
+    const long len = matrix->row_ptr[i + 1] - first;
+    sparse_entry *entries = malloc(sizeof(sparse_entry) * len);
+    for (long j = 0; j < len; ++j) {
+      entries[j].col = matrix->col_idx[first + j];
+      entries[j].value = matrix->values[first + j];
+    }
+    qsort(entries, len, sizeof(sparse_entry), compare_entry);
+    for (long j = 0; j < len; ++j) {
+      matrix->col_idx[first + j] = entries[j].col;
+      matrix->values[first + j] = entries[j].value;
+    }
+    free(entries);
+  }
+}
+
+/*
+ * Fills the CSR arrays of matrix (allocated with sparse_alloc) with the
+ * pattern of gen. Must be called by all threads of a parallel region: rows
+ * are generated with the static schedule of Phase 6, so they are first
+ * touched by the threads that will process them.
+ */
+void sparse_generate(sparse_matrix *matrix, const sparse_generator *gen) {
+  const int nrow = matrix->nrow;
+  const int random = (gen->type == SPARSE_GEN_RANDOM ||
+                      gen->type == SPARSE_GEN_POWERLAW);
+
+  if (gen->type == SPARSE_GEN_MTX) {
+    mtx_generate(matrix, gen);
+    return;
+  }
+
+  #pragma omp for schedule(static)
+  for (int i = 0; i < nrow; ++i) {
+    matrix->row_ptr[i + 1] = random ? random_row_len(matrix, gen, i) :
+                                      structured_row(matrix, gen, i, NULL);
+  }
+
+  #pragma omp single
+  {
+    sparse_alloc_csr(matrix);
+  }
+
+  unsigned int *taken = NULL;
+  if (random) {
+    taken = calloc((matrix->ncol + 31) / 32, sizeof(unsigned int));
+  }
+
+  #pragma omp for schedule(static)
+  for (int i = 0; i < nrow; ++i) {
+    const long first = matrix->row_ptr[i];
+    const long len = matrix->row_ptr[i + 1] - first;
+    int * restrict cols = matrix->col_idx + first;
+    double * restrict values = matrix->values + first;
+
+    if (random) {
+      random_row(matrix, i, len, cols, taken);
+    } else {
+      structured_row(matrix, gen, i, cols);
+    }
+
+    if (gen->type == SPARSE_GEN_STENCIL2D ||
+        gen->type == SPARSE_GEN_STENCIL3D) {
+      for (long j = 0; j < len; ++j) {
+        values[j] = (cols[j] == i) ? len - 1.0 : -1.0;
+      }
+    } else {
+      for (long j = 0; j < len; ++j) {
+        uint64_t r = rng_hash(RNG_SPARSE_VALUES, first + j);
+        values[j] = (rng_lo(r) % 1024) * cos(rng_hi(r) % 1024);
+      }
+    }
+  }
+
+  free(taken);
+}
@@ -0,0 +1,68 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef SPARSE_GEN_H_
+#define SPARSE_GEN_H_
+
+#include "sparse.h"
+
+/*
+ * Sparsity patterns for the Phase 6 matrix:
+ * - random: rand() % ncol nonzeros per row at random columns (the original
+ *   Meabo matrix, half-dense on average);
+ * - banded[:w]: nonzeros within w columns of the (scaled) diagonal;
+ * - powerlaw[:alpha]: Pareto-distributed row lengths with exponent alpha,
+ *   at random columns (as found in graphs and web matrices);
+ * - stencil2d, stencil3d: 5-point and 7-point Laplacian on a square or
+ *   cubic grid of nrow points (the matrix is made square);
+ * - blockdiag[:b]: dense bxb blocks along the diagonal;
+ * - mtx: a matrix read from a Matrix Market (.mtx) coordinate file.
+ * All row column indices are sorted in ascending order.
+ */
+typedef enum sparse_gen_type {
+  SPARSE_GEN_RANDOM = 0,
+  SPARSE_GEN_BANDED,
+  SPARSE_GEN_POWERLAW,
+  SPARSE_GEN_STENCIL2D,
+  SPARSE_GEN_STENCIL3D,
+  SPARSE_GEN_BLOCKDIAG,
+  SPARSE_GEN_MTX
+} sparse_gen_type;
+
+#define SPARSE_GEN_DEFAULT_BAND 8
+#define SPARSE_GEN_DEFAULT_ALPHA 2.0
+#define SPARSE_GEN_POWERLAW_MIN 4
+#define SPARSE_GEN_DEFAULT_BLOCK 64
+
+typedef struct sparse_generator {
+  sparse_gen_type type;
+  double param;
+  const char *path;
+} sparse_generator;
+
+int parse_sparse_generator(const char *str, sparse_generator *gen);
+
+const char* sparse_generator_name(const sparse_gen_type type);
+
+int sparse_gen_matrix_size(const sparse_generator *gen, int *nrow, int *ncol);
+
+void sparse_generate(sparse_matrix *matrix, const sparse_generator *gen);
+
+#endif /* SPARSE_GEN_H_ */
@@ -0,0 +1,103 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "stats.h"
+
+/* Two-sided 95% quantiles of Student's t distribution, by degrees of freedom */
+static const double t95[] = {
+  12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+  2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+  2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static int compare_doubles(const void *p1, const void *p2) {
+  const double d1 = *(const double *) p1, d2 = *(const double *) p2;
+  return (d1 > d2) - (d1 < d2);
+}
+
+/* Quantile q of sorted values, interpolated between the closest ranks */
+static double quantile(const double *sorted, const int n, const double q) {
+  const double rank = q * (n - 1);
+  const int low = (int) rank;
+  if (low + 1 >= n) {
+    return sorted[n - 1];
+  }
+  return sorted[low] + (rank - low) * (sorted[low + 1] - sorted[low]);
+}
+
+void run_stats_compute(const unsigned long long *durations, const int runs,
+    run_stats *stats) {
+  double *sorted = malloc(sizeof(double) * runs);
+  double sum = 0, squares = 0;
+  memset(stats, 0, sizeof(run_stats));
+  stats->runs = runs;
+  if (runs < 1) {
+    free(sorted);
+    return;
+  }
+  for (int r = 0; r < runs; ++r) {
+    sorted[r] = durations[r];
+    sum += sorted[r];
+  }
+  qsort(sorted, runs, sizeof(double), compare_doubles);
+  stats->mean = sum / runs;
+  for (int r = 0; r < runs; ++r) {
+    squares += (sorted[r] - stats->mean) * (sorted[r] - stats->mean);
+  }
+  stats->median = quantile(sorted, runs, 0.5);
+  stats->min = sorted[0];
+  stats->max = sorted[runs - 1];
+  if (runs > 1) {
+    const int dof = runs - 1;
+    const double t = (dof <= (int) (sizeof(t95) / sizeof(t95[0]))) ?
+                     t95[dof - 1] : 1.96;
+    stats->stddev = sqrt(squares / dof);
+    stats->ci95 = t * stats->stddev / sqrt(runs);
+  }
+  if (runs >= 4) {
+    const double q1 = quantile(sorted, runs, 0.25);
+    const double q3 = quantile(sorted, runs, 0.75);
+    for (int r = 0; r < runs; ++r) {
+      stats->outliers += (sorted[r] < q1 - 1.5 * (q3 - q1) ||
+                          sorted[r] > q3 + 1.5 * (q3 - q1));
+    }
+  }
+  free(sorted);
+}
+
+/*
+ * Whether the confidence interval of the mean is within max_ci_percent of
+ * the mean, after at least STATS_MIN_RUNS runs.
+ */
+int run_stats_stable(const run_stats *stats, const double max_ci_percent) {
+  return stats->runs >= STATS_MIN_RUNS &&
+         stats->ci95 <= max_ci_percent / 100 * stats->mean;
+}
+
+void run_stats_print(const int phase, const run_stats *stats) {
+  const double mean = stats->mean ? stats->mean : 1;
+  printf("Phase %d statistics over %d runs (ns): mean %.0f, median %.0f, "
+         "stddev %.0f (%.2f%%), min %.0f, max %.0f\n", phase, stats->runs,
+         stats->mean, stats->median, stats->stddev,
+         100 * stats->stddev / mean, stats->min, stats->max);
+  printf("Phase %d mean 95%% confidence interval: +/- %.0f ns (%.2f%%), "
+         "%d outlier%s\n", phase, stats->ci95, 100 * stats->ci95 / mean,
+         stats->outliers, (stats->outliers == 1) ? "" : "s");
+}
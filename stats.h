@@ -0,0 +1,53 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include "meabo.h"
+
+/*
+ * Statistics of the durations of the measured runs of a step: the 95%
+ * confidence interval of the mean is +/- ci95 (Student's t), and outliers
+ * are the runs beyond the Tukey fences (1.5 interquartile ranges outside the
+ * quartiles).
+ */
+typedef struct run_stats {
+  int runs;
+  double mean;
+  double median;
+  double stddev;
+  double min;
+  double max;
+  double ci95;
+  int outliers;
+} run_stats;
+
+/* Runs before a step can be stable (see run_stats_stable) */
+#define STATS_MIN_RUNS 3
+
+void run_stats_compute(const unsigned long long *durations, const int runs,
+    run_stats *stats);
+
+int run_stats_stable(const run_stats *stats, const double max_ci_percent);
+
+void run_stats_print(const int phase, const run_stats *stats);
+
+#endif /* STATS_H_ */
@@ -0,0 +1,571 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#include "topology.h"
+#include <dirent.h>
+#include <stddef.h>
+
+/* CPUs the phases can run on, and their topology */
+static int max_cpus = 0;
+static size_t set_size = 0;
+static cpu_set_t *all_cpus = NULL;
+static cpu_info *cpus = NULL;
+static int num_nodes = 0;
+
+/*
+ * CPUs of all_cpus in the order of each placement policy, and for the scatter
+ * order, rank of the core of each CPU within its NUMA node.
+ */
+static int num_ordered = 0;
+static int *orders[PLACEMENT_SCATTER + 1];
+static int *core_rank = NULL;
+static placement current_placement = PLACEMENT_LINEAR;
+
+static long read_long(const char *path) {
+  long value = -1;
+  FILE *file = fopen(path, "r");
+  if (file) {
+    if (fscanf(file, "%ld", &value) != 1) {
+      value = -1;
+    }
+    fclose(file);
+  }
+  return value;
+}
+
+static long cpu_attribute(const int cpu, const char *name) {
+  char path[256];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", cpu, name);
+  return read_long(path);
+}
+
+/*
+ * Reads a cpulist file of sysfs into set (if not NULL). Returns the first
+ * CPU of the list, or -1.
+ */
+static int read_cpulist(const char *path, cpu_set_t *set) {
+  char list[4096], *saveptr, *item;
+  int first_cpu = -1;
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return -1;
+  }
+  if (!fgets(list, sizeof(list), file)) {
+    list[0] = 0;
+  }
+  fclose(file);
+  for (item = strtok_r(list, ",\n", &saveptr); item;
+       item = strtok_r(NULL, ",\n", &saveptr)) {
+    int first, last;
+    const int read = sscanf(item, "%d-%d", &first, &last);
+    if (read < 1) {
+      continue;
+    }
+    if (read == 1) {
+      last = first;
+    }
+    if (first_cpu == -1 || first < first_cpu) {
+      first_cpu = first;
+    }
+    for (int i = first; set && i <= last && i < max_cpus; ++i) {
+      CPU_SET_S(i, set_size, set);
+    }
+  }
+  return first_cpu;
+}
+
+/* First CPU sharing the cache of the highest level with cpu, or -1. */
+static int last_level_cache(const int cpu) {
+  char path[256];
+  long level, max_level = 0;
+  int llc = -1;
+  for (int index = 0; ; ++index) {
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+    if ((level = read_long(path)) < 0) {
+      break;
+    }
+    if (level > max_level) {
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/"
+               "index%d/shared_cpu_list", cpu, index);
+      max_level = level;
+      llc = read_cpulist(path, NULL);
+    }
+  }
+  return llc;
+}
+
+/* NUMA node, or package without NUMA, of the CPU: what scatter spreads on */
+static int cpu_domain(const int cpu) {
+  return (cpus[cpu].node >= 0) ? cpus[cpu].node :
+         (cpus[cpu].package >= 0) ? cpus[cpu].package : 0;
+}
+
+static int compare_ids(const int id1, const int id2) {
+  return (id1 > id2) - (id1 < id2);
+}
+
+static int compare_compact(const void *p1, const void *p2) {
+  const cpu_info *c1 = &cpus[*(const int *) p1];
+  const cpu_info *c2 = &cpus[*(const int *) p2];
+  int cmp;
+  if ((cmp = compare_ids(c1->package, c2->package)) ||
+      (cmp = compare_ids(c1->node, c2->node)) ||
+      (cmp = compare_ids(c1->llc, c2->llc)) ||
+      (cmp = compare_ids(c1->core, c2->core)) ||
+      (cmp = compare_ids(c1->smt, c2->smt))) {
+    return cmp;
+  }
+  return compare_ids(*(const int *) p1, *(const int *) p2);
+}
+
+static int compare_scatter(const void *p1, const void *p2) {
+  const int cpu1 = *(const int *) p1, cpu2 = *(const int *) p2;
+  int cmp;
+  if ((cmp = compare_ids(cpus[cpu1].smt, cpus[cpu2].smt)) ||
+      (cmp = compare_ids(core_rank[cpu1], core_rank[cpu2])) ||
+      (cmp = compare_ids(cpu_domain(cpu1), cpu_domain(cpu2)))) {
+    return cmp;
+  }
+  return compare_ids(cpu1, cpu2);
+}
+
+/*
+ * Reads the topology of the CPUs of cpu_set, numbered below max_cpus, and
+ * sorts them for each placement policy.
+ */
+void topology_init(const cpu_set_t *cpu_set, const int num_cpus) {
+  char path[256];
+  max_cpus = num_cpus;
+  set_size = CPU_ALLOC_SIZE(max_cpus);
+  all_cpus = CPU_ALLOC(max_cpus);
+  memcpy(all_cpus, cpu_set, set_size);
+  cpus = malloc(sizeof(cpu_info) * max_cpus);
+
+  for (int i = 0; i < max_cpus; ++i) {
+    cpu_info *cpu = &cpus[i];
+    cpu_set_t *siblings = CPU_ALLOC(max_cpus);
+    CPU_ZERO_S(set_size, siblings);
+    cpu->package = cpu_attribute(i, "topology/physical_package_id");
+    cpu->cluster = cpu_attribute(i, "topology/cluster_id");
+    cpu->capacity = cpu_attribute(i, "cpu_capacity");
+    if (cpu->capacity < 0) {
+      cpu->capacity = 0;
+    }
+    cpu->node = -1;
+    cpu->llc = last_level_cache(i);
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", i);
+    cpu->core = read_cpulist(path, siblings);
+    cpu->smt = 0;
+    if (cpu->core < 0) {
+      cpu->core = i;
+    }
+    for (int j = 0; j < i; ++j) {
+      cpu->smt += CPU_ISSET_S(j, set_size, siblings) ? 1 : 0;
+    }
+    CPU_FREE(siblings);
+  }
+
+  DIR *dir = opendir("/sys/devices/system/node");
+  if (dir) {
+    struct dirent *entry;
+    cpu_set_t *node_cpus = CPU_ALLOC(max_cpus);
+    while ((entry = readdir(dir))) {
+      int node;
+      char end;
+      if (sscanf(entry->d_name, "node%d%c", &node, &end) != 1) {
+        continue;
+      }
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+               node);
+      CPU_ZERO_S(set_size, node_cpus);
+      read_cpulist(path, node_cpus);
+      for (int i = 0; i < max_cpus; ++i) {
+        if (CPU_ISSET_S(i, set_size, node_cpus)) {
+          cpus[i].node = node;
+        }
+      }
+      if (node >= num_nodes) {
+        num_nodes = node + 1;
+      }
+    }
+    CPU_FREE(node_cpus);
+    closedir(dir);
+  }
+
+  /* Cores are ranked within their domain in the order of their first CPU */
+  int *next_rank = calloc(max_cpus + 1, sizeof(int));
+  int *rank_of_core = malloc(sizeof(int) * max_cpus);
+  core_rank = malloc(sizeof(int) * max_cpus);
+  for (int i = 0; i < max_cpus; ++i) {
+    rank_of_core[i] = -1;
+  }
+  for (int i = 0; i < max_cpus; ++i) {
+    if (!CPU_ISSET_S(i, set_size, all_cpus)) {
+      continue;
+    }
+    int domain = cpu_domain(i);
+    if (domain < 0 || domain > max_cpus) {
+      domain = max_cpus;
+    }
+    if (rank_of_core[cpus[i].core] < 0) {
+      rank_of_core[cpus[i].core] = next_rank[domain]++;
+    }
+    core_rank[i] = rank_of_core[cpus[i].core];
+  }
+  free(rank_of_core);
+  free(next_rank);
+
+  for (int p = PLACEMENT_LINEAR; p <= PLACEMENT_SCATTER; ++p) {
+    orders[p] = malloc(sizeof(int) * max_cpus);
+    num_ordered = 0;
+    for (int i = 0; i < max_cpus; ++i) {
+      if (CPU_ISSET_S(i, set_size, all_cpus)) {
+        orders[p][num_ordered++] = i;
+      }
+    }
+  }
+  qsort(orders[PLACEMENT_COMPACT], num_ordered, sizeof(int), compare_compact);
+  qsort(orders[PLACEMENT_SCATTER], num_ordered, sizeof(int), compare_scatter);
+}
+
+/* Number of different values of an id over the CPUs (unknown ids ignored) */
+static int count_ids(const size_t offset) {
+  int count = 0;
+  for (int i = 0; i < num_ordered; ++i) {
+    const int cpu = orders[PLACEMENT_LINEAR][i];
+    const int id = *(const int *) ((const char *) &cpus[cpu] + offset);
+    int seen = (id < 0);
+    for (int j = 0; j < i && !seen; ++j) {
+      const int other = orders[PLACEMENT_LINEAR][j];
+      seen = (*(const int *) ((const char *) &cpus[other] + offset) == id);
+    }
+    count += !seen;
+  }
+  return count;
+}
+
+void topology_print(void) {
+  long min_capacity = 0, max_capacity = 0;
+  char path[256], distances[1024];
+  for (int i = 0; i < num_ordered; ++i) {
+    const long capacity = cpus[orders[PLACEMENT_LINEAR][i]].capacity;
+    if (capacity && (!min_capacity || capacity < min_capacity)) {
+      min_capacity = capacity;
+    }
+    if (capacity > max_capacity) {
+      max_capacity = capacity;
+    }
+  }
+  printf("Topology %d packages, %d clusters, %d NUMA nodes, %d last level "
+         "caches, %d cores, %d CPUs", count_ids(offsetof(cpu_info, package)),
+         count_ids(offsetof(cpu_info, cluster)),
+         count_ids(offsetof(cpu_info, node)),
+         count_ids(offsetof(cpu_info, llc)),
+         count_ids(offsetof(cpu_info, core)), num_ordered);
+  if (min_capacity < max_capacity) {
+    printf(" (capacities %ld to %ld)", min_capacity, max_capacity);
+  }
+  printf("\n");
+  for (int node = 0; node < num_nodes && num_nodes > 1; ++node) {
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/distance",
+             node);
+    FILE *file = fopen(path, "r");
+    if (file && fgets(distances, sizeof(distances), file)) {
+      distances[strcspn(distances, "\n")] = 0;
+      printf("NUMA node %d distances %s\n", node, distances);
+    }
+    if (file) {
+      fclose(file);
+    }
+  }
+}
+
+static int name_id(const char *name, const char *prefix, long *id) {
+  const size_t len = strlen(prefix);
+  char *end;
+  if (strncmp(name, prefix, len)) {
+    return 0;
+  }
+  *id = strtol(name + len, &end, 10);
+  return end != name + len && !*end;
+}
+
+/*
+ * Adds the CPUs of a topology name to set, among the CPUs the phases can run
+ * on:
+ * - node<N>, package<N>, cluster<N>: the CPUs of NUMA node, package (socket)
+ *   or cluster N;
+ * - llc<N>: the CPUs sharing the N-th last level cache;
+ * - big, little: the CPUs with the highest capacity, or a lower one (ARM
+ *   big.LITTLE and DynamIQ systems);
+ * - one-per-core: the first hardware thread of each core;
+ * - smt-siblings: the other hardware threads of each core.
+ * Returns 0, -1 if no CPU matches, or 1 if name is not a topology name.
+ */
+int topology_cpus(const char *name, cpu_set_t *set) {
+  long id = 0, max_capacity = 0;
+  int found = 0, llc_first = -1;
+  enum { NODE, PACKAGE, CLUSTER, LLC, BIG, LITTLE, FIRST, SIBLINGS } kind;
+  if (name_id(name, "node", &id)) {
+    kind = NODE;
+  } else if (name_id(name, "package", &id)) {
+    kind = PACKAGE;
+  } else if (name_id(name, "cluster", &id)) {
+    kind = CLUSTER;
+  } else if (name_id(name, "llc", &id)) {
+    kind = LLC;
+  } else if (!strcmp(name, "big")) {
+    kind = BIG;
+  } else if (!strcmp(name, "little")) {
+    kind = LITTLE;
+  } else if (!strcmp(name, "one-per-core")) {
+    kind = FIRST;
+  } else if (!strcmp(name, "smt-siblings")) {
+    kind = SIBLINGS;
+  } else {
+    return 1;
+  }
+
+  for (int i = 0; i < num_ordered; ++i) {
+    const long capacity = cpus[orders[PLACEMENT_LINEAR][i]].capacity;
+    if (capacity > max_capacity) {
+      max_capacity = capacity;
+    }
+  }
+  /* LLCs are numbered in the order of their first CPU, which need not
+   * be the order their CPUs come in */
+  if (kind == LLC) {
+    int *distinct = malloc(sizeof(int) * (num_ordered > 0 ? num_ordered : 1));
+    int num_distinct = 0;
+    for (int i = 0; i < num_ordered; ++i) {
+      const int llc = cpus[orders[PLACEMENT_LINEAR][i]].llc;
+      int j = num_distinct;
+      if (llc < 0) {
+        continue;
+      }
+      while (j > 0 && distinct[j - 1] > llc) {
+        --j;
+      }
+      if (j > 0 && distinct[j - 1] == llc) {
+        continue;
+      }
+      memmove(&distinct[j + 1], &distinct[j],
+              sizeof(int) * (num_distinct - j));
+      distinct[j] = llc;
+      ++num_distinct;
+    }
+    if (id >= 0 && id < num_distinct) {
+      llc_first = distinct[id];
+    }
+    free(distinct);
+  }
+  for (int i = 0; i < num_ordered; ++i) {
+    const int cpu = orders[PLACEMENT_LINEAR][i];
+    const cpu_info *info = &cpus[cpu];
+    int match = 0, first_of_core = 1;
+    for (int j = 0; j < i && (kind == FIRST || kind == SIBLINGS); ++j) {
+      first_of_core &= (cpus[orders[PLACEMENT_LINEAR][j]].core != info->core);
+    }
+    switch (kind) {
+      case NODE:
+        match = (info->node == id);
+        break;
+      case PACKAGE:
+        match = (info->package == id);
+        break;
+      case CLUSTER:
+        match = (info->cluster == id);
+        break;
+      case LLC:
+        match = (info->llc >= 0 && info->llc == llc_first);
+        break;
+      case BIG:
+        match = (max_capacity && info->capacity == max_capacity);
+        break;
+      case LITTLE:
+        match = (info->capacity && info->capacity < max_capacity);
+        break;
+      case FIRST:
+        match = first_of_core;
+        break;
+      case SIBLINGS:
+        match = !first_of_core;
+        break;
+    }
+    if (match) {
+      CPU_SET_S(cpu, set_size, set);
+      found = 1;
+    }
+  }
+  if (!found) {
+    printf("No CPU for %s\n", name);
+    return -1;
+  }
+  return 0;
+}
+
+int parse_placement(const char *str, placement *policy) {
+  if (!strcmp(str, "linear")) {
+    *policy = PLACEMENT_LINEAR;
+  } else if (!strcmp(str, "compact")) {
+    *policy = PLACEMENT_COMPACT;
+  } else if (!strcmp(str, "scatter")) {
+    *policy = PLACEMENT_SCATTER;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+const char *placement_name(const placement policy) {
+  return (policy == PLACEMENT_COMPACT) ? "compact" :
+         (policy == PLACEMENT_SCATTER) ? "scatter" : "linear";
+}
+
+void topology_set_placement(const placement policy) {
+  current_placement = policy;
+}
+
+/*
+ * CPU of the index-th thread bound to one CPU of set (NULL: all the CPUs),
+ * in the order of the placement policy, or -1 if the set has fewer CPUs.
+ */
+int topology_cpu(const cpu_set_t *set, int index) {
+  const int *order = orders[current_placement];
+  for (int i = 0; i < num_ordered; ++i) {
+    if (!set || CPU_ISSET_S(order[i], set_size, set)) {
+      if (!index--) {
+        return order[i];
+      }
+    }
+  }
+  return -1;
+}
+
+/*
+ * Sets the bit of the NUMA node of each CPU of set (NULL: all the CPUs) in
+ * nodes, for the nodes below max_nodes. Returns the number of nodes set.
+ */
+int topology_nodes(const cpu_set_t *set, unsigned long *nodes,
+                   const int max_nodes) {
+  int count = 0;
+  for (int i = 0; i < num_ordered; ++i) {
+    const int cpu = orders[PLACEMENT_LINEAR][i];
+    const int node = cpus[cpu].node;
+    if ((!set || CPU_ISSET_S(cpu, set_size, set)) && node >= 0 &&
+        node < max_nodes && !(*nodes & (1UL << node))) {
+      *nodes |= 1UL << node;
+      ++count;
+    }
+  }
+  return count;
+}
+
+/* Size in bytes of a cache size file of sysfs (e.g. "48K"), or -1. */
+static long read_cache_size(const char *path) {
+  long size = -1;
+  char unit = 0;
+  FILE *file = fopen(path, "r");
+  if (file) {
+    if (fscanf(file, "%ld%c", &size, &unit) < 1) {
+      size = -1;
+    } else if (unit == 'K') {
+      size <<= 10;
+    } else if (unit == 'M') {
+      size <<= 20;
+    } else if (unit == 'G') {
+      size <<= 30;
+    }
+    fclose(file);
+  }
+  return size;
+}
+
+/*
+ * Total size in bytes of the data (or unified) caches of the given level
+ * used by the first num_threads CPUs of set (NULL: all the CPUs) in the
+ * placement order, each shared cache counted once, or 0 if unknown.
+ */
+long topology_cache_size(const cpu_set_t *set, const int num_threads,
+                         const int level) {
+  char path[256], type[32];
+  long total = 0;
+  int *counted = malloc(sizeof(int) * (num_threads > 0 ? num_threads : 1));
+  int num_counted = 0;
+  for (int t = 0; t < num_threads; ++t) {
+    const int cpu = topology_cpu(set, t);
+    if (cpu < 0) {
+      break;
+    }
+    for (int index = 0; ; ++index) {
+      long cache_level;
+      int first = -1, seen = 0;
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/"
+               "index%d/level", cpu, index);
+      if ((cache_level = read_long(path)) < 0) {
+        break;
+      }
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/"
+               "index%d/type", cpu, index);
+      FILE *file = fopen(path, "r");
+      if (!file || fscanf(file, "%31s", type) != 1) {
+        type[0] = 0;
+      }
+      if (file) {
+        fclose(file);
+      }
+      if (cache_level != level || !strcmp(type, "Instruction")) {
+        continue;
+      }
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/"
+               "index%d/shared_cpu_list", cpu, index);
+      first = read_cpulist(path, NULL);
+      for (int c = 0; c < num_counted && !seen; ++c) {
+        seen = (first >= 0 && counted[c] == first);
+      }
+      if (!seen) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/"
+                 "index%d/size", cpu, index);
+        const long size = read_cache_size(path);
+        if (size > 0) {
+          total += size;
+          counted[num_counted++] = first;
+        }
+      }
+    }
+  }
+  free(counted);
+  return total;
+}
+
+void topology_free(void) {
+  for (int p = PLACEMENT_LINEAR; p <= PLACEMENT_SCATTER; ++p) {
+    free(orders[p]);
+    orders[p] = NULL;
+  }
+  free(core_rank);
+  free(cpus);
+  CPU_FREE(all_cpus);
+  core_rank = NULL;
+  cpus = NULL;
+  all_cpus = NULL;
+}
@@ -0,0 +1,78 @@
+/*
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Copyright (C) 2016, ARM Limited and contributors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ # distributed under the License is distributed on an "AS IS" BASIS,
+ # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ # See the License for the specific language governing permissions and
+ # limitations under the License.
+ *
+ */
+
+#ifndef TOPOLOGY_H_
+#define TOPOLOGY_H_
+
+#include "meabo.h"
+
+/*
+ * CPU topology, read from /sys/devices/system/cpu and /sys/devices/system/node
+ * for the CPUs the phases can run on. Unknown ids (e.g. no NUMA or no
+ * clusters) are -1, unknown capacities 0.
+ */
+typedef struct cpu_info {
+  int package;
+  int cluster;
+  int node;
+  int core;       /* first CPU of the core (SMT siblings share it) */
+  int smt;        /* hardware thread of the CPU within its core */
+  int llc;        /* first CPU sharing the last level cache */
+  long capacity;
+} cpu_info;
+
+/*
+ * Order in which the threads of a phase take the CPUs of its CPU set when
+ * each thread is bound to one CPU (-B 0):
+ * - linear: by CPU number;
+ * - compact: filling each core (SMT siblings), then each last level cache,
+ *   NUMA node and package;
+ * - scatter: one thread per NUMA node (or package) in turn, on a different
+ *   core each time, SMT siblings last.
+ */
+typedef enum placement {
+  PLACEMENT_LINEAR = 0,
+  PLACEMENT_COMPACT,
+  PLACEMENT_SCATTER
+} placement;
+
+void topology_init(const cpu_set_t *cpus, const int max_cpus);
+
+void topology_print(void);
+
+int topology_cpus(const char *name, cpu_set_t *set);
+
+int parse_placement(const char *str, placement *policy);
+
+const char *placement_name(const placement policy);
+
+void topology_set_placement(const placement policy);
+
+int topology_cpu(const cpu_set_t *set, int index);
+
+int topology_nodes(const cpu_set_t *set, unsigned long *nodes,
+                   const int max_nodes);
+
+long topology_cache_size(const cpu_set_t *set, const int num_threads,
+                         const int level);
+
+void topology_free(void);
+
+#endif /* TOPOLOGY_H_ */
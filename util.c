@@ -19,61 +19,247 @@
  */
 
 #include "util.h"
+#include "counters.h"
+#include "topology.h"
 
 /*
- * This function binds a thread to the first available CPU from a set of CPUs. 
- * The print flag is used a control flag for all printf statements.
+ * CPUs on which the phases run (the -1 to -0 CPU sets default to all of
+ * them), and number of CPUs the CPU sets are allocated for.
  */
-void bind_to_available_cpu(int cpu_id, int num_cpus, int print, int skip) {
-  if (!cpu_id && print) {
-    printf("CPU_ID has no CPUs set. Skipping...\n");
-    return;
+static cpu_set_t *all_cpus = NULL;
+static int max_cpus = 0;
+static size_t set_size = 0;
+
+/*
+ * Sets the CPUs on which the phases run: CPUs 0 to num_cpus - 1, or the CPUs
+ * the process is allowed to run on if num_cpus is 0. Returns the number of
+ * CPUs.
+ */
+int init_cpus(int num_cpus) {
+  max_cpus = sysconf(_SC_NPROCESSORS_CONF);
+  if (max_cpus < num_cpus) {
+    max_cpus = num_cpus;
   }
-  cpu_set_t cpu_mask;
-  CPU_ZERO(&cpu_mask);
-  for (int i = 0; i < num_cpus; ++i) {
-    if ((cpu_id & 0x00000001)) {
-      if (!skip) {
-        if (print) {
-          printf("Setting cpu %d\n", i);
-        }
-        CPU_SET(i, &cpu_mask);
-        break;
-      } else {
-        --skip;
+  if (max_cpus < 1) {
+    max_cpus = 1;
+  }
+  for (;;) {
+    set_size = CPU_ALLOC_SIZE(max_cpus);
+    all_cpus = CPU_ALLOC(max_cpus);
+    CPU_ZERO_S(set_size, all_cpus);
+    if (num_cpus > 0) {
+      for (int i = 0; i < num_cpus; ++i) {
+        CPU_SET_S(i, set_size, all_cpus);
       }
+      break;
     }
-    cpu_id >>= 1;
+    if (!sched_getaffinity(0, set_size, all_cpus)) {
+      break;
+    }
+    /* The kernel may support more CPUs than are configured */
+    if (errno != EINVAL) {
+      perror("sched_getaffinity");
+      exit(1);
+    }
+    CPU_FREE(all_cpus);
+    max_cpus *= 2;
   }
+  topology_init(all_cpus, max_cpus);
+  return CPU_COUNT_S(set_size, all_cpus);
+}
 
-  int err = sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);
-  if (err == -1) {
-    perror("sched_setaffinity");
+/* One item of a cpulist: a CPU, a range of CPUs or a topology name. */
+static int parse_cpu_item(const char *item, cpu_set_t *set) {
+  char *end;
+  long first, last;
+  const int err = topology_cpus(item, set);
+  if (err <= 0) {
+    return err;
   }
-  assert(!err);
+  first = last = strtol(item, &end, 10);
+  if (end == item) {
+    return -1;
+  }
+  if (*end == '-') {
+    const char *range = end + 1;
+    last = strtol(range, &end, 10);
+    if (end == range) {
+      return -1;
+    }
+  }
+  if (*end || first < 0 || last < first) {
+    return -1;
+  }
+  if (last >= max_cpus) {
+    printf("CPU %ld does not exist\n", last);
+    return -1;
+  }
+  for (long i = first; i <= last; ++i) {
+    CPU_SET_S(i, set_size, set);
+  }
+  return 0;
 }
 
 /*
- * This function binds a thread to a set of CPUs. The print flag is used as a
- * control flag for all printf statements.
+ * Parses a CPU set (see init_cpus for the CPUs it can use):
+ * - all or -1: all the CPUs, returned as NULL;
+ * - a Linux cpulist, e.g. 0-15,64-79, whose items can also be topology
+ *   names (see topology_cpus), e.g. node1, big or one-per-core;
+ * - a hexadecimal mask of any width, e.g. 0xff00.
+ * Returns 0, or -1 if the set is invalid or empty.
  */
-void bind_to_cpu(int cpu_id, int num_cpus, int print) {
-  if (!cpu_id && print) {
-    printf("CPU_ID has no CPUs set. Skipping...\n");
-    return;
+int parse_cpu_list(const char *str, cpu_set_t **set) {
+  *set = NULL;
+  if (!strcmp(str, "all") || !strcmp(str, "-1")) {
+    return 0;
   }
-  cpu_set_t cpu_mask;
-  CPU_ZERO(&cpu_mask);
-  for (int i = 0; i < num_cpus; ++i) {
-    if (cpu_id & 0x00000001) {
-      if (print) {
-        printf("Setting cpu %d\n", i);
+  *set = CPU_ALLOC(max_cpus);
+  CPU_ZERO_S(set_size, *set);
+  if (!strncmp(str, "0x", 2) || !strncmp(str, "0X", 2)) {
+    const int digits = strlen(str) - 2;
+    for (int d = 0; d < digits; ++d) {
+      const char c = str[digits + 1 - d];
+      const int nibble = (c >= '0' && c <= '9') ? c - '0' :
+                         (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                         (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+      if (nibble < 0) {
+        goto error;
       }
-      CPU_SET(i, &cpu_mask);
+      for (int b = 0; b < 4; ++b) {
+        if (!(nibble & (1 << b))) {
+          continue;
+        }
+        if (4 * d + b >= max_cpus) {
+          printf("CPU %d does not exist\n", 4 * d + b);
+          goto error;
+        }
+        CPU_SET_S(4 * d + b, set_size, *set);
+      }
+    }
+  } else {
+    char *list = strdup(str), *saveptr;
+    char *item = strtok_r(list, ",", &saveptr);
+    for (; item; item = strtok_r(NULL, ",", &saveptr)) {
+      if (parse_cpu_item(item, *set)) {
+        free(list);
+        goto error;
+      }
+    }
+    free(list);
+  }
+  if (CPU_COUNT_S(set_size, *set)) {
+    return 0;
+  }
+
+error:
+  printf("Invalid CPU set %s\n", str);
+  CPU_FREE(*set);
+  *set = NULL;
+  return -1;
+}
+
+/* Writes the CPU set as a cpulist ("all" for NULL). */
+void format_cpu_list(const cpu_set_t *set, char *str, size_t size) {
+  int len = 0;
+  if (!set) {
+    snprintf(str, size, "all");
+    return;
+  }
+  str[0] = 0;
+  for (int i = 0; i < max_cpus; ++i) {
+    if (!CPU_ISSET_S(i, set_size, set)) {
+      continue;
+    }
+    int last = i;
+    while (last + 1 < max_cpus && CPU_ISSET_S(last + 1, set_size, set)) {
+      ++last;
+    }
+    if (len < (int) size) {
+      len += snprintf(str + len, size - len, (last > i) ? "%s%d-%d" : "%s%d",
+                      len ? "," : "", i, last);
+    }
+    i = last;
+  }
+}
+
+/* Whether two CPU sets share a CPU (NULL is all the CPUs). */
+int cpu_lists_intersect(const cpu_set_t *set1, const cpu_set_t *set2) {
+  for (int i = 0; i < max_cpus; ++i) {
+    if (CPU_ISSET_S(i, set_size, set1 ? set1 : all_cpus) &&
+        CPU_ISSET_S(i, set_size, set2 ? set2 : all_cpus)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Affinity each thread last set, and number of affinity changes. The OpenMP
+ * runtime keeps its threads from one parallel region to the next, so a thread
+ * that is already bound as requested skips the system call and the migration.
+ */
+static __thread cpu_set_t *thread_affinity = NULL;
+static long affinity_changes = 0;
+
+static int set_affinity(const cpu_set_t *set) {
+  if (thread_affinity && CPU_EQUAL_S(set_size, thread_affinity, set)) {
+    return 0;
+  }
+  const int err = sched_setaffinity(0, set_size, set);
+  if (err) {
+    forget_affinity();
+    return err;
+  }
+  if (!thread_affinity) {
+    thread_affinity = CPU_ALLOC(max_cpus);
+  }
+  memcpy(thread_affinity, set, set_size);
+  __atomic_add_fetch(&affinity_changes, 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+/* Forgets the affinity of the calling thread, e.g. before it exits. */
+void forget_affinity(void) {
+  CPU_FREE(thread_affinity);
+  thread_affinity = NULL;
+}
+
+/* Number of times a thread changed its affinity so far. */
+long get_affinity_changes(void) {
+  return __atomic_load_n(&affinity_changes, __ATOMIC_RELAXED);
+}
+
+/*
+ * This function binds a thread to the first available CPU from a set of CPUs,
+ * in the order of the placement policy (see topology_cpu).
+ * The print flag is used a control flag for all printf statements.
+ */
+void bind_to_available_cpu(const cpu_set_t *cpu_id, int num_cpus, int print,
+                           int skip) {
+  const int cpu = topology_cpu(cpu_id, skip);
+  if (cpu >= 0) {
+    if (print) {
+      printf("Setting cpu %d\n", cpu);
     }
-    cpu_id >>= 1;
+    bind_to_1_cpu(cpu);
+    return;
+  }
+  if (print) {
+    printf("CPU_ID has no CPUs left. Skipping...\n");
+  }
+}
+
+/*
+ * This function binds a thread to a set of CPUs. The print flag is used as a
+ * control flag for all printf statements.
+ */
+void bind_to_cpu(const cpu_set_t *cpu_id, int num_cpus, int print) {
+  if (print) {
+    char list[1024];
+    format_cpu_list(cpu_id, list, sizeof(list));
+    printf("Setting cpus %s\n", list);
   }
-  int err = sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);
+  int err = set_affinity(cpu_id);
   if (err == -1) {
     perror("sched_setaffinity");
   }
@@ -84,10 +270,11 @@ void bind_to_cpu(int cpu_id, int num_cpus, int print) {
  * This function binds a thread to a particular CPU.
  */
 void bind_to_1_cpu(int cpu_id) {
-  cpu_set_t cpu_mask;
-  CPU_ZERO(&cpu_mask);
-  CPU_SET(cpu_id, &cpu_mask);
-  int err = sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);
+  cpu_set_t *cpu_mask = CPU_ALLOC(max_cpus);
+  CPU_ZERO_S(set_size, cpu_mask);
+  CPU_SET_S(cpu_id, set_size, cpu_mask);
+  int err = set_affinity(cpu_mask);
+  CPU_FREE(cpu_mask);
   assert(!err);
 }
 
@@ -99,12 +286,7 @@ void reset_affinity(int num_cpus, int print) {
   if (print) {
     printf("Reseting affinity...\n");
   }
-  cpu_set_t cpu_mask;
-  CPU_ZERO(&cpu_mask);
-  for (int i = 0; i < num_cpus; ++i) {
-    CPU_SET(i, &cpu_mask);
-  }
-  int err = sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);
+  int err = set_affinity(all_cpus);
     if (err == -1) {
       perror("sched_setaffinity");
     }
@@ -115,9 +297,9 @@ void reset_affinity(int num_cpus, int print) {
  * This functions binds the thread to the first available CPU or all CPUs
  * (reset). The print flag controls whether printf statements are outputted.
  */
-void bind_to_available_cpu_w_reset(int cpu_id, int num_cpus,
+void bind_to_available_cpu_w_reset(const cpu_set_t *cpu_id, int num_cpus,
                                    int print, int skip) {
-  if (cpu_id == -1) {
+  if (!cpu_id) {
     reset_affinity(num_cpus, print);
   } else {
     bind_to_available_cpu(cpu_id, num_cpus, print, skip);
@@ -125,11 +307,11 @@ void bind_to_available_cpu_w_reset(int cpu_id, int num_cpus,
 }
 
 /*
- * This function binds the thread to a set CPU or to all CPUs (reset). 
+ * This function binds a thread to a set CPU or to all CPUs (reset). 
  * The print flag is used to as a control flag for all printf statements.
  */
-void bind_to_cpu_w_reset(int cpu_id, int num_cpus, int print) {
-  if (cpu_id == -1) {
+void bind_to_cpu_w_reset(const cpu_set_t *cpu_id, int num_cpus, int print) {
+  if (!cpu_id) {
     reset_affinity(num_cpus, print);
   } else {
     bind_to_cpu(cpu_id, num_cpus, print);
@@ -153,8 +335,8 @@ char* handle_error (int retval) {
 }
 
 /*
- * PAPI initialisation function.
- * For now, we only support as many events as there are hardware counters.
+ * PAPI initialisation function. The events listed here are counted unless
+ * others are given with -e.
  */
 PAPI_info* init_PAPI(int num_hwcntrs) {
   printf("Init_PAPI start\n");
@@ -163,8 +345,8 @@ PAPI_info* init_PAPI(int num_hwcntrs) {
   int retval = 0, total_events = 0;
   PAPI_info *papi_info;
   papi_info = malloc(sizeof(PAPI_info));
-  papi_info->event_code = calloc(0, sizeof(int) * num_hwcntrs);
-  papi_info->event_code_str = malloc(sizeof(char*) * num_hwcntrs);
+  papi_info->event_code = calloc(COUNTERS_MAX_EVENTS, sizeof(int));
+  papi_info->event_code_str = malloc(sizeof(char*) * COUNTERS_MAX_EVENTS);
   int *event_code = papi_info->event_code;
   char **event_code_str = papi_info->event_code_str;
 
@@ -195,10 +377,6 @@ PAPI_info* init_PAPI(int num_hwcntrs) {
   PAPI_event_name_to_code("perf::LLC-LOADS", &event_code[total_events++]);
   PAPI_event_name_to_code("OFFCORE_REQUESTS:ALL_DATA_RD", &event_code[total_events]);*/
 
-  if (total_events > num_hwcntrs) {
-    total_events = num_hwcntrs;
-  }
- 
   papi_info->total_events = total_events;
   papi_info->num_hwcntrs = num_hwcntrs;
 
@@ -234,45 +412,90 @@ void usage(char *argv[]) {
   printf("%s Meabo v1.0 [options]\n", argv[0]);
   printf("-s Array size\n");
   printf("-l Linked list size\n");
+  printf("-L Linked list layout: sequential, strided[:stride] or shuffled, "
+         "optionally followed by ,huge\n");
   printf("-r Number of rows\n");
   printf("-c Number of columns\n");
+  printf("-G Sparse matrix generator: random, banded[:width], "
+         "powerlaw[:alpha], stencil2d, stencil3d or blockdiag[:block]\n");
+  printf("-M Read the sparse matrix from a Matrix Market (.mtx) file\n");
+  printf("-F Sparse matrix format: csr, sell[:C[:sigma]] or bell[:B]\n");
   printf("-i Number of iterations\n");  
   printf("-p Number of particles\n");
+  printf("-N Phase 8 mode: neighbour, allpairs or cells[:cutoff]\n");
   printf("-x Number of palindromes\n");
-  printf("-R Number of random locations\n");
+  printf("-Y Phase 9 mode: constructive or bruteforce\n");
+  printf("-R Number of random locations (rounded up to a power of two)\n");
+  printf("-U Random location updates: atomic[:batch] or racy[:batch]\n");
   printf("-b Block size\n");
-  printf("-C Number of CPUs\n");
-  printf("-1 Phase1 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-2 Phase2 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-3 Phase3 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-4 Phase4 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-5 Phase5 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-6 Phase6 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-7 Phase7 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-8 Phase8 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-9 Phase9 CPU affinity. -1 is reset. 0 has no effect.\n");
-  printf("-0 Phase10 CPU affinity. -1 is reset. 0 has no effect.\n");
+  printf("-V Vector ISA for phases 1, 4 and 8: auto, generic, sse2, avx2, "
+         "avx512, neon or sve\n");
+  printf("-C Number of CPUs (default: the CPUs of the process)\n");
+  printf("-1 Phase1 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-2 Phase2 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-3 Phase3 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-4 Phase4 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-5 Phase5 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-6 Phase6 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-7 Phase7 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-8 Phase8 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-9 Phase9 CPU affinity: all, a cpulist or a hex mask\n");
+  printf("-0 Phase10 CPU affinity: all, a cpulist or a hex mask\n");
+#if ENABLE_COUNTERS
   printf("-H Number of hardware counters (including the cycle counter)\n");
+  printf("-e Events to count, separated by commas, or @<file>\n");
+  printf("-m Events that do not fit in the counters: multiplex or repeat\n");
+#endif
   printf("-P Phases to run\n");
+  printf("-S Run script: steps \"phase <n> [iterations=N] [threads=N] "
+         "[cpus=<cpulist>] [repeat=N] [size=N]\" or \"idle <seconds>\"; "
+         "the phases between \"corun [repeat=N]\" and \"end\" are "
+         "co-scheduled\n");
+  printf("-t Target duration in seconds of all phases, or of one with "
+         "<phase>=, instead of the iterations\n");
+  printf("-n Runs of each phase, optionally followed by :<%%> to stop once "
+         "the 95%% confidence interval of the mean is within <%%>\n");
+  printf("-W Untimed warm-up runs of each phase\n");
+  printf("-w Working-set sweep: <phase>[:<min size>[:<max size>"
+         "[:<ms per size>]]]\n");
+  printf("-j Phase 7 latency ladder: <min bytes>:<max bytes>[:<stride>"
+         "[:<chains>]], with K, M or G sizes\n");
   printf("-T Total number of threads to run\n");
   printf("-B Bind to  cpu set versus specific cpu within cpu set.\n");
+  printf("-A Thread placement within a cpu set (-B 0): linear, compact or "
+         "scatter\n");
+  printf("-D Memory placement of the data of all phases, or of one with "
+         "<phase>=: first-touch, local, bind:<nodes> or "
+         "interleave[:<nodes>]\n");
+  printf("-Z Pages of the data of all phases, or of one with <phase>=: "
+         "default, base, thp, 2m or 1g\n");
+#if ENABLE_ENERGY
+  printf("-E Energy source: none, auto, rapl, hwmon or replay:<file>, "
+         "optionally followed by @<samples per second>\n");
+#endif
+  printf("-k Roofline peaks: measure or <GB/s>:<GFLOP/s>\n");
+  printf("-o Results file (JSON Lines, or CSV if it ends with .csv)\n");
   printf("-h This menu\n");
 }
 
 /*
- * This function prints compiler information (compiler with which the code 
- * was built and compiler flags.
+ * Reads the ASCII column of the dump of an ELF section of the executable, as
+ * printed by objdump -s, into output.
  */
-void print_compiler_information(char * exec_name) {
+static void read_section(const char *exec_name, const char *section,
+                         char *output, size_t size) {
     char cmd[256] = "";
-    snprintf(cmd, sizeof(cmd), "objdump -s --section .comment %s", exec_name);
+    snprintf(cmd, sizeof(cmd), "objdump -s --section %s %s", section,
+             exec_name);
+    output[0] = 0;
 
     FILE *cmd_pipe = popen(cmd, "r");
     if (cmd_pipe == NULL) {
       printf("Unable to open pipe\n");
+      return;
     }
 
-    char line[64], output[1024*16];
+    char line[64];
     char *tmp;
     int start_string = 0;
     while (fgets(line, 64, cmd_pipe) != NULL) {
@@ -283,57 +506,57 @@ void print_compiler_information(char * exec_name) {
           continue;
         }
       }
+      if (strlen(line) <= 43) {
+        continue;
+      }
       tmp = (char*) (&(line[0]))+43;
       tmp[strlen(tmp)-1] = 0;
-      strcat(output, tmp);
+      strncat(output, tmp, size - strlen(output) - 1);
     }
-    fclose(cmd_pipe);
-    printf("Binary built with %s\n", output);
-
-    cmd[0] = 0;
-    output[0] = 0;
+    pclose(cmd_pipe);
 
-    snprintf(cmd, sizeof(cmd), "objdump -s --section .GCC.command.line %s", exec_name);
-    cmd_pipe = popen(cmd, "r");
-    if (cmd_pipe == NULL) {
-      printf("Unable to open pipe\n");
+    /* Trailing NUL bytes are dumped as dots */
+    size_t len = strlen(output);
+    while (len && (output[len - 1] == '.' || output[len - 1] == ' ')) {
+      output[--len] = 0;
     }
+}
+
+/*
+ * This function gets the compiler with which the code was built and the
+ * compiler flags -- works only with GCC.
+ */
+void compiler_information(char *exec_name, char *compiler,
+                          size_t compiler_size, char *flags,
+                          size_t flags_size) {
+  read_section(exec_name, ".comment", compiler, compiler_size);
+  read_section(exec_name, ".GCC.command.line", flags, flags_size);
+}
 
-    start_string = 0;
-     while (fgets(line, 64, cmd_pipe) != NULL) {
-       if (!start_string) {
-           if (strstr(line, "0000") != NULL) {
-           start_string = 1;
-         } else {
-           continue;
-         }
-       }
-       tmp = (char*) (&(line[0]))+43;
-       tmp[strlen(tmp)-1] = 0;
-       strcat(output, tmp);
-     }
-     fclose(cmd_pipe);
-     printf("Binary built with %s\n", output);
+/*
+ * This function prints compiler information (compiler with which the code 
+ * was built and compiler flags.
+ */
+void print_compiler_information(char * exec_name) {
+    char compiler[1024], flags[1024*16];
+    compiler_information(exec_name, compiler, sizeof(compiler), flags,
+                         sizeof(flags));
+    printf("Binary built with %s\n", compiler);
+    printf("Binary built with %s\n", flags);
 }
 
 /*
  * This function calculates how many threads the phase will be using.
  * For more information, see the explanation from meabo.c on num_threads.
  */
-int get_num_threads(int phase_cpu_id, int num_cpus, int orig_num_threads) {
+int get_num_threads(const cpu_set_t *phase_cpu_id, int num_cpus,
+                    int orig_num_threads) {
   if (orig_num_threads) {
     return orig_num_threads;
   }
-  if (phase_cpu_id == -1) {
+  if (!phase_cpu_id) {
     return num_cpus;
   } else {
-    int num_threads = 0;
-    while (phase_cpu_id != 0) {
-      if (phase_cpu_id & 1) {
-        ++num_threads;
-      }
-      phase_cpu_id >>= 1;
-    }
-    return num_threads;
+    return CPU_COUNT_S(set_size, phase_cpu_id);
   }
 }
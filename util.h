@@ -25,18 +25,31 @@
 
 #define NANOS 1000000000LL
 
-void bind_to_available_cpu(int cpu_id, int num_cpus, int print, int skip);
+int init_cpus(int num_cpus);
 
-void bind_to_cpu(int cpu_id, int num_cpus, int print);
+int parse_cpu_list(const char *str, cpu_set_t **set);
+
+void format_cpu_list(const cpu_set_t *set, char *str, size_t size);
+
+int cpu_lists_intersect(const cpu_set_t *set1, const cpu_set_t *set2);
+
+void bind_to_available_cpu(const cpu_set_t *cpu_id, int num_cpus, int print,
+                           int skip);
+
+void bind_to_cpu(const cpu_set_t *cpu_id, int num_cpus, int print);
 
 void bind_to_1_cpu(int cpu_id);
 
 void reset_affinity(int num_cpus, int print);
 
-void bind_to_available_cpu_w_reset(int cpu_id, int num_cpus,
+void forget_affinity(void);
+
+long get_affinity_changes(void);
+
+void bind_to_available_cpu_w_reset(const cpu_set_t *cpu_id, int num_cpus,
                                    int print, int skip);
 
-void bind_to_cpu_w_reset(int cpu_id, int num_cpus, int print);
+void bind_to_cpu_w_reset(const cpu_set_t *cpu_id, int num_cpus, int print);
 
 unsigned long long duration(struct timespec t1, struct timespec t2);
 
@@ -50,6 +63,11 @@ void usage(char *argv[]);
 
 void print_compiler_information(char * exec_name);
 
-int get_num_threads(int phase_cpu_id, int num_cpus, int orig_num_threads);
+void compiler_information(char *exec_name, char *compiler,
+                          size_t compiler_size, char *flags,
+                          size_t flags_size);
+
+int get_num_threads(const cpu_set_t *phase_cpu_id, int num_cpus,
+                    int orig_num_threads);
 
 #endif /* UTIL_H_ */
@@ -51,7 +51,7 @@ void phase1_compute_wrapper(int phase, time_t rawtime, va_list args) {
   int validation_phase = va_arg(args, int);
   int num_threads = va_arg(args, int);
   int num_cpus = va_arg(args, int);
-  int phase1_cpu_id = va_arg(args, int);
+  const cpu_set_t *phase1_cpu_id = va_arg(args, const cpu_set_t *);
   int bind_to_cpu_set = va_arg(args, int);
 #if RED_VALIDATION
   double *valid_red_vals = va_arg(args, double*);
@@ -66,9 +66,6 @@ void phase1_compute_wrapper(int phase, time_t rawtime, va_list args) {
 #if ENABLE_BINDING
       , num_cpus, phase1_cpu_id, bind_to_cpu_set
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , NULL
-#endif
 #if RED_VALIDATION
       , valid_red_vals, valid_red_int_vals
 #endif
@@ -89,7 +86,7 @@ void phase2_compute_wrapper(int phase, time_t rawtime, va_list args) {
   int validation_phase = va_arg(args, int);
   int num_threads = va_arg(args, int);
   int num_cpus = va_arg(args, int);
-  int phase2_cpu_id = va_arg(args, int);
+  const cpu_set_t *phase2_cpu_id = va_arg(args, const cpu_set_t *);
   int bind_to_cpu_set = va_arg(args, int);
 #if RED_VALIDATION
   double *valid_red_vals = va_arg(args, double*);
@@ -101,9 +98,6 @@ void phase2_compute_wrapper(int phase, time_t rawtime, va_list args) {
 #if ENABLE_BINDING
     , num_cpus, phase2_cpu_id, bind_to_cpu_set
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , NULL
-#endif
 #if RED_VALIDATION
     , valid_red_vals
 #endif
@@ -120,7 +114,7 @@ void phase3_compute_wrapper(int phase, time_t rawtime, va_list args) {
   int validation_phase = va_arg(args, int);
   int num_threads = va_arg(args, int);
   int num_cpus = va_arg(args, int);
-  int phase3_cpu_id = va_arg(args, int);
+  const cpu_set_t *phase3_cpu_id = va_arg(args, const cpu_set_t *);
   int bind_to_cpu_set = va_arg(args, int);
 #if RED_VALIDATION
   double valid_red_reduction_var = va_arg(args, double);
@@ -132,9 +126,6 @@ void phase3_compute_wrapper(int phase, time_t rawtime, va_list args) {
 #if ENABLE_BINDING
     , num_cpus, phase3_cpu_id, bind_to_cpu_set
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , NULL
-#endif
 #if RED_VALIDATION
     , &valid_red_reduction_var
 #endif
@@ -153,7 +144,7 @@ void phase4_compute_wrapper(int phase, time_t rawtime, va_list args) {
   int validation_phase = va_arg(args, int);
   int num_threads = va_arg(args, int);
   int num_cpus = va_arg(args, int);
-  int phase4_cpu_id = va_arg(args, int);
+  const cpu_set_t *phase4_cpu_id = va_arg(args, const cpu_set_t *);
   int bind_to_cpu_set = va_arg(args, int);
 #if RED_VALIDATION
   double *valid_red_vals = va_arg(args, double*);
@@ -164,9 +155,6 @@ void phase4_compute_wrapper(int phase, time_t rawtime, va_list args) {
       valid_src2, validation_phase, num_threads
 #if ENABLE_BINDING
       , num_cpus, phase4_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , NULL
 #endif
   #if RED_VALIDATION
       , valid_red_vals
@@ -187,7 +175,7 @@ void phase5_compute_wrapper(int phase, time_t rawtime, va_list args) {
   int validation_phase = va_arg(args, int);
   int num_threads = va_arg(args, int);
   int num_cpus = va_arg(args, int);
-  int phase5_cpu_id = va_arg(args, int);
+  const cpu_set_t *phase5_cpu_id = va_arg(args, const cpu_set_t *);
   int bind_to_cpu_set = va_arg(args, int);
 #if RED_VALIDATION
   double *valid_red_vals = va_arg(args, double*);
@@ -199,9 +187,6 @@ void phase5_compute_wrapper(int phase, time_t rawtime, va_list args) {
       num_threads
 #if ENABLE_BINDING
       , num_cpus, phase5_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , NULL
 #endif
   #if RED_VALIDATION
       , valid_red_vals
@@ -213,17 +198,14 @@ void phase5_compute_wrapper(int phase, time_t rawtime, va_list args) {
 
 void phase6_compute_wrapper(int phase, time_t rawtime, va_list args) {
   int num_iterations = va_arg(args, int);
-  int nrow = va_arg(args, int);
-  double **valid_sparse_matrix_values = va_arg(args, double**);
+  sparse_matrix *matrix = va_arg(args, sparse_matrix*);
   double *valid_vect_in = va_arg(args, double*);
-  int **valid_sparse_matrix_indeces = va_arg(args, int**);
-  int *valid_sparse_matrix_nonzeros = va_arg(args, int*);
   double* valid_vect_out = va_arg(args, double*);
   int validation_phase = va_arg(args, int);
   int num_threads = va_arg(args, int);
 #if ENABLE_BINDING
   int num_cpus = va_arg(args, int);
-  int phase6_cpu_id = va_arg(args, int);
+  const cpu_set_t *phase6_cpu_id = va_arg(args, const cpu_set_t *);
   int bind_to_cpu_set = va_arg(args, int);
 #endif
 #if RED_VALIDATION
@@ -231,22 +213,17 @@ void phase6_compute_wrapper(int phase, time_t rawtime, va_list args) {
 #endif
   double *vect_out = va_arg(args, double*);
 
-  phase6_compute(num_iterations, nrow, valid_sparse_matrix_values,
-      valid_vect_in, valid_sparse_matrix_indeces,
-      valid_sparse_matrix_nonzeros, valid_vect_out, validation_phase,
-      num_threads
+  phase6_compute(num_iterations, matrix, valid_vect_in, valid_vect_out,
+      validation_phase, num_threads
 #if ENABLE_BINDING
       , num_cpus, phase6_cpu_id, bind_to_cpu_set
-#endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , NULL
 #endif
   #if RED_VALIDATION
       , valid_red_vals
   #endif
       );
 
-  validation_array("Full", nrow, vect_out, valid_vect_out, 6, rawtime);
+  validation_array("Full", matrix->nrow, vect_out, valid_vect_out, 6, rawtime);
 }
 
 /* There is no full validation for phase 7. This is here to show that we
@@ -255,67 +232,57 @@ void phase7_compute_wrapper(int phase, time_t rawtime, va_list args);*/
 
 void phase8_compute_wrapper(int phase, time_t rawtime, va_list args) {
   int num_iterations = va_arg(args, int);
-  int num_particles = va_arg(args, int);
-  particle *particles = va_arg(args, particle*);
+  particle_set *particles = va_arg(args, particle_set*);
+  phase8_spec *spec = va_arg(args, phase8_spec*);
   double *valid_forces = va_arg(args, double*);
   int validation_phase = va_arg(args, int);
   int num_threads = va_arg(args, int);
 #if ENABLE_BINDING
   int num_cpus = va_arg(args, int);
-  int phase8_cpu_id = va_arg(args, int);
+  const cpu_set_t *phase8_cpu_id = va_arg(args, const cpu_set_t *);
   int bind_to_cpu_set = va_arg(args, int);
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  PAPI_info *papi_info = va_arg(args, PAPI_info*);
-#endif
 #if RED_VALIDATION
   double *valid_red_vals = va_arg(args, double*);
 #endif
   double *forces = va_arg(args, double*);
 
-  phase8_compute(num_iterations, num_particles, particles, valid_forces,
+  phase8_compute(num_iterations, particles, spec, valid_forces,
       validation_phase, num_threads
 #if ENABLE_BINDING
       , num_cpus, phase8_cpu_id, bind_to_cpu_set
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , papi_info
-#endif
 #if RED_VALIDATION
       , valid_red_vals
 #endif
       );
 
-  validation_array("Full", num_particles, forces, valid_forces, 8, rawtime);
+  validation_array("Full", particles->num_particles, forces, valid_forces, 8,
+      rawtime);
 }
 
 void phase9_compute_wrapper(int phase, time_t rawtime, va_list args) {
   int num_iterations = va_arg(args, int);
   int num_palindromes = va_arg(args, int);
   unsigned long* restrict valid_palindromes = va_arg(args, unsigned long*);
+  phase9_mode mode = va_arg(args, phase9_mode);
   int validation_phase = va_arg(args, int);
   int num_threads = va_arg(args, int);
 #if ENABLE_BINDING
   int num_cpus = va_arg(args, int);
-  int phase9_cpu_id = va_arg(args, int);
+  const cpu_set_t *phase9_cpu_id = va_arg(args, const cpu_set_t *);
   int bind_to_cpu_set = va_arg(args, int);
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-  PAPI_info *papi_info = va_arg(args, PAPI_info*);
-#endif
 #if RED_VALIDATION
   unsigned long* restrict valid_red_ulong_vals = va_arg(args, unsigned long*);
 #endif
   unsigned long *palindromes = va_arg(args, unsigned long*);
 
-  phase9_compute(num_iterations, num_palindromes, valid_palindromes,
+  phase9_compute(num_iterations, num_palindromes, valid_palindromes, mode,
       validation_phase, num_threads
 #if ENABLE_BINDING
       , num_cpus, phase9_cpu_id, bind_to_cpu_set
 #endif
-#if ENABLE_PAPI && !(RED_VALIDATION || FULL_VALIDATION)
-    , papi_info
-#endif
 #if RED_VALIDATION
       , valid_red_ulong_vals
 #endif
@@ -106,7 +106,7 @@ typedef union udouble {
         phase, ctime(&rawtime)); \
     })
 
-void (*compute_fct)(int time_t, va_list);
+extern void (*compute_fct)(int time_t, va_list);
 
 void full_validation(void (*compute_fct)(int, time_t, va_list), 
     int phase, time_t rawtime, int nr_params, ...);